@@ -1,5 +1,7 @@
 #include "gsl_math.h"
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <vector>
 #include <QDebug>
 #include "matrix4x4.h"
@@ -157,6 +159,116 @@ float distanceToPlane(const Vector3D &point, const Vector3D &normal, const Vecto
     return distance;
 }
 
+namespace
+{
+// Plain float helpers for obbOverlap, the Vector3D operators are not inlined across translation units.
+inline float dot3(const float (&a)[3], const float (&b)[3])
+{
+    return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+}
+
+inline void cross3(const float (&a)[3], const float (&b)[3], float (&result)[3])
+{
+    result[0] = a[1]*b[2] - a[2]*b[1];
+    result[1] = a[2]*b[0] - a[0]*b[2];
+    result[2] = a[0]*b[1] - a[1]*b[0];
+}
+
+/**
+ * Whether the projections of two boxes on axis are apart.
+ * A box projects to its center plus and minus the summed projections of its half edges,
+ * so the corners never have to be projected one by one.
+ */
+inline bool separatedOnAxis(const float (&axis)[3], const float (&centerDistance)[3],
+                            const float (&halfEdgesA)[3][3], const float (&halfEdgesB)[3][3])
+{
+    float radiusA = std::abs(dot3(halfEdgesA[0], axis)) + std::abs(dot3(halfEdgesA[1], axis)) + std::abs(dot3(halfEdgesA[2], axis));
+    float radiusB = std::abs(dot3(halfEdgesB[0], axis)) + std::abs(dot3(halfEdgesB[1], axis)) + std::abs(dot3(halfEdgesB[2], axis));
+    return std::abs(dot3(centerDistance, axis)) > radiusA + radiusB;
+}
+
+/// The half edges of a box in the corner order of BoundingBox::points_, along its local x, y and z axis.
+inline void halfEdges(const std::array<Vector3D, 8> &box, float (&result)[3][3])
+{
+    const Vector3D &corner = box[0];
+    const Vector3D *ends[3] = {&box[2], &box[4], &box[1]};
+    for (int i = 0; i < 3; i++)
+    {
+        result[i][0] = (corner.x - ends[i]->x) * 0.5f;
+        result[i][1] = (corner.y - ends[i]->y) * 0.5f;
+        result[i][2] = (corner.z - ends[i]->z) * 0.5f;
+    }
+}
+}
+
+bool obbOverlap(const std::array<Vector3D, 8> &a, const std::array<Vector3D, 8> &b)
+{
+    float halfEdgesA[3][3], halfEdgesB[3][3];
+    halfEdges(a, halfEdgesA);
+    halfEdges(b, halfEdgesB);
+    // corners 0 and 7 are opposite, so the centers are their midpoints
+    const float centerDistance[3] = {(b[0].x + b[7].x - a[0].x - a[7].x) * 0.5f,
+                                     (b[0].y + b[7].y - a[0].y - a[7].y) * 0.5f,
+                                     (b[0].z + b[7].z - a[0].z - a[7].z) * 0.5f};
+
+    // face normals, the cross products of the other two edges so sheared boxes are handled too
+    float axis[3];
+    for (int i = 0; i < 3; i++)
+    {
+        cross3(halfEdgesA[(i + 1) % 3], halfEdgesA[(i + 2) % 3], axis);
+        if (separatedOnAxis(axis, centerDistance, halfEdgesA, halfEdgesB))
+            return false;
+        cross3(halfEdgesB[(i + 1) % 3], halfEdgesB[(i + 2) % 3], axis);
+        if (separatedOnAxis(axis, centerDistance, halfEdgesA, halfEdgesB))
+            return false;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            cross3(halfEdgesA[i], halfEdgesB[j], axis);
+            // |a x b|^2 = |a|^2 |b|^2 sin^2, near parallel edges give no usable axis and are covered by the face normals
+            if (dot3(axis, axis) <= 1e-6f * dot3(halfEdgesA[i], halfEdgesA[i]) * dot3(halfEdgesB[j], halfEdgesB[j]))
+                continue;
+            if (separatedOnAxis(axis, centerDistance, halfEdgesA, halfEdgesB))
+                return false;
+        }
+    }
+    return true;
+}
+
+bool rayIntersectsAABB(const Vector3D &origin, const Vector3D &direction, const Vector3D &min, const Vector3D &max, float &distance)
+{
+    float enterDistance = -HUGE_VALF;
+    float exitDistance = HUGE_VALF;
+    const float origins[3] = {origin.x, origin.y, origin.z};
+    const float directions[3] = {direction.x, direction.y, direction.z};
+    const float mins[3] = {min.x, min.y, min.z};
+    const float maxs[3] = {max.x, max.y, max.z};
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        if (directions[axis] == 0.f)
+        {
+            // parallel to the slab, misses unless it starts between the planes
+            if (origins[axis] < mins[axis] || origins[axis] > maxs[axis])
+                return false;
+            continue;
+        }
+        float inverse = 1.f / directions[axis];
+        float t1 = (mins[axis] - origins[axis]) * inverse;
+        float t2 = (maxs[axis] - origins[axis]) * inverse;
+        enterDistance = std::max(enterDistance, std::min(t1, t2));
+        exitDistance = std::min(exitDistance, std::max(t1, t2));
+    }
+
+    if (enterDistance > exitDistance || exitDistance < 0.f)
+        return false;
+    distance = enterDistance >= 0.f ? enterDistance : exitDistance;
+    return true;
+}
+
 bool withinPlane(const Vector3D &point, Matrix4x4 &modelMatrix, Vector2D upright, Vector2D downleft)
 {
     Matrix4x4 inversed = modelMatrix;
@@ -217,7 +329,7 @@ std::vector<Vector3D> ProjectPointsOnVector(std::vector<Vector3D> points, Vector
     return points;
 }
 
-std::pair<float, float> findMinAndMaxInX(std::vector<Vector3D> points)
+std::pair<float, float> findMinAndMaxInX(const std::vector<Vector3D> &points)
 {
     float max = float(-HUGE);
     float min = float(HUGE);
@@ -231,7 +343,7 @@ std::pair<float, float> findMinAndMaxInX(std::vector<Vector3D> points)
     return std::make_pair(min,max);
 }
 
-std::pair<float, float> findMinAndMaxInY(std::vector<Vector3D> points)
+std::pair<float, float> findMinAndMaxInY(const std::vector<Vector3D> &points)
 {
     float max = float(-HUGE);
     float min = float(HUGE);
@@ -245,7 +357,7 @@ std::pair<float, float> findMinAndMaxInY(std::vector<Vector3D> points)
     return std::make_pair(min,max);
 }
 
-std::pair<float, float> findMinAndMaxInZ(std::vector<Vector3D> points)
+std::pair<float, float> findMinAndMaxInZ(const std::vector<Vector3D> &points)
 {
     float max = float(-HUGE);
     float min = float(HUGE);
@@ -7,6 +7,7 @@
 #include "math_constants.h"
 #include "Legacy/gltypes.h"
 #include "matrix3x3.h"
+#include <array>
 #include <vector>
 
 namespace gsl
@@ -30,19 +31,19 @@ std::vector<gsl::Vector3D> ProjectPointsOnVector(std::vector<gsl::Vector3D> poin
  * @param points The vector specified.
  * @return the min and max value, in a std::pair<min,max>.
  */
-std::pair<float,float> findMinAndMaxInX(std::vector<gsl::Vector3D> points);
+std::pair<float,float> findMinAndMaxInX(const std::vector<gsl::Vector3D> &points);
 /**
  * Finds the max and min value of all vectors given in Y.
  * @param points The vector specified.
  * @return the min and max value, in a std::pair<min,max>.
  */
-std::pair<float,float> findMinAndMaxInY(std::vector<gsl::Vector3D> points);
+std::pair<float,float> findMinAndMaxInY(const std::vector<gsl::Vector3D> &points);
 /**
  * Finds the max and min value of all vectors given in Z.
  * @param points The vector specified.
  * @return the min and max value, in a std::pair<min,max>.
  */
-std::pair<float,float> findMinAndMaxInZ(std::vector<gsl::Vector3D> points);
+std::pair<float,float> findMinAndMaxInZ(const std::vector<gsl::Vector3D> &points);
 /**
  * Gives a random integer.
  * @param min The minimum value the integer can be.
@@ -70,6 +71,27 @@ Vector3D zero();
 
 float distanceToPlane(const Vector3D &point, const Vector3D &normal, const Vector3D &pointInPlane);
 bool withinPlane(const Vector3D &point, Matrix4x4 &modelMatrix, Vector2D upright, Vector2D downleft);
+/**
+ * Checks if two oriented boxes overlap with the separating axis test.
+ * Tests the 3 face normals of each box and the 9 cross products of their edges,
+ * without allocating, so it can run for every candidate pair each tick.
+ * Corners are in the order of BoundingBox::points_, where the edges 0-2, 0-4 and 0-1 run along
+ * the box' local x, y and z axis. The boxes may be sheared, as long as opposite faces are parallel.
+ * @param a Corners of the first box.
+ * @param b Corners of the second box.
+ * @return Whether the boxes overlap or touch.
+ */
+bool obbOverlap(const std::array<Vector3D, 8> &a, const std::array<Vector3D, 8> &b);
+/**
+ * Intersects a ray with an axis aligned box using the slab method.
+ * @param origin Start of the ray.
+ * @param direction Direction of the ray, distance is in multiples of its length.
+ * @param min Lowest corner of the box.
+ * @param max Highest corner of the box.
+ * @param distance Set to the distance along the ray where it enters the box, or leaves it if origin is inside.
+ * @return Whether the ray hits the box in front of origin.
+ */
+bool rayIntersectsAABB(const Vector3D &origin, const Vector3D &direction, const Vector3D &min, const Vector3D &max, float &distance);
 
 Vector3D barycentricCoordinates(const Vector2D &p1, const Vector2D &p2, const Vector2D &p3, const Vector2D playerXZ);
 
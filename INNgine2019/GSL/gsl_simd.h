@@ -0,0 +1,12 @@
+#ifndef GSL_SIMD_H
+#define GSL_SIMD_H
+
+// Selects SIMD code paths at compile time.
+// SSE2 is used when the compiler targets it (always the case on x86-64),
+// define GSL_NO_SIMD to force the scalar fallback, e.g. when comparing results or on other architectures.
+#if !defined(GSL_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define GSL_USE_SSE
+#include <emmintrin.h>
+#endif
+
+#endif // GSL_SIMD_H
@@ -4,6 +4,7 @@
 #include "gsl_math.h"
 #include "matrix2x2.h"
 #include "matrix3x3.h"
+#include "gsl_simd.h"
 
 #include <cmath>
 #include <cstring> // For memcpy on linux
@@ -12,11 +13,23 @@
 namespace gsl
 {
 
+#ifdef GSL_USE_SSE
+namespace
+{
+/// Reorders the lanes of v, result is (v[x], v[y], v[z], v[w]).
+template<int x, int y, int z, int w>
+inline __m128 shuffle(__m128 v)
+{
+    return _mm_shuffle_ps(v, v, _MM_SHUFFLE(w, z, y, x));
+}
+}
+#endif
+
 Matrix4x4::Matrix4x4(bool isIdentity)
 {
     if(isIdentity)
     {
-        identity();
+        setToIdentity();
     }
     else
     {
@@ -54,6 +67,62 @@ void Matrix4x4::setToIdentity()
 
 bool Matrix4x4::inverse()
 {
+#ifdef GSL_USE_SSE
+    // Cofactors from the 2x2 sub-determinants of the upper (s) and lower (c) two rows.
+    __m128 row0 = _mm_loadu_ps(matrix);
+    __m128 row1 = _mm_loadu_ps(matrix + 4);
+    __m128 row2 = _mm_loadu_ps(matrix + 8);
+    __m128 row3 = _mm_loadu_ps(matrix + 12);
+
+    // s0..s3 and c0..c3 pair the columns (0,1), (0,2), (0,3), (1,2), s4 s5 and c4 c5 pair (1,3), (2,3)
+    __m128 s0123 = _mm_sub_ps(_mm_mul_ps(shuffle<0,0,0,1>(row0), shuffle<1,2,3,2>(row1)),
+                              _mm_mul_ps(shuffle<0,0,0,1>(row1), shuffle<1,2,3,2>(row0)));
+    __m128 s4545 = _mm_sub_ps(_mm_mul_ps(shuffle<1,2,1,2>(row0), shuffle<3,3,3,3>(row1)),
+                              _mm_mul_ps(shuffle<1,2,1,2>(row1), shuffle<3,3,3,3>(row0)));
+    __m128 c0123 = _mm_sub_ps(_mm_mul_ps(shuffle<0,0,0,1>(row2), shuffle<1,2,3,2>(row3)),
+                              _mm_mul_ps(shuffle<0,0,0,1>(row3), shuffle<1,2,3,2>(row2)));
+    __m128 c4545 = _mm_sub_ps(_mm_mul_ps(shuffle<1,2,1,2>(row2), shuffle<3,3,3,3>(row3)),
+                              _mm_mul_ps(shuffle<1,2,1,2>(row3), shuffle<3,3,3,3>(row2)));
+
+    GLfloat s[8], c[8];
+    _mm_storeu_ps(s, s0123);
+    _mm_storeu_ps(s + 4, s4545);
+    _mm_storeu_ps(c, c0123);
+    _mm_storeu_ps(c + 4, c4545);
+
+    GLfloat determinant = s[0]*c[5] - s[1]*c[4] + s[2]*c[3] + s[3]*c[2] - s[4]*c[1] + s[5]*c[0];
+    if (determinant == 0.f)
+        return false;
+
+    // k[i] = (c_i, c_i, s_i, s_i)
+    __m128 k0 = _mm_shuffle_ps(c0123, s0123, _MM_SHUFFLE(0,0,0,0));
+    __m128 k1 = _mm_shuffle_ps(c0123, s0123, _MM_SHUFFLE(1,1,1,1));
+    __m128 k2 = _mm_shuffle_ps(c0123, s0123, _MM_SHUFFLE(2,2,2,2));
+    __m128 k3 = _mm_shuffle_ps(c0123, s0123, _MM_SHUFFLE(3,3,3,3));
+    __m128 k4 = _mm_shuffle_ps(c4545, s4545, _MM_SHUFFLE(0,0,0,0));
+    __m128 k5 = _mm_shuffle_ps(c4545, s4545, _MM_SHUFFLE(1,1,1,1));
+
+    // p[j] = (a1j, -a0j, a3j, -a2j), column j with its rows swapped in pairs and every other sign flipped
+    _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+    const __m128 sign = _mm_setr_ps(1.f, -1.f, 1.f, -1.f);
+    __m128 p0 = _mm_mul_ps(shuffle<1,0,3,2>(row0), sign);
+    __m128 p1 = _mm_mul_ps(shuffle<1,0,3,2>(row1), sign);
+    __m128 p2 = _mm_mul_ps(shuffle<1,0,3,2>(row2), sign);
+    __m128 p3 = _mm_mul_ps(shuffle<1,0,3,2>(row3), sign);
+
+    __m128 inverseDeterminant = _mm_set1_ps(1.f / determinant);
+    __m128 inv0 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(p1, k5), _mm_mul_ps(p2, k4)), _mm_mul_ps(p3, k3));
+    __m128 inv1 = _mm_sub_ps(_mm_sub_ps(_mm_mul_ps(p2, k2), _mm_mul_ps(p0, k5)), _mm_mul_ps(p3, k1));
+    __m128 inv2 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(p0, k4), _mm_mul_ps(p1, k2)), _mm_mul_ps(p3, k0));
+    __m128 inv3 = _mm_sub_ps(_mm_sub_ps(_mm_mul_ps(p1, k1), _mm_mul_ps(p0, k3)), _mm_mul_ps(p2, k0));
+
+    _mm_storeu_ps(matrix, _mm_mul_ps(inv0, inverseDeterminant));
+    _mm_storeu_ps(matrix + 4, _mm_mul_ps(inv1, inverseDeterminant));
+    _mm_storeu_ps(matrix + 8, _mm_mul_ps(inv2, inverseDeterminant));
+    _mm_storeu_ps(matrix + 12, _mm_mul_ps(inv3, inverseDeterminant));
+
+    return true;
+#else
     GLfloat inv[16];
     GLfloat determinant;
     GLfloat invOut[16];
@@ -185,142 +254,15 @@ bool Matrix4x4::inverse()
     memcpy(matrix, invOut, 16*sizeof(GLfloat));
 
     return true;
+#endif
 }
 
 Matrix4x4 Matrix4x4::inversed()
 {
-    GLfloat inv[16], det;
-    GLfloat invOut[16];
-
-    int i;
-
-    inv[0] = matrix[5]  * matrix[10] * matrix[15] -
-            matrix[5]  * matrix[11] * matrix[14] -
-            matrix[9]  * matrix[6]  * matrix[15] +
-            matrix[9]  * matrix[7]  * matrix[14] +
-            matrix[13] * matrix[6]  * matrix[11] -
-            matrix[13] * matrix[7]  * matrix[10];
-
-    inv[4] = -matrix[4]  * matrix[10] * matrix[15] +
-            matrix[4]  * matrix[11] * matrix[14] +
-            matrix[8]  * matrix[6]  * matrix[15] -
-            matrix[8]  * matrix[7]  * matrix[14] -
-            matrix[12] * matrix[6]  * matrix[11] +
-            matrix[12] * matrix[7]  * matrix[10];
-
-    inv[8] = matrix[4]  * matrix[9] * matrix[15] -
-            matrix[4]  * matrix[11] * matrix[13] -
-            matrix[8]  * matrix[5] * matrix[15] +
-            matrix[8]  * matrix[7] * matrix[13] +
-            matrix[12] * matrix[5] * matrix[11] -
-            matrix[12] * matrix[7] * matrix[9];
-
-    inv[12] = -matrix[4]  * matrix[9] * matrix[14] +
-            matrix[4]  * matrix[10] * matrix[13] +
-            matrix[8]  * matrix[5] * matrix[14] -
-            matrix[8]  * matrix[6] * matrix[13] -
-            matrix[12] * matrix[5] * matrix[10] +
-            matrix[12] * matrix[6] * matrix[9];
-
-    inv[1] = -matrix[1]  * matrix[10] * matrix[15] +
-            matrix[1]  * matrix[11] * matrix[14] +
-            matrix[9]  * matrix[2] * matrix[15] -
-            matrix[9]  * matrix[3] * matrix[14] -
-            matrix[13] * matrix[2] * matrix[11] +
-            matrix[13] * matrix[3] * matrix[10];
-
-    inv[5] = matrix[0]  * matrix[10] * matrix[15] -
-            matrix[0]  * matrix[11] * matrix[14] -
-            matrix[8]  * matrix[2] * matrix[15] +
-            matrix[8]  * matrix[3] * matrix[14] +
-            matrix[12] * matrix[2] * matrix[11] -
-            matrix[12] * matrix[3] * matrix[10];
-
-    inv[9] = -matrix[0]  * matrix[9] * matrix[15] +
-            matrix[0]  * matrix[11] * matrix[13] +
-            matrix[8]  * matrix[1] * matrix[15] -
-            matrix[8]  * matrix[3] * matrix[13] -
-            matrix[12] * matrix[1] * matrix[11] +
-            matrix[12] * matrix[3] * matrix[9];
-
-    inv[13] = matrix[0]  * matrix[9] * matrix[14] -
-            matrix[0]  * matrix[10] * matrix[13] -
-            matrix[8]  * matrix[1] * matrix[14] +
-            matrix[8]  * matrix[2] * matrix[13] +
-            matrix[12] * matrix[1] * matrix[10] -
-            matrix[12] * matrix[2] * matrix[9];
-
-    inv[2] = matrix[1]  * matrix[6] * matrix[15] -
-            matrix[1]  * matrix[7] * matrix[14] -
-            matrix[5]  * matrix[2] * matrix[15] +
-            matrix[5]  * matrix[3] * matrix[14] +
-            matrix[13] * matrix[2] * matrix[7] -
-            matrix[13] * matrix[3] * matrix[6];
-
-    inv[6] = -matrix[0]  * matrix[6] * matrix[15] +
-            matrix[0]  * matrix[7] * matrix[14] +
-            matrix[4]  * matrix[2] * matrix[15] -
-            matrix[4]  * matrix[3] * matrix[14] -
-            matrix[12] * matrix[2] * matrix[7] +
-            matrix[12] * matrix[3] * matrix[6];
-
-    inv[10] = matrix[0]  * matrix[5] * matrix[15] -
-            matrix[0]  * matrix[7] * matrix[13] -
-            matrix[4]  * matrix[1] * matrix[15] +
-            matrix[4]  * matrix[3] * matrix[13] +
-            matrix[12] * matrix[1] * matrix[7] -
-            matrix[12] * matrix[3] * matrix[5];
-
-    inv[14] = -matrix[0]  * matrix[5] * matrix[14] +
-            matrix[0]  * matrix[6] * matrix[13] +
-            matrix[4]  * matrix[1] * matrix[14] -
-            matrix[4]  * matrix[2] * matrix[13] -
-            matrix[12] * matrix[1] * matrix[6] +
-            matrix[12] * matrix[2] * matrix[5];
-
-    inv[3] = -matrix[1] * matrix[6] * matrix[11] +
-            matrix[1] * matrix[7] * matrix[10] +
-            matrix[5] * matrix[2] * matrix[11] -
-            matrix[5] * matrix[3] * matrix[10] -
-            matrix[9] * matrix[2] * matrix[7] +
-            matrix[9] * matrix[3] * matrix[6];
-
-    inv[7] = matrix[0] * matrix[6] * matrix[11] -
-            matrix[0] * matrix[7] * matrix[10] -
-            matrix[4] * matrix[2] * matrix[11] +
-            matrix[4] * matrix[3] * matrix[10] +
-            matrix[8] * matrix[2] * matrix[7] -
-            matrix[8] * matrix[3] * matrix[6];
-
-    inv[11] = -matrix[0] * matrix[5] * matrix[11] +
-            matrix[0] * matrix[7] * matrix[9] +
-            matrix[4] * matrix[1] * matrix[11] -
-            matrix[4] * matrix[3] * matrix[9] -
-            matrix[8] * matrix[1] * matrix[7] +
-            matrix[8] * matrix[3] * matrix[5];
-
-    inv[15] = matrix[0] * matrix[5] * matrix[10] -
-            matrix[0] * matrix[6] * matrix[9] -
-            matrix[4] * matrix[1] * matrix[10] +
-            matrix[4] * matrix[2] * matrix[9] +
-            matrix[8] * matrix[1] * matrix[6] -
-            matrix[8] * matrix[2] * matrix[5];
-
-    det = matrix[0] * inv[0] + matrix[1] * inv[4] + matrix[2] * inv[8] + matrix[3] * inv[12];
-
-    if (det == 0.f)
-        return Matrix4x4{0};
-
-    det = 1.f / det;
-
-    for (i = 0; i < 16; i++)
-        invOut[i] = inv[i] * det;
-
-    return Matrix4x4{invOut};
-
-    //    memcpy(matrix, invOut, 16*sizeof(GLfloat));
-
-    //    return true;
+    Matrix4x4 temp = *this;
+    if (!temp.inverse())
+        return Matrix4x4();
+    return temp;
 }
 
 
@@ -404,15 +346,14 @@ void Matrix4x4::rotateZ(GLfloat degrees)
 
 void Matrix4x4::rotQuat(float x, float y, float z, float w)
 {
-    Matrix4x4 mat
-    {
-        static_cast<GLfloat>(1.0 - (2.0*y*y) - (2.0*z*z)),    static_cast<GLfloat>((2.0*x*y) - (2.0*z*w)),     static_cast<GLfloat>((2.0*x*z) + (2.0*y*w)),    0.f,
-                static_cast<GLfloat>((2.0*x*y) + (2.0*z*w)),    static_cast<GLfloat>(1.0 - (2.0*x*x) - (2.0*z*z)),    static_cast<GLfloat>((2.0*y*z) - (2.0*x*w)),    0.f,
-                static_cast<GLfloat>((2.0*x*z) - (2.0*y*w)),    static_cast<GLfloat>((2.0*y*z) + (2.0*x*w)),    static_cast<GLfloat>(1.0 - (2.0*x*x) - (2.0*y*y)),    0.f,
-                0.f,                                            0.f,                                                    0.f,                            1.f
-    };
-    *this = mat;
+    GLfloat xx = 2.f*x*x, yy = 2.f*y*y, zz = 2.f*z*z;
+    GLfloat xy = 2.f*x*y, xz = 2.f*x*z, yz = 2.f*y*z;
+    GLfloat xw = 2.f*x*w, yw = 2.f*y*w, zw = 2.f*z*w;
 
+    matrix[0] = 1.f - yy - zz;  matrix[1] = xy - zw;        matrix[2] = xz + yw;        matrix[3] = 0.f;
+    matrix[4] = xy + zw;        matrix[5] = 1.f - xx - zz;  matrix[6] = yz - xw;        matrix[7] = 0.f;
+    matrix[8] = xz - yw;        matrix[9] = yz + xw;        matrix[10] = 1.f - xx - yy; matrix[11] = 0.f;
+    matrix[12] = 0.f;           matrix[13] = 0.f;           matrix[14] = 0.f;           matrix[15] = 1.f;
 }
 
 // Rotate around a given vector
@@ -444,15 +385,13 @@ void Matrix4x4::scale(GLfloat uniformScale)
 
 void Matrix4x4::scale(GLfloat scaleX, GLfloat scaleY, GLfloat scaleZ)
 {
-    Matrix4x4 temp =
+    // Same as multiplying with a scale matrix, which only scales the first three columns.
+    for (int row = 0; row < 16; row += 4)
     {
-        scaleX,  0.f,    0.f,   0.f,
-        0.f,   scaleY,  0.f,   0.f,
-        0.f,    0.f,   scaleZ, 0.f,
-        0.f,    0.f,    0.f,   1.f
-    };
-
-    *this = (*this)*temp;
+        matrix[row] *= scaleX;
+        matrix[row + 1] *= scaleY;
+        matrix[row + 2] *= scaleZ;
+    }
 }
 
 
@@ -461,6 +400,11 @@ GLfloat *Matrix4x4::constData()
     return &matrix[0];
 }
 
+const GLfloat *Matrix4x4::constData() const
+{
+    return &matrix[0];
+}
+
 void Matrix4x4::transpose()
 {
     std::swap(matrix[1], matrix[4]);
@@ -571,28 +515,14 @@ void Matrix4x4::setRotationToVector(const Vector3D &direction, Vector3D up)
 
 void Matrix4x4::translate(GLfloat x, GLfloat y, GLfloat z)
 {
-    Matrix4x4 mat =
-    {
-        1.f, 0.f, 0.f, x,
-        0.f, 1.f, 0.f, y,
-        0.f, 0.f, 1.f, z,
-        0.f, 0.f, 0.f, 1.f
-    };
-
-    *this = (*this)*mat;
+    // Same as multiplying with a translation matrix, which only changes the last column.
+    for (int row = 0; row < 16; row += 4)
+        matrix[row + 3] += matrix[row]*x + matrix[row + 1]*y + matrix[row + 2]*z;
 }
 
 void Matrix4x4::translate(Vector3D positionIn)
 {
-    Matrix4x4 mat =
-    {
-        1.f, 0.f, 0.f, positionIn.getX(),
-        0.f, 1.f, 0.f, positionIn.getY(),
-        0.f, 0.f, 1.f, positionIn.getZ(),
-        0.f, 0.f, 0.f, 1.f
-    };
-
-    *this = (*this)*mat;
+    translate(positionIn.getX(), positionIn.getY(), positionIn.getZ());
 }
 
 Matrix2x2 Matrix4x4::toMatrix2()
@@ -625,8 +555,9 @@ GLfloat Matrix4x4::operator()(const int &y, const int &x) const
     return matrix[y * 4 + x];
 }
 
-Matrix4x4 Matrix4x4::operator*(const Matrix4x4 &other)
+Matrix4x4 Matrix4x4::operator*(const Matrix4x4 &other) const
 {
+    // Kept scalar, the compiler vectorizes it as well as hand written SSE, see benchmarks/matrix4x4.
     return
     {
         matrix[0]  * other.matrix[0] + matrix[1]  * other.matrix[4] + matrix[2]  * other.matrix[8]  + matrix[3]  * other.matrix[12],
@@ -656,12 +587,26 @@ GLfloat Matrix4x4::getFloat(int space)
     return matrix[space];
 }
 
-Vector4D Matrix4x4::operator*(const Vector4D &v)
+Vector4D Matrix4x4::operator*(const Vector4D &v) const
 {
+#ifdef GSL_USE_SSE
+    // Multiplies every row with v, then transposes so the four dot products can be summed in one go.
+    __m128 vector = _mm_setr_ps(v.getX(), v.getY(), v.getZ(), v.getW());
+    __m128 row0 = _mm_mul_ps(_mm_loadu_ps(matrix), vector);
+    __m128 row1 = _mm_mul_ps(_mm_loadu_ps(matrix + 4), vector);
+    __m128 row2 = _mm_mul_ps(_mm_loadu_ps(matrix + 8), vector);
+    __m128 row3 = _mm_mul_ps(_mm_loadu_ps(matrix + 12), vector);
+    _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+
+    GLfloat result[4];
+    _mm_storeu_ps(result, _mm_add_ps(_mm_add_ps(row0, row1), _mm_add_ps(row2, row3)));
+    return Vector4D(result[0], result[1], result[2], result[3]);
+#else
     return Vector4D(matrix[0]*v.getX()  + matrix[1]*v.getY()  + matrix[2]*v.getZ()  + matrix[3] *v.getW(),
             matrix[4]*v.getX()  + matrix[5]*v.getY()  + matrix[6]*v.getZ()  + matrix[7] *v.getW(),
             matrix[8]*v.getX()  + matrix[9]*v.getY()  + matrix[10]*v.getZ() + matrix[11] *v.getW(),
             matrix[12]*v.getX() + matrix[13]*v.getY() + matrix[14]*v.getZ() + matrix[15] *v.getW());
+#endif
 }
 
 GLfloat Matrix4x4::operator[](const unsigned int index)
@@ -52,6 +52,7 @@ public:
     void scale(GLfloat scaleX, GLfloat scaleY, GLfloat scaleZ);
 
     GLfloat* constData();
+    const GLfloat* constData() const;
 
     void transpose();
 
@@ -72,8 +73,8 @@ public:
     GLfloat& operator()(const int &y, const int &x);
     GLfloat operator()(const int &y, const int &x) const;
 
-    Matrix4x4 operator*(const Matrix4x4 &other);
-    Vector4D operator*(const Vector4D &other);
+    Matrix4x4 operator*(const Matrix4x4 &other) const;
+    Vector4D operator*(const Vector4D &other) const;
     GLfloat operator[](const unsigned int index);
 
     GLfloat getFloat(int space);
@@ -0,0 +1,175 @@
+#include "transformbatch.h"
+#include "math_constants.h"
+#include "gsl_simd.h"
+
+#include <cmath>
+
+namespace gsl
+{
+
+namespace
+{
+/// Converts degrees to the half angle in radians used by quaternions.
+constexpr GLfloat HALF_ANGLE = PI / 360.f;
+
+/**
+ * Builds the model matrix of one transform, the scalar version of the SSE loop in compose.
+ * Also used for the transforms left over when the count is not a multiple of four.
+ */
+void composeOne(GLfloat positionX, GLfloat positionY, GLfloat positionZ,
+                GLfloat rotationX, GLfloat rotationY, GLfloat rotationZ,
+                GLfloat scaleX, GLfloat scaleY, GLfloat scaleZ, Matrix4x4& out)
+{
+    GLfloat sinX = std::sin(rotationX*HALF_ANGLE), cosX = std::cos(rotationX*HALF_ANGLE);
+    GLfloat sinY = std::sin(rotationY*HALF_ANGLE), cosY = std::cos(rotationY*HALF_ANGLE);
+    GLfloat sinZ = std::sin(rotationZ*HALF_ANGLE), cosZ = std::cos(rotationZ*HALF_ANGLE);
+
+    // zRotation * yRotation, then * xRotation, with the zero terms of the single axis quaternions left out
+    GLfloat zyX = -sinZ*sinY, zyY = cosZ*sinY, zyZ = sinZ*cosY, zyW = cosZ*cosY;
+    GLfloat x = zyX*cosX + zyW*sinX;
+    GLfloat y = zyY*cosX + zyZ*sinX;
+    GLfloat z = zyZ*cosX - zyY*sinX;
+    GLfloat w = zyW*cosX - zyX*sinX;
+
+    GLfloat xx = 2.f*x*x, yy = 2.f*y*y, zz = 2.f*z*z;
+    GLfloat xy = 2.f*x*y, xz = 2.f*x*z, yz = 2.f*y*z;
+    GLfloat xw = 2.f*x*w, yw = 2.f*y*w, zw = 2.f*z*w;
+
+    GLfloat* m = out.constData();
+    m[0] = (1.f - yy - zz)*scaleX;  m[1] = (xy - zw)*scaleY;        m[2] = (xz + yw)*scaleZ;        m[3] = positionX;
+    m[4] = (xy + zw)*scaleX;        m[5] = (1.f - xx - zz)*scaleY;  m[6] = (yz - xw)*scaleZ;        m[7] = positionY;
+    m[8] = (xz - yw)*scaleX;        m[9] = (yz + xw)*scaleY;        m[10] = (1.f - xx - yy)*scaleZ; m[11] = positionZ;
+    m[12] = 0.f;                    m[13] = 0.f;                    m[14] = 0.f;                    m[15] = 1.f;
+}
+
+#ifdef GSL_USE_SSE
+/**
+ * Sine and cosine of four angles in radians, accurate to about one float ulp for angles of normal size.
+ * The angle is reduced to [-PI/4, PI/4] by its nearest multiple of PI/2 before the polynomials are evaluated.
+ */
+inline void sinCos(__m128 angle, __m128& sine, __m128& cosine)
+{
+    __m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(angle, _mm_set1_ps(2.f/PI)));
+    __m128 quadrantFloat = _mm_cvtepi32_ps(quadrant);
+
+    // PI/2 split in three parts so the reduction keeps its precision
+    __m128 x = _mm_sub_ps(angle, _mm_mul_ps(quadrantFloat, _mm_set1_ps(1.5703125f)));
+    x = _mm_sub_ps(x, _mm_mul_ps(quadrantFloat, _mm_set1_ps(4.837512969970703125e-4f)));
+    x = _mm_sub_ps(x, _mm_mul_ps(quadrantFloat, _mm_set1_ps(7.54978995489188216e-8f)));
+    __m128 x2 = _mm_mul_ps(x, x);
+
+    __m128 sinX = _mm_add_ps(_mm_mul_ps(x2, _mm_set1_ps(-1.9515295891e-4f)), _mm_set1_ps(8.3321608736e-3f));
+    sinX = _mm_add_ps(_mm_mul_ps(sinX, x2), _mm_set1_ps(-1.6666654611e-1f));
+    sinX = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinX, x2), x), x);
+
+    __m128 cosX = _mm_add_ps(_mm_mul_ps(x2, _mm_set1_ps(2.443315711809948e-5f)), _mm_set1_ps(-1.388731625493765e-3f));
+    cosX = _mm_add_ps(_mm_mul_ps(cosX, x2), _mm_set1_ps(4.166664568298827e-2f));
+    cosX = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(cosX, x2), x2), _mm_sub_ps(_mm_set1_ps(1.f), _mm_mul_ps(x2, _mm_set1_ps(0.5f))));
+
+    // odd quadrants swap sine and cosine, bit 1 of the quadrant flips the sign of sine, and of cosine one quadrant later
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i two = _mm_set1_epi32(2);
+    __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one));
+    __m128 sineSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, two), 30));
+    __m128 cosineSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, one), two), 30));
+
+    sine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, cosX), _mm_andnot_ps(swap, sinX)), sineSign);
+    cosine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, sinX), _mm_andnot_ps(swap, cosX)), cosineSign);
+}
+#endif
+}
+
+void TransformBatch::clear()
+{
+    positionX_.clear(); positionY_.clear(); positionZ_.clear();
+    rotationX_.clear(); rotationY_.clear(); rotationZ_.clear();
+    scaleX_.clear(); scaleY_.clear(); scaleZ_.clear();
+}
+
+void TransformBatch::add(const Vector3D &position, const Vector3D &rotation, const Vector3D &scale)
+{
+    positionX_.push_back(position.x); positionY_.push_back(position.y); positionZ_.push_back(position.z);
+    rotationX_.push_back(rotation.x); rotationY_.push_back(rotation.y); rotationZ_.push_back(rotation.z);
+    scaleX_.push_back(scale.x); scaleY_.push_back(scale.y); scaleZ_.push_back(scale.z);
+}
+
+void TransformBatch::compose(size_t first, size_t count, Matrix4x4 *out) const
+{
+    size_t i = 0;
+#ifdef GSL_USE_SSE
+    const __m128 halfAngle = _mm_set1_ps(HALF_ANGLE);
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 two = _mm_set1_ps(2.f);
+    const __m128 lastRow = _mm_setr_ps(0.f, 0.f, 0.f, 1.f);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        size_t index = first + i;
+        __m128 sinX, cosX, sinY, cosY, sinZ, cosZ;
+        sinCos(_mm_mul_ps(_mm_loadu_ps(&rotationX_[index]), halfAngle), sinX, cosX);
+        sinCos(_mm_mul_ps(_mm_loadu_ps(&rotationY_[index]), halfAngle), sinY, cosY);
+        sinCos(_mm_mul_ps(_mm_loadu_ps(&rotationZ_[index]), halfAngle), sinZ, cosZ);
+
+        __m128 zyX = _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(sinZ, sinY));
+        __m128 zyY = _mm_mul_ps(cosZ, sinY);
+        __m128 zyZ = _mm_mul_ps(sinZ, cosY);
+        __m128 zyW = _mm_mul_ps(cosZ, cosY);
+        __m128 x = _mm_add_ps(_mm_mul_ps(zyX, cosX), _mm_mul_ps(zyW, sinX));
+        __m128 y = _mm_add_ps(_mm_mul_ps(zyY, cosX), _mm_mul_ps(zyZ, sinX));
+        __m128 z = _mm_sub_ps(_mm_mul_ps(zyZ, cosX), _mm_mul_ps(zyY, sinX));
+        __m128 w = _mm_sub_ps(_mm_mul_ps(zyW, cosX), _mm_mul_ps(zyX, sinX));
+
+        __m128 x2 = _mm_mul_ps(two, x), y2 = _mm_mul_ps(two, y), z2 = _mm_mul_ps(two, z);
+        __m128 xx = _mm_mul_ps(x2, x), yy = _mm_mul_ps(y2, y), zz = _mm_mul_ps(z2, z);
+        __m128 xy = _mm_mul_ps(x2, y), xz = _mm_mul_ps(x2, z), yz = _mm_mul_ps(y2, z);
+        __m128 xw = _mm_mul_ps(x2, w), yw = _mm_mul_ps(y2, w), zw = _mm_mul_ps(z2, w);
+
+        __m128 scaleX = _mm_loadu_ps(&scaleX_[index]);
+        __m128 scaleY = _mm_loadu_ps(&scaleY_[index]);
+        __m128 scaleZ = _mm_loadu_ps(&scaleZ_[index]);
+
+        // element [row][column] of the four matrices, transposed to one row per matrix before storing
+        __m128 m00 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, yy), zz), scaleX);
+        __m128 m01 = _mm_mul_ps(_mm_sub_ps(xy, zw), scaleY);
+        __m128 m02 = _mm_mul_ps(_mm_add_ps(xz, yw), scaleZ);
+        __m128 m03 = _mm_loadu_ps(&positionX_[index]);
+        _MM_TRANSPOSE4_PS(m00, m01, m02, m03);
+        _mm_storeu_ps(out[i].constData(), m00);
+        _mm_storeu_ps(out[i + 1].constData(), m01);
+        _mm_storeu_ps(out[i + 2].constData(), m02);
+        _mm_storeu_ps(out[i + 3].constData(), m03);
+
+        __m128 m10 = _mm_mul_ps(_mm_add_ps(xy, zw), scaleX);
+        __m128 m11 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, xx), zz), scaleY);
+        __m128 m12 = _mm_mul_ps(_mm_sub_ps(yz, xw), scaleZ);
+        __m128 m13 = _mm_loadu_ps(&positionY_[index]);
+        _MM_TRANSPOSE4_PS(m10, m11, m12, m13);
+        _mm_storeu_ps(out[i].constData() + 4, m10);
+        _mm_storeu_ps(out[i + 1].constData() + 4, m11);
+        _mm_storeu_ps(out[i + 2].constData() + 4, m12);
+        _mm_storeu_ps(out[i + 3].constData() + 4, m13);
+
+        __m128 m20 = _mm_mul_ps(_mm_sub_ps(xz, yw), scaleX);
+        __m128 m21 = _mm_mul_ps(_mm_add_ps(yz, xw), scaleY);
+        __m128 m22 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, xx), yy), scaleZ);
+        __m128 m23 = _mm_loadu_ps(&positionZ_[index]);
+        _MM_TRANSPOSE4_PS(m20, m21, m22, m23);
+        _mm_storeu_ps(out[i].constData() + 8, m20);
+        _mm_storeu_ps(out[i + 1].constData() + 8, m21);
+        _mm_storeu_ps(out[i + 2].constData() + 8, m22);
+        _mm_storeu_ps(out[i + 3].constData() + 8, m23);
+
+        for (size_t j = 0; j < 4; j++)
+            _mm_storeu_ps(out[i + j].constData() + 12, lastRow);
+    }
+#endif
+    for (; i < count; i++)
+    {
+        size_t index = first + i;
+        composeOne(positionX_[index], positionY_[index], positionZ_[index],
+                   rotationX_[index], rotationY_[index], rotationZ_[index],
+                   scaleX_[index], scaleY_[index], scaleZ_[index], out[i]);
+    }
+}
+
+}
@@ -0,0 +1,48 @@
+#ifndef TRANSFORMBATCH_H
+#define TRANSFORMBATCH_H
+
+#include "matrix4x4.h"
+#include "vector3d.h"
+#include <vector>
+
+namespace gsl
+{
+
+/**
+ * Position, rotation and scale of many transforms, stored as one array per component (structure of arrays)
+ * so compose() can build the model matrices of four transforms at a time.
+ * Rotations are Euler angles in degrees, applied x first, then y, then z,
+ * the same as rotQuat with the quaternion zRotation * yRotation * xRotation.
+ */
+class TransformBatch
+{
+public:
+    /// Removes all transforms, keeps the allocated memory.
+    void clear();
+    /**
+     * Adds a transform to the end of the batch.
+     * @param position Translation.
+     * @param rotation Euler angles in degrees.
+     * @param scale Scale along each axis.
+     */
+    void add(const Vector3D& position, const Vector3D& rotation, const Vector3D& scale);
+    /// Number of transforms in the batch.
+    size_t size() const { return positionX_.size(); }
+
+    /**
+     * Builds translate * rotate * scale model matrices for a range of the batch in one pass.
+     * @param first Index of the first transform to compose.
+     * @param count Number of transforms to compose.
+     * @param out Receives the matrices, out[i] is the matrix of transform first + i.
+     */
+    void compose(size_t first, size_t count, Matrix4x4* out) const;
+
+private:
+    std::vector<GLfloat> positionX_, positionY_, positionZ_;
+    std::vector<GLfloat> rotationX_, rotationY_, rotationZ_;
+    std::vector<GLfloat> scaleX_, scaleY_, scaleZ_;
+};
+
+}
+
+#endif // TRANSFORMBATCH_H
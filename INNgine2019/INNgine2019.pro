@@ -34,6 +34,8 @@ HEADERS += \
     GSL/vector3d.h \
     GSL/vector4d.h \
     GSL/gsl_math.h \
+    GSL/gsl_simd.h \
+    GSL/transformbatch.h \
     GSL/math_constants.h \
 #
     Legacy/constants.h \
@@ -46,16 +48,25 @@ HEADERS += \
     Managers/assetmanager.h \
     Managers/audiomanager.h \
     Managers/componentmanager.h \
+    Managers/componentpool.h \
+    Managers/componentview.h \
     Managers/components.h \
+    Managers/entityhandle.h \
     Managers/entitymanager.h \
+    Managers/landscape.h \
     Managers/materialmanager.h \
     Managers/meshmanager.h \
+    Managers/meshoptimizer.h \
+    Managers/meshsimplifier.h \
+    Managers/lightclusters.h \
     Managers/scenemanager.h \
     Managers/shadermanager.h \
     Managers/texturemanager.h \
     Systems/audiosystem.h \
     Systems/movementsystem.h \
     Systems/rendersystem.h \
+    Systems/spatialgrid.h \
+    Systems/boundingvolumetree.h \
 #
     UI/assetmanagerwidget.h \
     UI/assetviewer.h \
@@ -87,6 +98,7 @@ SOURCES += main.cpp \
     GSL/vector3d.cpp \
     GSL/vector4d.cpp \
     GSL/gsl_math.cpp \
+    GSL/transformbatch.cpp \
 #
     Legacy/vertex.cpp \
     Legacy/camera.cpp \
@@ -96,14 +108,20 @@ SOURCES += main.cpp \
     Managers/componentmanager.cpp \
     Managers/components.cpp \
     Managers/entitymanager.cpp \
+    Managers/landscape.cpp \
     Managers/materialmanager.cpp \
     Managers/meshmanager.cpp \
+    Managers/meshoptimizer.cpp \
+    Managers/meshsimplifier.cpp \
+    Managers/lightclusters.cpp \
     Managers/scenemanager.cpp \
     Managers/shadermanager.cpp \
     Managers/texturemanager.cpp \
     Systems/audiosystem.cpp \
     Systems/movementsystem.cpp \
     Systems/rendersystem.cpp \
+    Systems/spatialgrid.cpp \
+    Systems/boundingvolumetree.cpp \
 #
     UI/assetmanagerwidget.cpp \
     UI/assetviewer.cpp \
@@ -135,10 +153,13 @@ DISTFILES += \
     Shaders/lightfragment.frag \
     Shaders/lightshader.frag \
     Shaders/lightshader.vert \
+    Shaders/lightshaderinstanced.vert \
     Shaders/lightvertex.vert \
     Shaders/plainshader.frag \
     Shaders/plainshader.vert \
+    Shaders/plainshaderinstanced.vert \
     Shaders/textureshader.frag \
     GSL/README.md \
     README.md \
     Shaders/textureshader.vert \
+    Shaders/textureshaderinstanced.vert \
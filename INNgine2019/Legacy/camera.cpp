@@ -58,7 +58,7 @@ void Camera::UpdateForwardVector()
     UpdateRightVector();
 }
 
-void Camera::Update(std::shared_ptr<TransformComponent> transform)
+void Camera::Update(TransformComponent* transform)
 {
     gsl::Matrix4x4 yawMatrix_;
     gsl::Matrix4x4 pitchMatrix_;
@@ -43,7 +43,7 @@ public:
      * Updates the camera based on either movement from the Entity it follows or from mouse input.
      * @param transform if the camera is a thid person camera, the transform of the entity to target.
      */
-    void Update(std::shared_ptr<TransformComponent> transform = nullptr);
+    void Update(TransformComponent* transform = nullptr);
     /**
      * sets the projection matrix based on the values defined.
      * @param fov the Field of View.
@@ -61,26 +61,26 @@ void AssetManager::DeleteTexture(size_t textureID)
     materialManager_->UpdateDefaults();
 }
 
-void AssetManager::DeleteMesh(size_t meshID, std::vector<std::shared_ptr<MeshComponent> > meshComponents)
+void AssetManager::DeleteMesh(size_t meshID, ComponentPool<MeshComponent>& meshComponents)
 {
-    for(auto meshComponent : meshComponents)
+    for(MeshComponent& meshComponent : meshComponents)
     {
-        if(meshComponent->meshID_ == meshID)
-            meshComponent->meshID_ = 0;
-        else if(meshComponent->meshID_ > meshID)
-            meshComponent->meshID_--;
+        if(meshComponent.meshID_ == meshID)
+            meshComponent.meshID_ = 0;
+        else if(meshComponent.meshID_ > meshID)
+            meshComponent.meshID_--;
     }
     meshManager_->DeleteMesh(meshID);
 }
 
-void AssetManager::DeleteMaterial(size_t materialID, std::vector<std::shared_ptr<MeshComponent> > meshComponents)
+void AssetManager::DeleteMaterial(size_t materialID, ComponentPool<MeshComponent>& meshComponents)
 {
-    for(auto meshComponent : meshComponents)
+    for(MeshComponent& meshComponent : meshComponents)
     {
-        if(meshComponent->materialID_ == materialID)
-            meshComponent->materialID_ = 0;
-        else if(meshComponent->materialID_ > materialID)
-            meshComponent->materialID_--;
+        if(meshComponent.materialID_ == materialID)
+            meshComponent.materialID_ = 0;
+        else if(meshComponent.materialID_ > materialID)
+            meshComponent.materialID_--;
     }
     materialManager_->DeleteMaterial(materialID);
 }
@@ -89,10 +89,22 @@ void AssetManager::updateLandscape(QString fileWithPath)
 {
     if(!landscape_)
         landscape_ = std::make_shared<Landscape>();
-    std::pair <std::vector<Vertex>,std::vector<GLuint>> data;
-    data = meshManager_->updateLandscapeMesh(fileWithPath);
-    landscape_->vertices_ = data.first;
-    landscape_->indices_ = data.second;
+    landscape_->tileLODLevels_ = meshManager_->lodTriangleRatios_.size();
+    if(fileWithPath.section('.', -1).toLower() == "obj")
+    {
+        std::pair <std::vector<Vertex>,std::vector<GLuint>> data;
+        data = MeshManager::readOBJFile(fileWithPath.toStdString());
+        landscape_->SetMesh(std::move(data.first), std::move(data.second));
+    }
+    else
+    {
+        std::vector<float> heights;
+        int columns, rows;
+        if(!MeshManager::readHeightmap(fileWithPath, heights, columns, rows))
+            return;
+        landscape_->SetHeightmap(std::move(heights), columns, rows, landscape_->heightmapSpacing_, landscape_->heightmapHeightScale_);
+    }
+    meshManager_->UpdateLandscapeTiles(*landscape_);
 }
 
 void AssetManager::read(const QJsonObject &json)
@@ -6,24 +6,22 @@
 #include "Managers/materialmanager.h"
 #include "Managers/meshmanager.h"
 #include "Managers/audiomanager.h"
+#include "Managers/entityhandle.h"
+#include "Managers/landscape.h"
 
-///The terrain of the engine.
-class Landscape
+/// What happened in a GameEvent.
+enum GameEventType
 {
-public:
-    Landscape(){}
-    /// ID of material used by landscape
-    size_t materialID_{3};
-    /**
-     * The vertex data of tahe landscape.
-     * Used for calculations like Barycentric Coordinates.
-     */
-    std::vector<Vertex> vertices_;
-    /**
-     * The indice data of the landscape.
-     * Used for calculations like Barycentric Coordinates.
-     */
-    std::vector<GLuint> indices_;
+    PLAYER_DEATH,
+    TROPHY_CAUGHT
+};
+
+/// Gameplay event triggered by a system, handled at the start of the next tick.
+struct GameEvent
+{
+    GameEventType type;
+    /// Entity that triggered the event, check that it is still alive before using it.
+    EntityHandle entity;
 };
 
 /// Singleton class containing all assets to be used in engine.
@@ -37,7 +35,7 @@ public:
     std::shared_ptr<Landscape> landscape_{nullptr};
     /**
      * Updates landscape mesh
-     * @param fileWithPath filepath of new mesh.
+     * @param fileWithPath filepath of new mesh, an OBJ file or a grayscale heightmap image.
      */
     void updateLandscape(QString fileWithPath);
 
@@ -78,13 +76,13 @@ public:
      * @param meshID ID of mesh to delete
      * @param meshComponents Mesh components to update based on the deletion
      */
-    void DeleteMesh(size_t meshID, std::vector<std::shared_ptr<MeshComponent>> meshComponents);
+    void DeleteMesh(size_t meshID, ComponentPool<MeshComponent>& meshComponents);
     /**
      * Deletes material, and corrects all mesh components to reflect the change
      * @param materialID ID of the material to delete
      * @param meshComponents Mesh components to update based on the deletion
      */
-    void DeleteMaterial(size_t materialID, std::vector<std::shared_ptr<MeshComponent>> meshComponents);
+    void DeleteMaterial(size_t materialID, ComponentPool<MeshComponent>& meshComponents);
 
     // Saving Loading
     /**
@@ -99,14 +97,15 @@ public:
     void write(QJsonObject& json) const;
 
     // event
-    /// list of entityIDs who have triggered events during gameplay
+    /// list of events triggered during gameplay
     /// temporarily placed in this class to have global access
-    std::vector<unsigned int> events_;
+    std::vector<GameEvent> events_;
     /**
      * adds event to events_
-     * @param entityID ID of entity that triggered event
+     * @param type What happened.
+     * @param entity Entity that triggered event.
      */
-    void AddEvent(unsigned int entityID) { events_.push_back(entityID); }
+    void AddEvent(GameEventType type, EntityHandle entity = EntityHandle()) { events_.push_back({type, entity}); }
     /// Used to correct movement based on framerate
     /// temporarily placed in this class to have global access
     float deltaTime_{0};
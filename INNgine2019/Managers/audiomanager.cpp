@@ -78,7 +78,7 @@ void AudioManager::AddSound(QString filePath)
     }
 }
 
-void AudioManager::SetSound(QString soundName, std::shared_ptr<AudioComponent> component)
+void AudioManager::SetSound(QString soundName, AudioComponent* component)
 {
     alcMakeContextCurrent(ALcontext_);
     alSourceStop(component->source_);
@@ -96,7 +96,7 @@ void AudioManager::SetSound(QString soundName, std::shared_ptr<AudioComponent> c
     qDebug() << "No audio found";
 }
 
-void AudioManager::SetSound(size_t index, std::shared_ptr<AudioComponent> component)
+void AudioManager::SetSound(size_t index, AudioComponent* component)
 {
     alcMakeContextCurrent(ALcontext_);
     alSourceStop(component->source_);
@@ -54,8 +54,8 @@ public:
      * @param soundName The specified audio file name (with the .wav extension).
      * @param component The specified audio component where the sound is added.
      */
-    void SetSound(QString soundName, std::shared_ptr<AudioComponent> component);
-    void SetSound(size_t index, std::shared_ptr<AudioComponent> component);
+    void SetSound(QString soundName, AudioComponent* component);
+    void SetSound(size_t index, AudioComponent* component);
 
     /**
      * Deletes sound
@@ -12,39 +12,36 @@ void ComponentManager::UpdateShaderLightNumbers()
     int numberOfPointLights_{0};
     int numberOfSpotLights_{0};
     int numberOfDirectionalLights_{0};
-    for(auto lightComponent : lightComponents_)
+    for(LightComponent& lightComponent : lightComponents_)
     {
-        if(lightComponent)
+        switch (lightComponent.lightType_)
         {
-            switch (lightComponent->lightType_)
-            {
-            case POINT_LIGHT:
-                lightComponent->lightIndexForShader_ = numberOfPointLights_;
-                numberOfPointLights_++;
-                break;
-            case SPOT_LIGHT:
-                lightComponent->lightIndexForShader_ = numberOfSpotLights_;
-                numberOfSpotLights_++;
-                break;
-            case DIRECTIONAL_LIGHT:
-                lightComponent->lightIndexForShader_ = numberOfDirectionalLights_;
-                numberOfDirectionalLights_++;
-                break;
-            }
+        case POINT_LIGHT:
+            lightComponent.lightIndexForShader_ = numberOfPointLights_;
+            numberOfPointLights_++;
+            break;
+        case SPOT_LIGHT:
+            lightComponent.lightIndexForShader_ = numberOfSpotLights_;
+            numberOfSpotLights_++;
+            break;
+        case DIRECTIONAL_LIGHT:
+            lightComponent.lightIndexForShader_ = numberOfDirectionalLights_;
+            numberOfDirectionalLights_++;
+            break;
         }
     }
-    AssetManager::GetInstance()->shaderManager_->TransmitUniformLightDataToShader(PHONG_SHADER, numberOfPointLights_, numberOfSpotLights_, numberOfDirectionalLights_);
+    AssetManager::GetInstance()->shaderManager_->SetLightCount(numberOfPointLights_, numberOfSpotLights_, numberOfDirectionalLights_);
     qDebug() << "numberOfPointLights_" << numberOfPointLights_ << "numberOfSpotLights_" << numberOfSpotLights_<< "numberOfDirectionalLights_" << numberOfDirectionalLights_;
 }
 
 void ComponentManager::ResizeComponentVectors(size_t newSize)
 {
     numberOfEntities_ = newSize;
-    transformComponents_.resize(newSize,nullptr);
-    meshComponents_.resize(newSize,nullptr);
-    audioComponents_.resize(newSize,nullptr);
-    lightComponents_.resize(newSize,nullptr);
-    aiComponents_.resize(newSize,nullptr);
+    transformComponents_.Resize(newSize);
+    meshComponents_.Resize(newSize);
+    audioComponents_.Resize(newSize);
+    lightComponents_.Resize(newSize);
+    aiComponents_.Resize(newSize);
 }
 
 void ComponentManager::AddComponent(ComponentType componentType, size_t entityID)
@@ -54,27 +51,27 @@ void ComponentManager::AddComponent(ComponentType componentType, size_t entityID
 
     switch (componentType) {
     case TRANSFORM:
-        if(!transformComponents_[entityID])
-            transformComponents_[entityID] = std::make_shared<TransformComponent>();
+        transformComponents_.Add(entityID);
         break;
     case MESH:
-        if(!meshComponents_[entityID])
-            meshComponents_[entityID] = std::make_shared<MeshComponent>();
+    {
+        meshComponents_.Add(entityID);
+        // marks the entity as moved so its bounding box is added to the collision grid
+        if (TransformComponent* transform = transformComponents_.Get(entityID))
+            transform->hasChanged_ = true;
         break;
+    }
     case AUDIO:
-        if(!audioComponents_[entityID])
-            audioComponents_[entityID] = std::make_shared<AudioComponent>();
+        audioComponents_.Add(entityID);
         break;
     case LIGHT:
     {
-        if(!lightComponents_[entityID])
-            lightComponents_[entityID] = std::make_shared<LightComponent>();
+        lightComponents_.Add(entityID);
         UpdateShaderLightNumbers();
         break;
     }
     case AI:
-        if(!aiComponents_[entityID])
-            aiComponents_[entityID] = std::make_shared<AIComponent>();
+        aiComponents_.Add(entityID);
         break;
     case NONE:
         break;
@@ -87,15 +84,16 @@ void ComponentManager::DeleteAllComponentsForEntity(size_t entityID)
 {
     if (entityID >= numberOfEntities_)
         return;
-    numberOfEntities_ --;
 
-    transformComponents_.erase(transformComponents_.begin() + static_cast<int>(entityID));
-    meshComponents_.erase(meshComponents_.begin() + static_cast<int>(entityID));
-    audioComponents_.erase(audioComponents_.begin() + static_cast<int>(entityID));
-    lightComponents_.erase(lightComponents_.begin() + static_cast<int>(entityID));
-    aiComponents_.erase(aiComponents_.begin() + static_cast<int>(entityID));
+    transformComponents_.Remove(entityID);
+    meshComponents_.Remove(entityID);
+    audioComponents_.Remove(entityID);
+    bool hadLight = lightComponents_.Has(entityID);
+    lightComponents_.Remove(entityID);
+    aiComponents_.Remove(entityID);
 
-    UpdateShaderLightNumbers();
+    if (hadLight)
+        UpdateShaderLightNumbers();
 }
 
 void ComponentManager::DeleteComponentFromEntity(size_t entityID, ComponentType componentType)
@@ -105,20 +103,20 @@ void ComponentManager::DeleteComponentFromEntity(size_t entityID, ComponentType
 
     switch (componentType) {
     case TRANSFORM:
-        transformComponents_[entityID] = nullptr;
+        transformComponents_.Remove(entityID);
         break;
     case MESH:
-        meshComponents_[entityID] = nullptr;
+        meshComponents_.Remove(entityID);
         break;
     case AUDIO:
-        audioComponents_[entityID] = nullptr;
+        audioComponents_.Remove(entityID);
         break;
     case LIGHT:
-        lightComponents_[entityID] = nullptr;
+        lightComponents_.Remove(entityID);
         UpdateShaderLightNumbers();
         break;
     case AI:
-        aiComponents_[entityID] = nullptr;
+        aiComponents_.Remove(entityID);
         break;
     case NONE:
         break;
@@ -129,14 +127,11 @@ void ComponentManager::DeleteComponentFromEntity(size_t entityID, ComponentType
 
 void ComponentManager::UpdateDefaultTransforms()
 {
-    for (size_t i = 0; i < transformComponents_.size(); i++)
+    for (TransformComponent& transform : transformComponents_)
     {
-        if(!transformComponents_[i])
-            continue;
-
-        transformComponents_[i]->position_default_ = transformComponents_[i]->position_relative_;
-        transformComponents_[i]->rotation_default_ = transformComponents_[i]->rotation_relative_;
-        transformComponents_[i]->scale_default_ = transformComponents_[i]->scale_relative_;
+        transform.position_default_ = transform.position_relative_;
+        transform.rotation_default_ = transform.rotation_relative_;
+        transform.scale_default_ = transform.scale_relative_;
     }
 
 }
@@ -149,30 +144,26 @@ void ComponentManager::DeleteAllComponents()
 
 void ComponentManager::UpdateAudioID(unsigned int ID)
 {
-    for(auto audioComp : audioComponents_)
+    for(AudioComponent& audioComp : audioComponents_)
     {
-        if(!audioComp)
+        if(audioComp.soundID_ < ID)
             continue;
-        if(audioComp->soundID_ < ID)
-            continue;
-        if(audioComp->soundID_ == ID)
-            audioComp->soundID_ = 0;
-        else if(audioComp->soundID_ > ID)
-            audioComp->soundID_--;
-        AssetManager::GetInstance()->audioManager_->SetSound(audioComp->soundID_,audioComp);
+        if(audioComp.soundID_ == ID)
+            audioComp.soundID_ = 0;
+        else if(audioComp.soundID_ > ID)
+            audioComp.soundID_--;
+        AssetManager::GetInstance()->audioManager_->SetSound(audioComp.soundID_,&audioComp);
     }
 }
 
 void ComponentManager::UnloadAudioSound(unsigned int ID)
 {
-    for(auto audioComp : audioComponents_)
+    for(AudioComponent& audioComp : audioComponents_)
     {
-        if(!audioComp)
-            continue;
-        if(ID == audioComp->soundID_)
+        if(ID == audioComp.soundID_)
         {
             alcMakeContextCurrent(AssetManager::GetInstance()->audioManager_->ALcontext_);
-            alSourcei(audioComp->source_, AL_BUFFER, NULL);
+            alSourcei(audioComp.source_, AL_BUFFER, NULL);
         }
 
     }
@@ -186,42 +177,42 @@ void ComponentManager::read(const QJsonObject &json, size_t entityID)
     {
         TransformComponent transformComponent;
         transformComponent.read(json[COMPONENT_TYPE_NAMES[TRANSFORM]].toObject());
-        if(!transformComponents_[entityID])
+        if(!transformComponents_.Has(entityID))
             AddComponent(TRANSFORM, entityID);
-        *transformComponents_[entityID] = transformComponent;
+        *transformComponents_.Get(entityID) = transformComponent;
     }
     if(json.contains(COMPONENT_TYPE_NAMES[MESH]))
     {
         MeshComponent meshComponent;
         meshComponent.read(json[COMPONENT_TYPE_NAMES[MESH]].toObject());
-        if(!meshComponents_[entityID])
+        if(!meshComponents_.Has(entityID))
             AddComponent(MESH, entityID);
-        *meshComponents_[entityID] = meshComponent;
+        *meshComponents_.Get(entityID) = meshComponent;
     }
     if(json.contains(COMPONENT_TYPE_NAMES[AUDIO]))
     {
         AudioComponent audioComponent;
         audioComponent.read(json[COMPONENT_TYPE_NAMES[AUDIO]].toObject());
-        if(!audioComponents_[entityID])
+        if(!audioComponents_.Has(entityID))
             AddComponent(AUDIO, entityID);
-        *audioComponents_[entityID] = audioComponent;
+        *audioComponents_.Get(entityID) = audioComponent;
     }
     if(json.contains(COMPONENT_TYPE_NAMES[LIGHT]))
     {
         LightComponent lightComponent;
         lightComponent.read(json[COMPONENT_TYPE_NAMES[LIGHT]].toObject());
-        if(!lightComponents_[entityID])
+        if(!lightComponents_.Has(entityID))
             AddComponent(LIGHT, entityID);
-        *lightComponents_[entityID] = lightComponent;
+        *lightComponents_.Get(entityID) = lightComponent;
         UpdateShaderLightNumbers();
     }
     if(json.contains(COMPONENT_TYPE_NAMES[AI]))
     {
         AIComponent aiComponent;
         aiComponent.read(json[COMPONENT_TYPE_NAMES[AI]].toObject());
-        if(!aiComponents_[entityID])
+        if(!aiComponents_.Has(entityID))
             AddComponent(AI, entityID);
-        *aiComponents_[entityID] = aiComponent;
+        *aiComponents_.Get(entityID) = aiComponent;
     }
 }
 
@@ -230,34 +221,34 @@ void ComponentManager::write(QJsonObject &json, size_t entityID) const
     if (entityID >= numberOfEntities_)
         return;
 
-    if(transformComponents_[entityID])
+    if(const auto* transformComponent = transformComponents_.Get(entityID))
     {
         QJsonObject componentObject;
-        transformComponents_[entityID]->write(componentObject);
+        transformComponent->write(componentObject);
         json[COMPONENT_TYPE_NAMES[TRANSFORM]] = componentObject;
     }
-    if(meshComponents_[entityID])
+    if(const auto* meshComponent = meshComponents_.Get(entityID))
     {
         QJsonObject componentObject;
-        meshComponents_[entityID]->write(componentObject);
+        meshComponent->write(componentObject);
         json[COMPONENT_TYPE_NAMES[MESH]] = componentObject;
     }
-    if(audioComponents_[entityID])
+    if(const auto* audioComponent = audioComponents_.Get(entityID))
     {
         QJsonObject componentObject;
-        audioComponents_[entityID]->write(componentObject);
+        audioComponent->write(componentObject);
         json[COMPONENT_TYPE_NAMES[AUDIO]] = componentObject;
     }
-    if(lightComponents_[entityID])
+    if(const auto* lightComponent = lightComponents_.Get(entityID))
     {
         QJsonObject componentObject;
-        lightComponents_[entityID]->write(componentObject);
+        lightComponent->write(componentObject);
         json[COMPONENT_TYPE_NAMES[LIGHT]] = componentObject;
     }
-    if(aiComponents_[entityID])
+    if(const auto* aiComponent = aiComponents_.Get(entityID))
     {
         QJsonObject componentObject;
-        aiComponents_[entityID]->write(componentObject);
+        aiComponent->write(componentObject);
         json[COMPONENT_TYPE_NAMES[AI]] = componentObject;
     }
 }
@@ -2,6 +2,8 @@
 #define COMPONENTMANAGER_H
 
 #include "Managers/components.h"
+#include "Managers/componentpool.h"
+#include "Managers/componentview.h"
 
 /// Keeps all the data and logic connected to components.
 class ComponentManager
@@ -9,19 +11,19 @@ class ComponentManager
 public:
     ComponentManager();
 
-    /// Keeps track of the number of total entites.
+    /// Number of entity slots the pools can look up, matches EntityManager::GetSlotCount.
     size_t numberOfEntities_{0};
 
-    /// Vector of all TransformComponent, index defines what enitiy it belongs to, nullptr means no component.
-    std::vector<std::shared_ptr<TransformComponent>> transformComponents_{nullptr};
-    /// Vector of all MeshComponent, index defines what enitiy it belongs to, nullptr means no component.
-    std::vector<std::shared_ptr<MeshComponent>> meshComponents_{nullptr};
-    /// Vector of all AudioComponent, index defines what enitiy it belongs to, nullptr means no component.
-    std::vector<std::shared_ptr<AudioComponent>> audioComponents_{nullptr};
-    /// Vector of all LightComponent, index defines what enitiy it belongs to, nullptr means no component.
-    std::vector<std::shared_ptr<LightComponent>> lightComponents_{nullptr};
-    /// Vector of all AIComponent, index defines what enitiy it belongs to, nullptr means no component.
-    std::vector<std::shared_ptr<AIComponent>> aiComponents_{nullptr};
+    /// Pool of all TransformComponents, looked up by entityID.
+    ComponentPool<TransformComponent> transformComponents_;
+    /// Pool of all MeshComponents, looked up by entityID.
+    ComponentPool<MeshComponent> meshComponents_;
+    /// Pool of all AudioComponents, looked up by entityID.
+    ComponentPool<AudioComponent> audioComponents_;
+    /// Pool of all LightComponents, looked up by entityID.
+    ComponentPool<LightComponent> lightComponents_;
+    /// Pool of all AIComponents, looked up by entityID.
+    ComponentPool<AIComponent> aiComponents_;
 
     /**
      * Updates number of each light type in the phong shader.
@@ -29,21 +31,20 @@ public:
      */
     void UpdateShaderLightNumbers();
     /**
-     * Resizes all the vectors containing components in the Component Manager.
-     * Updates numberOfEntities_ as well as adds additional nullpointers to all component vectors.
-     * This because all vectors contain as many elements as there are entities, a component's index defines what enitity it belongs to, nullptr means no component.
-     * When iterating through all entites there needs to be at least a nullptr at the index to avoid crashes by trying to access invalid items in vector.
-     * @param newSize Number used to resize all component vectors and numberOfEntities_.
+     * Resizes the entity lookup of all component pools in the Component Manager.
+     * Updates numberOfEntities_ and removes components owned by entities at or above the new size.
+     * @param newSize Number used to resize all component pools and numberOfEntities_.
      */
     void ResizeComponentVectors(size_t newSize);
     /**
-     * Creates a new component of specified type and adds it to the corresponding vector.
-     * @param componentType Defines what type of component is added and which component vector to add it to.
-     * @param entityID Which index in the component vector to create the new component at, the index indicates the owning enitity.
+     * Creates a new component of specified type and adds it to the corresponding pool.
+     * @param componentType Defines what type of component is added and which component pool to add it to.
+     * @param entityID The entity that owns the new component.
      */
     void AddComponent(ComponentType componentType, size_t entityID);
     /**
      * Deletes all components within an entity.
+     * Other entities keep their IDs, so this only touches the deleted entity's components.
      * @param entityID entityID to delete components from.
      */
     void DeleteAllComponentsForEntity(size_t entityID);
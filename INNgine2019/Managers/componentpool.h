@@ -0,0 +1,126 @@
+#ifndef COMPONENTPOOL_H
+#define COMPONENTPOOL_H
+
+#include <vector>
+#include <utility>
+#include "Legacy/constants.h"
+
+/**
+ * Packed storage for all components of one type.
+ * Components are kept contiguous in components_, with the owning entity of each slot in entities_.
+ * sparse_ maps an entityID to its slot (gsl::INVALID_SIZE means no component), making lookups O(1).
+ * Removing a component moves the last component into the freed slot, so slot order is not stable,
+ * and pointers returned from Get/Add are only valid until the next Add/Remove on the same pool.
+ */
+template<typename T>
+class ComponentPool
+{
+public:
+    ComponentPool() {}
+
+    /**
+     * Creates a component for the entity, or returns the existing one.
+     * @param entityID Entity that owns the component.
+     * @return The entity's component.
+     */
+    T* Add(size_t entityID)
+    {
+        if (entityID >= sparse_.size())
+            sparse_.resize(entityID + 1, gsl::INVALID_SIZE);
+
+        if (sparse_[entityID] != gsl::INVALID_SIZE)
+            return &components_[sparse_[entityID]];
+
+        sparse_[entityID] = components_.size();
+        components_.emplace_back();
+        entities_.push_back(entityID);
+        return &components_.back();
+    }
+    /**
+     * Removes the entity's component if it has one.
+     * The last component in the pool is moved into the freed slot.
+     * @param entityID Entity to remove component from.
+     */
+    void Remove(size_t entityID)
+    {
+        if (!Has(entityID))
+            return;
+
+        size_t slot = sparse_[entityID];
+        size_t lastSlot = components_.size() - 1;
+        if (slot != lastSlot)
+        {
+            components_[slot] = std::move(components_[lastSlot]);
+            entities_[slot] = entities_[lastSlot];
+            sparse_[entities_[slot]] = slot;
+        }
+        components_.pop_back();
+        entities_.pop_back();
+        sparse_[entityID] = gsl::INVALID_SIZE;
+    }
+    /**
+     * Makes room for entityIDs up to, but not including, newSize.
+     * Components owned by entities at or above newSize are removed.
+     * @param newSize Number of entities.
+     */
+    void Resize(size_t newSize)
+    {
+        for (size_t entityID = newSize; entityID < sparse_.size(); entityID++)
+            Remove(entityID);
+        sparse_.resize(newSize, gsl::INVALID_SIZE);
+    }
+    /// Removes all components.
+    void Clear()
+    {
+        components_.clear();
+        entities_.clear();
+        sparse_.clear();
+    }
+
+    /// Whether the entity has a component in this pool.
+    bool Has(size_t entityID) const
+    {
+        return entityID < sparse_.size() && sparse_[entityID] != gsl::INVALID_SIZE;
+    }
+    /**
+     * Finds the entity's component.
+     * @param entityID Owning entity.
+     * @return The component, or nullptr if the entity has none.
+     */
+    T* Get(size_t entityID)
+    {
+        return Has(entityID) ? &components_[sparse_[entityID]] : nullptr;
+    }
+    /// Const version of Get.
+    const T* Get(size_t entityID) const
+    {
+        return Has(entityID) ? &components_[sparse_[entityID]] : nullptr;
+    }
+
+    /// Number of components in the pool.
+    size_t size() const { return components_.size(); }
+    /// Whether the pool holds no components.
+    bool empty() const { return components_.empty(); }
+    /// Component stored in a slot, slots run from 0 to size().
+    T& operator[](size_t slot) { return components_[slot]; }
+    /// Const version of operator[].
+    const T& operator[](size_t slot) const { return components_[slot]; }
+    /// The entity owning the component in a slot.
+    size_t EntityAt(size_t slot) const { return entities_[slot]; }
+
+    /// Dense iteration over the components, in slot order.
+    typename std::vector<T>::iterator begin() { return components_.begin(); }
+    typename std::vector<T>::iterator end() { return components_.end(); }
+    typename std::vector<T>::const_iterator begin() const { return components_.begin(); }
+    typename std::vector<T>::const_iterator end() const { return components_.end(); }
+
+private:
+    /// Packed components.
+    std::vector<T> components_;
+    /// Owning entity of each slot in components_.
+    std::vector<size_t> entities_;
+    /// Slot of each entity's component, gsl::INVALID_SIZE means no component.
+    std::vector<size_t> sparse_;
+};
+
+#endif // COMPONENTPOOL_H
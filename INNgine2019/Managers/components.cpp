@@ -25,6 +25,7 @@ void TransformComponent::read(const QJsonObject &json)
     position_relative_ = {json["position_relative"].toArray()};
     rotation_relative_ = {json["rotation_relative"].toArray()};
     scale_relative_ = {json["scale_relative"].toArray()};
+    hasChanged_ = true;
 }
 
 void TransformComponent::write(QJsonObject &json) const
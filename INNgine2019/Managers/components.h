@@ -11,6 +11,7 @@
 #endif
 
 #include <cstddef>
+#include <array>
 #include "GSL/vector3d.h"
 #include "GSL/bsplinecurve.h"
 #include <QJsonObject>
@@ -142,6 +143,16 @@ public:
     /// Whether object responds to frustum culling or not.
     bool reactsToFrustumCulling_{true};
 
+    /// Whether worldCorners_, worldMin_ and worldMax_ have been calculated since the component was added.
+    bool hasWorldBounds_{false};
+    /// The mesh' bounding box in world space, an oriented box in the same corner order as BoundingBox::points_.
+    /// Refreshed by MovementSystem::UpdateWorldBounds when the entity's transform changes.
+    std::array<gsl::Vector3D, 8> worldCorners_;
+    /// Lowest corner of the world space axis aligned box around worldCorners_.
+    gsl::Vector3D worldMin_{0,0,0};
+    /// Highest corner of the world space axis aligned box around worldCorners_.
+    gsl::Vector3D worldMax_{0,0,0};
+
     /**
      * reads component data from json object.
      * @param json object to read from.
@@ -234,6 +245,7 @@ public:
     /// Entity's model matrix.
     gsl::Matrix4x4 transform_;
     /// If transform has changed since last check, used to avoid unnecessary matrix operations.
+    /// Must be set by anything that edits the relative values, MovementSystem::UpdateTransforms clears it.
     bool hasChanged_{true};
     bool orientRotationBasedOnMovement_{false};
     /// Whether entity should use barycentric coordinates to follow landscape surface Y-position.
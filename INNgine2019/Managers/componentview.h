@@ -0,0 +1,85 @@
+#ifndef COMPONENTVIEW_H
+#define COMPONENTVIEW_H
+
+#include <type_traits>
+#include "Managers/componentpool.h"
+
+/**
+ * Non-owning view of a ComponentPool, handed to systems instead of the pool itself.
+ * A view is a single pointer, so it is passed by value without copying components or touching refcounts.
+ * ComponentView<const T> only gives read access, ComponentView<T> lets the system modify components,
+ * but neither can add or remove components from the pool.
+ * A pool converts implicitly to a view, so call sites can pass the pool directly.
+ */
+template<typename T>
+class ComponentView
+{
+    using Component = typename std::remove_const<T>::type;
+    using Pool = typename std::conditional<std::is_const<T>::value, const ComponentPool<Component>, ComponentPool<Component>>::type;
+
+    template<typename> friend class ComponentView;
+
+public:
+    ComponentView(Pool& pool) : pool_(&pool) {}
+    /// A mutable view can always be narrowed to a read-only view.
+    template<typename U, typename = typename std::enable_if<std::is_same<const U, T>::value && !std::is_same<U, T>::value>::type>
+    ComponentView(ComponentView<U> other) : pool_(other.pool_) {}
+
+    /// Whether the entity has a component in the viewed pool.
+    bool Has(size_t entityID) const { return pool_->Has(entityID); }
+    /**
+     * Finds the entity's component.
+     * @param entityID Owning entity.
+     * @return The component, or nullptr if the entity has none.
+     */
+    T* Get(size_t entityID) const { return pool_->Get(entityID); }
+
+    /// Number of components in the view.
+    size_t size() const { return pool_->size(); }
+    /// Whether the view holds no components.
+    bool empty() const { return pool_->empty(); }
+    /// Component stored in a slot, slots run from 0 to size().
+    T& operator[](size_t slot) const { return (*pool_)[slot]; }
+    /// The entity owning the component in a slot.
+    size_t EntityAt(size_t slot) const { return pool_->EntityAt(slot); }
+
+    /// Dense iteration over the components, in slot order.
+    auto begin() const { return pool_->begin(); }
+    auto end() const { return pool_->end(); }
+
+private:
+    Pool* pool_;
+};
+
+/**
+ * Calls function(entityID, first, second) for every entity that has a component in both views.
+ * Walks the smaller view densely and looks the entity up in the other, so the cost scales with
+ * the number of entities that can match rather than with the total number of entities.
+ * @param first View of the first component type.
+ * @param second View of the second component type.
+ * @param function Callable taking (size_t, A&, B&).
+ */
+template<typename A, typename B, typename Function>
+void ForEach(ComponentView<A> first, ComponentView<B> second, Function function)
+{
+    if (first.size() <= second.size())
+    {
+        for (size_t slot = 0; slot < first.size(); slot++)
+        {
+            size_t entityID = first.EntityAt(slot);
+            if (B* component = second.Get(entityID))
+                function(entityID, first[slot], *component);
+        }
+    }
+    else
+    {
+        for (size_t slot = 0; slot < second.size(); slot++)
+        {
+            size_t entityID = second.EntityAt(slot);
+            if (A* component = first.Get(entityID))
+                function(entityID, *component, second[slot]);
+        }
+    }
+}
+
+#endif // COMPONENTVIEW_H
@@ -0,0 +1,23 @@
+#ifndef ENTITYHANDLE_H
+#define ENTITYHANDLE_H
+
+#include "Legacy/constants.h"
+
+/**
+ * Refers to an entity for as long as it is alive.
+ * index is the entityID used to look up components and never changes while the entity lives.
+ * generation is bumped each time the index is freed, so a handle kept after the entity is deleted
+ * is never mistaken for a new entity that reuses the same index. Check with EntityManager::IsAlive.
+ */
+struct EntityHandle
+{
+    /// entityID of the entity, gsl::INVALID_SIZE means no entity.
+    size_t index{gsl::INVALID_SIZE};
+    /// Generation of the index when the handle was made.
+    unsigned int generation{0};
+
+    bool operator==(const EntityHandle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const EntityHandle& other) const { return !(*this == other); }
+};
+
+#endif // ENTITYHANDLE_H
@@ -8,79 +8,203 @@ EntityManager::EntityManager(QTreeWidget* entityTree) : entityTree_(entityTree)
 
 QString EntityManager::GetEntityName(size_t entityID) const
 {
-    if (entityID >= numberOfEntities_)
+    if (!IsAlive(entityID))
         return "";
-    return entities_[static_cast<int>(entityID)]->text(0);
+    return names_[entityID];
 }
 
 size_t EntityManager::GetParentEntityID(size_t entityID) const
 {
-    if (entityID >= numberOfEntities_)
-        return gsl::INVALID_SIZE;
-
-    if (entities_[static_cast<int>(entityID)]->parent())
-        return entities_[static_cast<int>(entityID)]->parent()->text(1).toUInt();
-    else
+    if (!IsAlive(entityID))
         return gsl::INVALID_SIZE;
+    return parents_[entityID];
 }
 
 std::vector<size_t> EntityManager::GetChildrenIDs(size_t entityID) const
 {
     std::vector<size_t> temp;
 
-    if (entityID >= numberOfEntities_)
+    if (!IsAlive(entityID))
         return temp;
 
-    for(int i = 0; i < entities_[static_cast<int>(entityID)]->childCount(); i++)
-        temp.push_back(entities_[static_cast<int>(entityID)]->child(i)->text(1).toUInt());
+    for (size_t childID = firstChildren_[entityID]; childID != gsl::INVALID_SIZE; childID = nextSiblings_[childID])
+        temp.push_back(childID);
 
     return temp;
 }
 
-size_t EntityManager::GetLastEntityID() const
-{return numberOfEntities_ - 1;}
-
-void EntityManager::DeleteEntityWithChildren(size_t entityID)
+const std::vector<size_t>& EntityManager::GetDepthOrder() const
 {
-    if(entityID >= numberOfEntities_)
-        return;
+    if (!depthOrderChanged_)
+        return depthOrder_;
 
-    if (entityTree_->indexOfTopLevelItem(entities_[entityID]) >= 0)
+    depthOrder_.clear();
+    for (size_t entityID = 0; entityID < GetSlotCount(); entityID++)
     {
-        delete entityTree_->takeTopLevelItem(entityTree_->indexOfTopLevelItem(entities_[entityID]));
+        if (IsAlive(entityID) && parents_[entityID] == gsl::INVALID_SIZE)
+            depthOrder_.push_back(entityID);
     }
-    else
+    // every entity added appends its children, so parents always come before children
+    for (size_t i = 0; i < depthOrder_.size(); i++)
     {
-        delete entities_[entityID]->parent()->takeChild(entities_[entityID]->parent()->indexOfChild(entities_[entityID]));
+        for (size_t childID = firstChildren_[depthOrder_[i]]; childID != gsl::INVALID_SIZE; childID = nextSiblings_[childID])
+            depthOrder_.push_back(childID);
     }
+    depthOrderChanged_ = false;
+    return depthOrder_;
+}
 
-    numberOfEntities_ --;
-    entities_.erase(entities_.begin() + static_cast<int>(entityID));
+size_t EntityManager::GetLastEntityID() const
+{return lastEntityID_;}
+
+size_t EntityManager::GetSlotCount() const
+{
+    return alive_.size();
+}
+
+bool EntityManager::IsAlive(size_t entityID) const
+{
+    return entityID < GetSlotCount() && alive_[entityID];
+}
+
+bool EntityManager::IsAlive(EntityHandle handle) const
+{
+    return IsAlive(handle.index) && generations_[handle.index] == handle.generation;
+}
+
+EntityHandle EntityManager::GetHandle(size_t entityID) const
+{
+    if (!IsAlive(entityID))
+        return EntityHandle();
+    return {entityID, generations_[entityID]};
+}
 
-    for(int i = 0; i < entities_.size(); i++)
+void EntityManager::DeleteEntityWithChildren(size_t entityID)
+{
+    if(!IsAlive(entityID))
+        return;
+
+    // deleting the tree item deletes the child items with it, so their IDs are freed first
+    while (firstChildren_[entityID] != gsl::INVALID_SIZE)
+        DeleteEntityWithChildren(firstChildren_[entityID]);
+
+    QTreeWidgetItem* item = entities_[static_cast<int>(entityID)];
+    if (item)
     {
-        entities_[i]->setText(1, QString::number(i));
+        if (item->parent())
+            delete item->parent()->takeChild(item->parent()->indexOfChild(item));
+        else
+            delete entityTree_->takeTopLevelItem(entityTree_->indexOfTopLevelItem(item));
     }
 
+    Unlink(entityID);
+    numberOfEntities_ --;
+    entities_[static_cast<int>(entityID)] = nullptr;
+    alive_[entityID] = false;
+    names_[entityID].clear();
+    generations_[entityID]++;
+    freeIDs_.push_back(entityID);
+    depthOrderChanged_ = true;
 }
 
 void EntityManager::SetChild(size_t parentID, size_t childID)
 {
-    if (entityTree_->indexOfTopLevelItem(entities_[childID]) >= 0)
+    if (!IsAlive(parentID))
+        return;
+    SetParent(childID, parentID);
+}
+
+void EntityManager::SetParent(size_t childID, size_t parentID)
+{
+    if (!IsAlive(childID) || (parentID != gsl::INVALID_SIZE && !IsAlive(parentID)))
+        return;
+
+    for (size_t ancestorID = parentID; ancestorID != gsl::INVALID_SIZE; ancestorID = parents_[ancestorID])
     {
-        entities_[parentID]->addChild(entityTree_->takeTopLevelItem(entityTree_->indexOfTopLevelItem(entities_[childID])));
+        if (ancestorID == childID)
+        {
+            qDebug() << "Can not make" << names_[childID] << "a child of itself or its own children";
+            return;
+        }
     }
-    else
+
+    if (parents_[childID] != parentID)
     {
-        entities_[parentID]->addChild(entities_[childID]);
+        Unlink(childID);
+        Link(childID, parentID);
+        depthOrderChanged_ = true;
     }
+
+    // mirror in GUI, the tree may already match if the change came from dragging in it
+    QTreeWidgetItem* item = entities_[static_cast<int>(childID)];
+    QTreeWidgetItem* parentItem = parentID != gsl::INVALID_SIZE ? entities_[static_cast<int>(parentID)] : nullptr;
+    if (!item || item->parent() == parentItem)
+        return;
+
+    if (item->parent())
+        item->parent()->takeChild(item->parent()->indexOfChild(item));
+    else
+        entityTree_->takeTopLevelItem(entityTree_->indexOfTopLevelItem(item));
+
+    if (parentItem)
+        parentItem->addChild(item);
+    else
+        entityTree_->addTopLevelItem(item);
+}
+
+void EntityManager::Unlink(size_t entityID)
+{
+    size_t parentID = parents_[entityID];
+    size_t previousID = previousSiblings_[entityID];
+    size_t nextID = nextSiblings_[entityID];
+
+    if (previousID != gsl::INVALID_SIZE)
+        nextSiblings_[previousID] = nextID;
+    else if (parentID != gsl::INVALID_SIZE)
+        firstChildren_[parentID] = nextID;
+    if (nextID != gsl::INVALID_SIZE)
+        previousSiblings_[nextID] = previousID;
+
+    parents_[entityID] = gsl::INVALID_SIZE;
+    previousSiblings_[entityID] = gsl::INVALID_SIZE;
+    nextSiblings_[entityID] = gsl::INVALID_SIZE;
+}
+
+void EntityManager::Link(size_t entityID, size_t parentID)
+{
+    parents_[entityID] = parentID;
+    if (parentID == gsl::INVALID_SIZE)
+        return;
+
+    size_t nextID = firstChildren_[parentID];
+    nextSiblings_[entityID] = nextID;
+    if (nextID != gsl::INVALID_SIZE)
+        previousSiblings_[nextID] = entityID;
+    firstChildren_[parentID] = entityID;
 }
 
 void EntityManager::DeleteAllEntities()
 {
+    // IDs restart from 0, but generations are kept so handles to the old entities stay invalid.
+    for (size_t i = 0; i < GetSlotCount(); i++)
+    {
+        if (alive_[i])
+            generations_[i]++;
+    }
     entities_.clear();
-    entityTree_->clear();
+    alive_.clear();
+    names_.clear();
+    visible_.clear();
+    parents_.clear();
+    firstChildren_.clear();
+    nextSiblings_.clear();
+    previousSiblings_.clear();
+    freeIDs_.clear();
+    if (entityTree_)
+        entityTree_->clear();
     numberOfEntities_ = 0;
+    lastEntityID_ = gsl::INVALID_SIZE;
+    depthOrderChanged_ = true;
 }
 
 void EntityManager::read(const QJsonObject &json, size_t entityID)
@@ -93,61 +217,104 @@ void EntityManager::write(QJsonObject &json, size_t entityID) const
     json["entityID"] = static_cast<int>(entityID);
     json["entityName"] = GetEntityName(entityID);
     json["parentID"] = static_cast<int>(GetParentEntityID(entityID));
-    if(entities_[entityID]->checkState(0) == Qt::Checked)
-        json["visible"] = true;
-    else
-        json["visible"] = false;
+    json["visible"] = IsVisible(entityID);
 }
 
-void EntityManager::AddEntity(QString name, size_t parentEntityID)
-{   
-    if (parentEntityID == gsl::INVALID_SIZE) // doesn't have a parent
+size_t EntityManager::AddEntity(QString name, size_t parentEntityID)
+{
+    if (parentEntityID != gsl::INVALID_SIZE && !IsAlive(parentEntityID))
     {
-        entities_.push_back(new QTreeWidgetItem);
-        entityTree_->addTopLevelItem(entities_.back());
+        qDebug() << name << " has invalid parent ID: " << parentEntityID;
+        return gsl::INVALID_SIZE;
     }
-    else // does have a parent.
+
+    size_t entityID;
+    if (!freeIDs_.empty())
     {
-        if (parentEntityID >= numberOfEntities_)
-        {
-            qDebug() << name << " has invalid parent ID: " << parentEntityID;
-            return;
-        }
-        entities_.push_back(new QTreeWidgetItem(entities_[static_cast<int>(parentEntityID)]));
+        entityID = freeIDs_.back();
+        freeIDs_.pop_back();
+    }
+    else
+    {
+        entityID = GetSlotCount();
+        entities_.push_back(nullptr);
+        alive_.push_back(false);
+        names_.push_back("");
+        visible_.push_back(true);
+        parents_.push_back(gsl::INVALID_SIZE);
+        firstChildren_.push_back(gsl::INVALID_SIZE);
+        nextSiblings_.push_back(gsl::INVALID_SIZE);
+        previousSiblings_.push_back(gsl::INVALID_SIZE);
+        if (generations_.size() <= entityID)
+            generations_.push_back(0);
     }
 
-    qDebug() << "Entity created" << name << "EntityID: " << numberOfEntities_;
-
-    entities_.back()->setText(0, name);
-    entities_.back()->setText(1, QString::number(numberOfEntities_));
-    entities_.back()->setFlags(Qt::ItemIsUserCheckable | Qt::ItemIsSelectable | Qt::ItemIsEnabled | Qt::ItemIsEditable | Qt::ItemIsDragEnabled | Qt::ItemIsDropEnabled);
-    entities_.back()->setCheckState(0, Qt::Checked);
+    alive_[entityID] = true;
+    names_[entityID] = name;
+    visible_[entityID] = true;
+    firstChildren_[entityID] = gsl::INVALID_SIZE;
+    Link(entityID, parentEntityID);
+    depthOrderChanged_ = true;
     numberOfEntities_++;
+    lastEntityID_ = entityID;
+
+    qDebug() << "Entity created" << name << "EntityID: " << entityID;
+
+    if (entityTree_)
+    {
+        // the item is filled in before it is added so the tree never shows an entity without an ID
+        QTreeWidgetItem* item = new QTreeWidgetItem;
+        item->setText(1, QString::number(entityID));
+        item->setText(0, name);
+        item->setFlags(Qt::ItemIsUserCheckable | Qt::ItemIsSelectable | Qt::ItemIsEnabled | Qt::ItemIsEditable | Qt::ItemIsDragEnabled | Qt::ItemIsDropEnabled);
+        item->setCheckState(0, Qt::Checked);
+        entities_[static_cast<int>(entityID)] = item;
+
+        if (parentEntityID == gsl::INVALID_SIZE) // doesn't have a parent
+            entityTree_->addTopLevelItem(item);
+        else // does have a parent.
+            entities_[static_cast<int>(parentEntityID)]->addChild(item);
+    }
+
+    return entityID;
 }
 
 void EntityManager::SelectEntityInTree(size_t entityID)
 {
-    QTreeWidgetItemIterator it(entityTree_);
-    while (*it)
-    {
-        if ((*it)->text(1) == QString::number(entityID))
-            (*it)->setSelected(true);
-        else
-            (*it)->setSelected(false);
-        ++it;
-    }
+    if (!entityTree_)
+        return;
+
+    entityTree_->clearSelection();
+    if (IsAlive(entityID) && entities_[static_cast<int>(entityID)])
+        entities_[static_cast<int>(entityID)]->setSelected(true);
 }
 
 void EntityManager::SetEntityWidgetItemChecked(size_t entityID, bool checked)
 {
-    if (entityID >= numberOfEntities_)
+    if (!IsAlive(entityID))
         return;
 
-    if (checked)
-        entities_[static_cast<int>(entityID)]->setCheckState(0, Qt::Checked);
-    else
-        entities_[static_cast<int>(entityID)]->setCheckState(0, Qt::Unchecked);
+    visible_[entityID] = checked;
+
+    QTreeWidgetItem* item = entities_[static_cast<int>(entityID)];
+    Qt::CheckState checkState = checked ? Qt::Checked : Qt::Unchecked;
+    if (item && item->checkState(0) != checkState)
+        item->setCheckState(0, checkState);
 }
 
+bool EntityManager::IsVisible(size_t entityID) const
+{
+    return IsAlive(entityID) && visible_[entityID];
+}
 
+void EntityManager::SetEntityName(size_t entityID, QString name)
+{
+    if (!IsAlive(entityID))
+        return;
 
+    names_[entityID] = name;
+
+    QTreeWidgetItem* item = entities_[static_cast<int>(entityID)];
+    if (item && item->text(0) != name)
+        item->setText(0, name);
+}
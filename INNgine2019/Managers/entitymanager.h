@@ -2,34 +2,54 @@
 #define ENTITYMANAGER_H
 
 #include <QTreeWidgetItem>
+#include "Managers/entityhandle.h"
 
 /// Keep all data and logic connected to entites.
-/// This class hides communication between the engine and QTreeWidget.
+/// Names, visibility and parent/child relationships are stored in flat tables indexed by entityID.
+/// The QTreeWidget only mirrors them for the GUI, and is optional so the engine can run without one.
 class EntityManager
 {
 public:
     /**
      * EntityManager Constructor.
-     * @param entityTree EntityManager uses a QTreeWidget as a base.
+     * @param entityTree QTreeWidget to display entities in, nullptr to run without GUI.
      */
-    EntityManager(QTreeWidget* entityTree);
-    /// Total number of entites.
+    EntityManager(QTreeWidget* entityTree = nullptr);
+    /// Total number of living entites.
     size_t numberOfEntities_{0};
-    /// QTreeWidget to hold entites data.
-    /// Used for parent/child relationships and to display in GUI.
+    /// QTreeWidget to display entites in, can be nullptr.
+    /// Mirrors the names, visibility and parent/child relationships stored in the manager.
     QTreeWidget* entityTree_;
-    /// Pointers to all entites so they can be edited through the manager or in the GUI through the entityTree_.
+    /// Tree items of all entites so they can be edited in the GUI through the entityTree_.
     /// Entites contain a name and an ID.
-    /// The ID is the same as their index in this QList.
+    /// The ID is the same as their index in this QList, and does not change while the entity lives.
+    /// Slots of deleted entities, and all slots when there is no entityTree_, are nullptr.
     QList<QTreeWidgetItem*> entities_;
     /**
      * Adds new item to entites_ and updates numberOfEntities_.
      * Creates a custom QTreeWidgetItem based on the data we want an entity to have.
-     * Automatically creates an entityID.
+     * Reuses the ID of a deleted entity if there is one, otherwise appends a new ID.
      * @param name Used to give the entity a name to be printed in GUI and debug.
      * @param parentEntityID Optional, entityID of the parent to add child to, if no parent given creates a top level item.
+     * @return ID of the new entity, gsl::INVALID_SIZE if it could not be created.
      */
-    void AddEntity(QString name, size_t parentEntityID = gsl::INVALID_SIZE);
+    size_t AddEntity(QString name, size_t parentEntityID = gsl::INVALID_SIZE);
+    /**
+     * Number of entity slots, living or deleted.
+     * All living entityIDs are below this, use it to size lookups indexed by entityID.
+     * @return One past the highest entityID in use.
+     */
+    size_t GetSlotCount() const;
+    /// Whether entityID refers to a living entity.
+    bool IsAlive(size_t entityID) const;
+    /// Whether the entity the handle was made for is still alive.
+    bool IsAlive(EntityHandle handle) const;
+    /**
+     * Makes a handle to a living entity that can be kept across deletions of other entities.
+     * @param entityID ID of entity.
+     * @return Handle to the entity, a handle with gsl::INVALID_SIZE index if entityID is not alive.
+     */
+    EntityHandle GetHandle(size_t entityID) const;
     /**
      * Selects an entity in the entityTree_ and deselcts all others.
      * Used to update GUI menus to display correct information based on selected entity.
@@ -42,6 +62,14 @@ public:
      * @param checked Whether to checked or unchecked.
      */
     void SetEntityWidgetItemChecked(size_t entityID, bool checked);
+    /// Whether the entity is checked as visible.
+    bool IsVisible(size_t entityID) const;
+    /**
+     * Renames an entity.
+     * @param entityID ID of entity to rename.
+     * @param name New name.
+     */
+    void SetEntityName(size_t entityID, QString name);
     /**
      * Gets the ID of an entity's parent if any.
      * @param entityID ID of entity to find parent of.
@@ -61,13 +89,19 @@ public:
      */
     std::vector<size_t> GetChildrenIDs(size_t entityID) const;
     /**
-     * Gets ID of the last entity in entities_.
-     * Depends on the numberOfEntities_ always being correct.
-     * @return ID of last entity.
+     * Gets all living entityIDs ordered so every parent comes before its children.
+     * Rebuilt only after the hierarchy has changed.
+     * @return Living entityIDs in depth order.
+     */
+    const std::vector<size_t>& GetDepthOrder() const;
+    /**
+     * Gets ID of the last entity created.
+     * @return ID of last created entity.
      */
     size_t GetLastEntityID() const;
     /**
      * Deletes entity end its children from entityTree and entities_.
+     * The ID is freed for reuse, other entities keep their IDs.
      * @param entityID ID of entity to delete.
      */
     void DeleteEntityWithChildren(size_t entityID);
@@ -77,6 +111,13 @@ public:
      * @param childID entityID of enitity to be child
      */
     void SetChild(size_t parentID, size_t childID);
+    /**
+     * Moves an entity to a new parent, or to the top level.
+     * Does nothing if parentID is the entity itself or one of its descendants.
+     * @param childID entityID of entity to move.
+     * @param parentID entityID of new parent, gsl::INVALID_SIZE to make it a top level entity.
+     */
+    void SetParent(size_t childID, size_t parentID);
     /**
      * Deletes all entities
      */
@@ -94,6 +135,37 @@ public:
      * @param entityID entityID to write data from.
      */
     void write(QJsonObject& json, size_t entityID) const;
+
+private:
+    /// Removes an entity from its parent's child list.
+    void Unlink(size_t entityID);
+    /// Adds an entity first in its parent's child list.
+    void Link(size_t entityID, size_t parentID);
+
+    /// Whether each slot holds a living entity.
+    std::vector<bool> alive_;
+    /// Name of each entity.
+    std::vector<QString> names_;
+    /// Whether each entity is checked as visible.
+    std::vector<bool> visible_;
+    /// Parent of each entity, gsl::INVALID_SIZE for top level entities.
+    std::vector<size_t> parents_;
+    /// First child of each entity, gsl::INVALID_SIZE if it has none.
+    std::vector<size_t> firstChildren_;
+    /// Next child of the same parent, gsl::INVALID_SIZE for the last child.
+    std::vector<size_t> nextSiblings_;
+    /// Previous child of the same parent, gsl::INVALID_SIZE for the first child.
+    std::vector<size_t> previousSiblings_;
+    /// Living entityIDs with parents before children, see GetDepthOrder.
+    mutable std::vector<size_t> depthOrder_;
+    /// Whether depthOrder_ must be rebuilt.
+    mutable bool depthOrderChanged_{true};
+    /// Generation of each slot in entities_, bumped when the entity in the slot is deleted.
+    std::vector<unsigned int> generations_;
+    /// IDs of deleted entities, reused by AddEntity before new IDs are appended.
+    std::vector<size_t> freeIDs_;
+    /// ID returned by the last call to AddEntity.
+    size_t lastEntityID_{gsl::INVALID_SIZE};
 };
 
 #endif // ENTITYMANAGER_H
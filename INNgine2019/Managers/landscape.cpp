@@ -0,0 +1,466 @@
+#include "landscape.h"
+#include "GSL/gsl_simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+
+namespace
+{
+/// Barycentric weights slightly below zero are accepted so locations on shared edges are never missed.
+constexpr float EDGE_TOLERANCE = 1e-5f;
+
+/// Key of a vertex position, vertices split for their normals or uvs get the same key.
+unsigned long long PositionKey(const gsl::Vector3D& position)
+{
+    std::uint32_t x, z;
+    std::memcpy(&x, &position.x, sizeof(x));
+    std::memcpy(&z, &position.z, sizeof(z));
+    return (static_cast<unsigned long long>(x) << 32) | z;
+}
+
+/// Signed double area of a triangle in XZ.
+float AreaXZ(const gsl::Vector3D& a, const gsl::Vector3D& b, const gsl::Vector3D& c)
+{
+    return (b.x - a.x) * (c.z - a.z) - (c.x - a.x) * (b.z - a.z);
+}
+}
+
+void Landscape::SetMesh(std::vector<Vertex> vertices, std::vector<GLuint> indices)
+{
+    vertices_ = std::move(vertices);
+    indices_ = std::move(indices);
+    heights_.clear();
+    BuildGrid();
+    BuildTiles();
+}
+
+void Landscape::SetHeightmap(std::vector<float> heights, int columns, int rows, float spacing, float heightScale)
+{
+    vertices_.clear();
+    indices_.clear();
+    cellStart_.clear();
+    cellTriangles_.clear();
+    heights_ = std::move(heights);
+    cellsX_ = 0;
+    cellsZ_ = 0;
+    if (columns < 2 || rows < 2 || heights_.size() != static_cast<size_t>(columns) * static_cast<size_t>(rows))
+    {
+        qDebug() << "Heightmap needs at least 2 by 2 heights, got" << heights_.size() << "for" << columns << "by" << rows;
+        heights_.clear();
+        tiles_.clear();
+        return;
+    }
+
+    // the grid cells are the heightmap's quads, so GetHeight and BuildTiles can use them directly
+    cellSize_ = spacing;
+    cellsX_ = columns - 1;
+    cellsZ_ = rows - 1;
+    gridMinX_ = -0.5f * spacing * cellsX_;
+    gridMinZ_ = -0.5f * spacing * cellsZ_;
+    for (float& height : heights_)
+        height *= heightScale;
+
+    vertices_.resize(heights_.size());
+    indices_.resize(static_cast<size_t>(cellsX_) * static_cast<size_t>(cellsZ_) * 6);
+
+    // each row is independent, so the rows are split evenly between the threads
+    auto buildRows = [&](int firstRow, int lastRow)
+    {
+        for (int z = firstRow; z < lastRow; z++)
+        {
+            for (int x = 0; x < columns; x++)
+            {
+                size_t index = static_cast<size_t>(z) * columns + x;
+                // central differences, one sided at the edges
+                float left = heights_[index - (x > 0 ? 1 : 0)];
+                float right = heights_[index + (x < cellsX_ ? 1 : 0)];
+                float back = heights_[index - (z > 0 ? columns : 0)];
+                float front = heights_[index + (z < cellsZ_ ? columns : 0)];
+                float widthX = spacing * ((x > 0 ? 1 : 0) + (x < cellsX_ ? 1 : 0));
+                float widthZ = spacing * ((z > 0 ? 1 : 0) + (z < cellsZ_ ? 1 : 0));
+                gsl::Vector3D normal((left - right) * widthZ, widthX * widthZ, (back - front) * widthX);
+                normal.normalize();
+
+                Vertex& vertex = vertices_[index];
+                vertex.XYZ_ = {gridMinX_ + x * spacing, heights_[index], gridMinZ_ + z * spacing};
+                vertex.normal_ = normal;
+                vertex.ST_ = {static_cast<float>(x) / cellsX_, static_cast<float>(z) / cellsZ_};
+
+                if (x < cellsX_ && z < cellsZ_)
+                {
+                    GLuint a = static_cast<GLuint>(index);
+                    GLuint b = a + 1;
+                    GLuint c = a + static_cast<GLuint>(columns);
+                    GLuint d = c + 1;
+                    GLuint* quad = &indices_[(static_cast<size_t>(z) * cellsX_ + x) * 6];
+                    quad[0] = a; quad[1] = c; quad[2] = b;
+                    quad[3] = b; quad[4] = c; quad[5] = d;
+                }
+            }
+        }
+    };
+
+    int threadCount = std::max(1, std::min(static_cast<int>(std::thread::hardware_concurrency()), rows));
+    std::vector<std::thread> threads;
+    for (int i = 1; i < threadCount; i++)
+        threads.emplace_back(buildRows, rows * i / threadCount, rows * (i + 1) / threadCount);
+    buildRows(0, rows / threadCount);
+    for (std::thread& thread : threads)
+        thread.join();
+
+    BuildTiles();
+}
+
+int Landscape::CellCoordinate(float value, float gridMin) const
+{
+    return static_cast<int>(std::floor((value - gridMin) / cellSize_));
+}
+
+void Landscape::BuildGrid()
+{
+    cellStart_.clear();
+    cellTriangles_.clear();
+    cellsX_ = 0;
+    cellsZ_ = 0;
+
+    size_t triangleCount = indices_.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    float minX = HUGE_VALF, minZ = HUGE_VALF, maxX = -HUGE_VALF, maxZ = -HUGE_VALF;
+    for (GLuint index : indices_)
+    {
+        const gsl::Vector3D& position = vertices_[index].XYZ_;
+        minX = std::min(minX, position.x);
+        minZ = std::min(minZ, position.z);
+        maxX = std::max(maxX, position.x);
+        maxZ = std::max(maxZ, position.z);
+    }
+
+    // about one quad, two triangles, per cell for a regular height field
+    float area = (maxX - minX) * (maxZ - minZ);
+    cellSize_ = area > 0.f ? std::sqrt(2.f * area / static_cast<float>(triangleCount)) : 1.f;
+    gridMinX_ = minX;
+    gridMinZ_ = minZ;
+    cellsX_ = std::max(1, static_cast<int>(std::ceil((maxX - minX) / cellSize_)));
+    cellsZ_ = std::max(1, static_cast<int>(std::ceil((maxZ - minZ) / cellSize_)));
+
+    // counted first, then filled, so all cells share one array
+    auto forEachCell = [this](size_t triangle, auto function)
+    {
+        const gsl::Vector3D& a = vertices_[indices_[triangle]].XYZ_;
+        const gsl::Vector3D& b = vertices_[indices_[triangle + 1]].XYZ_;
+        const gsl::Vector3D& c = vertices_[indices_[triangle + 2]].XYZ_;
+        int firstX = std::max(0, CellCoordinate(std::min({a.x, b.x, c.x}), gridMinX_));
+        int firstZ = std::max(0, CellCoordinate(std::min({a.z, b.z, c.z}), gridMinZ_));
+        int lastX = std::min(cellsX_ - 1, CellCoordinate(std::max({a.x, b.x, c.x}), gridMinX_));
+        int lastZ = std::min(cellsZ_ - 1, CellCoordinate(std::max({a.z, b.z, c.z}), gridMinZ_));
+        for (int z = firstZ; z <= lastZ; z++)
+            for (int x = firstX; x <= lastX; x++)
+                function(static_cast<size_t>(x + z * cellsX_));
+    };
+
+    size_t cellCount = static_cast<size_t>(cellsX_) * static_cast<size_t>(cellsZ_);
+    cellStart_.assign(cellCount + 1, 0);
+    for (size_t triangle = 0; triangle + 2 < indices_.size(); triangle += 3)
+        forEachCell(triangle, [this](size_t cell) { cellStart_[cell + 1]++; });
+    for (size_t cell = 0; cell < cellCount; cell++)
+        cellStart_[cell + 1] += cellStart_[cell];
+
+    cellTriangles_.resize(cellStart_[cellCount]);
+    std::vector<GLuint> filled(cellStart_.begin(), cellStart_.end() - 1);
+    for (size_t triangle = 0; triangle + 2 < indices_.size(); triangle += 3)
+        forEachCell(triangle, [&](size_t cell) { cellTriangles_[filled[cell]++] = static_cast<GLuint>(triangle); });
+}
+
+void Landscape::BuildTiles()
+{
+    tiles_.clear();
+    if (cellsX_ == 0)
+        return;
+
+    int tilesX = (cellsX_ + TILE_CELLS - 1) / TILE_CELLS;
+    int tilesZ = (cellsZ_ + TILE_CELLS - 1) / TILE_CELLS;
+    tiles_.resize(static_cast<size_t>(tilesX * tilesZ));
+    for (LandscapeTile& tile : tiles_)
+        tile.indices_.resize(std::max<size_t>(tileLODLevels_, 1));
+    float tileSize = cellSize_ * TILE_CELLS;
+
+    // a position used by two tiles is on their border, position keys catch vertices that were split for their uvs
+    const size_t sharedTile = tiles_.size();
+    std::unordered_map<unsigned long long, size_t> positionTiles;
+    positionTiles.reserve(vertices_.size());
+    for (size_t triangle = 0; triangle + 2 < indices_.size(); triangle += 3)
+    {
+        const gsl::Vector3D& a = vertices_[indices_[triangle]].XYZ_;
+        const gsl::Vector3D& b = vertices_[indices_[triangle + 1]].XYZ_;
+        const gsl::Vector3D& c = vertices_[indices_[triangle + 2]].XYZ_;
+        float centerX = (a.x + b.x + c.x) / 3.f;
+        float centerZ = (a.z + b.z + c.z) / 3.f;
+        int tileX = std::min(tilesX - 1, std::max(0, static_cast<int>(std::floor((centerX - gridMinX_) / tileSize))));
+        int tileZ = std::min(tilesZ - 1, std::max(0, static_cast<int>(std::floor((centerZ - gridMinZ_) / tileSize))));
+        size_t tileIndex = static_cast<size_t>(tileX + tileZ * tilesX);
+
+        std::vector<GLuint>& tileIndices = tiles_[tileIndex].indices_[0];
+        for (size_t corner = 0; corner < 3; corner++)
+        {
+            GLuint index = indices_[triangle + corner];
+            tileIndices.push_back(index);
+            auto inserted = positionTiles.emplace(PositionKey(vertices_[index].XYZ_), tileIndex);
+            if (!inserted.second && inserted.first->second != tileIndex)
+                inserted.first->second = sharedTile;
+        }
+    }
+
+    std::vector<bool> isShared(vertices_.size(), false);
+    for (size_t vertex = 0; vertex < vertices_.size(); vertex++)
+    {
+        auto position = positionTiles.find(PositionKey(vertices_[vertex].XYZ_));
+        isShared[vertex] = position != positionTiles.end() && position->second == sharedTile;
+    }
+
+    // empty tiles, like in the corners of a round landscape, are removed
+    tiles_.erase(std::remove_if(tiles_.begin(), tiles_.end(), [](const LandscapeTile& tile){ return tile.indices_[0].empty(); }),
+                 tiles_.end());
+    for (LandscapeTile& tile : tiles_)
+    {
+        tile.min_ = {HUGE_VALF, HUGE_VALF, HUGE_VALF};
+        tile.max_ = {-HUGE_VALF, -HUGE_VALF, -HUGE_VALF};
+        for (GLuint index : tile.indices_[0])
+        {
+            const gsl::Vector3D& position = vertices_[index].XYZ_;
+            tile.min_ = {std::min(tile.min_.x, position.x), std::min(tile.min_.y, position.y), std::min(tile.min_.z, position.z)};
+            tile.max_ = {std::max(tile.max_.x, position.x), std::max(tile.max_.y, position.y), std::max(tile.max_.z, position.z)};
+        }
+        for (size_t lodLevel = 1; lodLevel < tile.indices_.size(); lodLevel++)
+            BuildTileLOD(tile, lodLevel, isShared);
+    }
+}
+
+void Landscape::BuildTileLOD(LandscapeTile& tile, size_t lodLevel, const std::vector<bool>& isShared) const
+{
+    // the clusters are aligned to the grid, and only the few covering the tile's box are stored
+    float clusterSize = cellSize_ * static_cast<float>(1u << lodLevel);
+    int firstX = static_cast<int>(std::floor((tile.min_.x - gridMinX_) / clusterSize));
+    int firstZ = static_cast<int>(std::floor((tile.min_.z - gridMinZ_) / clusterSize));
+    int clustersX = static_cast<int>(std::floor((tile.max_.x - gridMinX_) / clusterSize)) - firstX + 1;
+    int clustersZ = static_cast<int>(std::floor((tile.max_.z - gridMinZ_) / clusterSize)) - firstZ + 1;
+    auto clusterOf = [&](const gsl::Vector3D& position, float& distanceToCenter)
+    {
+        float clusterX = (position.x - gridMinX_) / clusterSize;
+        float clusterZ = (position.z - gridMinZ_) / clusterSize;
+        int x = std::min(clustersX - 1, std::max(0, static_cast<int>(std::floor(clusterX)) - firstX));
+        int z = std::min(clustersZ - 1, std::max(0, static_cast<int>(std::floor(clusterZ)) - firstZ));
+        float offsetX = clusterX - (firstX + x) - 0.5f;
+        float offsetZ = clusterZ - (firstZ + z) - 0.5f;
+        distanceToCenter = offsetX * offsetX + offsetZ * offsetZ;
+        return static_cast<size_t>(x + z * clustersX);
+    };
+
+    const GLuint noVertex = static_cast<GLuint>(-1);
+    std::vector<GLuint> clusters(static_cast<size_t>(clustersX * clustersZ), noVertex);
+    std::vector<float> clusterDistances(clusters.size(), HUGE_VALF);
+    for (GLuint index : tile.indices_[0])
+    {
+        if (isShared[index])
+            continue;
+        float distance;
+        size_t cluster = clusterOf(vertices_[index].XYZ_, distance);
+        if (distance < clusterDistances[cluster])
+        {
+            clusters[cluster] = index;
+            clusterDistances[cluster] = distance;
+        }
+    }
+
+    const std::vector<GLuint>& source = tile.indices_[0];
+    std::vector<GLuint>& result = tile.indices_[lodLevel];
+    result.clear();
+    for (size_t triangle = 0; triangle + 2 < source.size(); triangle += 3)
+    {
+        GLuint merged[3];
+        for (size_t corner = 0; corner < 3; corner++)
+        {
+            GLuint index = source[triangle + corner];
+            float distance;
+            merged[corner] = isShared[index] ? index : clusters[clusterOf(vertices_[index].XYZ_, distance)];
+        }
+        float originalArea = AreaXZ(vertices_[source[triangle]].XYZ_, vertices_[source[triangle + 1]].XYZ_, vertices_[source[triangle + 2]].XYZ_);
+        float mergedArea = AreaXZ(vertices_[merged[0]].XYZ_, vertices_[merged[1]].XYZ_, vertices_[merged[2]].XYZ_);
+        if (mergedArea == 0.f || (mergedArea > 0.f) != (originalArea > 0.f))
+            continue;
+        result.insert(result.end(), merged, merged + 3);
+    }
+
+    // a tile made only of border vertices can't be simplified, and should never disappear
+    if (result.empty())
+        result = tile.indices_[lodLevel - 1];
+}
+
+bool Landscape::FindCell(float x, float z, size_t& cell) const
+{
+    if (cellsX_ == 0 || x < gridMinX_ || z < gridMinZ_ ||
+            x > gridMinX_ + cellsX_ * cellSize_ || z > gridMinZ_ + cellsZ_ * cellSize_)
+        return false;
+
+    int cellX = std::min(cellsX_ - 1, CellCoordinate(x, gridMinX_));
+    int cellZ = std::min(cellsZ_ - 1, CellCoordinate(z, gridMinZ_));
+    cell = static_cast<size_t>(cellX + cellZ * cellsX_);
+    return true;
+}
+
+bool Landscape::HeightInCell(size_t cell, float x, float z, float& height) const
+{
+    for (GLuint i = cellStart_[cell]; i < cellStart_[cell + 1]; i++)
+    {
+        GLuint triangle = cellTriangles_[i];
+        const gsl::Vector3D& a = vertices_[indices_[triangle]].XYZ_;
+        const gsl::Vector3D& b = vertices_[indices_[triangle + 1]].XYZ_;
+        const gsl::Vector3D& c = vertices_[indices_[triangle + 2]].XYZ_;
+
+        // signed double areas in XZ, divided by the whole triangle's so either winding works
+        float area = (b.x - a.x) * (c.z - a.z) - (c.x - a.x) * (b.z - a.z);
+        if (area == 0.f)
+            continue;
+        float weightA = ((b.x - x) * (c.z - z) - (c.x - x) * (b.z - z)) / area;
+        float weightB = ((c.x - x) * (a.z - z) - (a.x - x) * (c.z - z)) / area;
+        float weightC = 1.f - weightA - weightB;
+        if (weightA >= -EDGE_TOLERANCE && weightB >= -EDGE_TOLERANCE && weightC >= -EDGE_TOLERANCE)
+        {
+            height = a.y * weightA + b.y * weightB + c.y * weightC;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Landscape::HeightmapHeight(float x, float z, float& height) const
+{
+    float gridX = (x - gridMinX_) / cellSize_;
+    float gridZ = (z - gridMinZ_) / cellSize_;
+    if (gridX < 0.f || gridZ < 0.f || gridX > cellsX_ || gridZ > cellsZ_)
+        return false;
+
+    int cellX = std::min(cellsX_ - 1, static_cast<int>(gridX));
+    int cellZ = std::min(cellsZ_ - 1, static_cast<int>(gridZ));
+    float fractionX = gridX - cellX;
+    float fractionZ = gridZ - cellZ;
+    size_t a = static_cast<size_t>(cellZ) * (cellsX_ + 1) + cellX;
+    size_t c = a + cellsX_ + 1;
+    // the quad is split from b to c, like in SetHeightmap
+    if (fractionX + fractionZ <= 1.f)
+        height = heights_[a] + (heights_[a + 1] - heights_[a]) * fractionX + (heights_[c] - heights_[a]) * fractionZ;
+    else
+        height = heights_[c + 1] + (heights_[c] - heights_[c + 1]) * (1.f - fractionX) + (heights_[a + 1] - heights_[c + 1]) * (1.f - fractionZ);
+    return true;
+}
+
+bool Landscape::GetHeight(float x, float z, float& height) const
+{
+    if (!heights_.empty())
+        return HeightmapHeight(x, z, height);
+    size_t cell;
+    return FindCell(x, z, cell) && HeightInCell(cell, x, z, height);
+}
+
+void Landscape::GetHeights(const std::vector<gsl::Vector3D>& locations, std::vector<float>& heights) const
+{
+    heights.assign(locations.size(), 0.f);
+    if (cellsX_ == 0)
+        return;
+    if (!heights_.empty())
+    {
+        // already constant time per location, and the grid points are read in the order the locations come in
+        for (size_t i = 0; i < locations.size(); i++)
+            HeightmapHeight(locations[i].x, locations[i].z, heights[i]);
+        return;
+    }
+
+    // counting sort of the locations by cell, locations outside the grid are left out
+    const size_t outside = cellStart_.size();
+    queryCells_.resize(locations.size());
+    queryCellStart_.assign(cellStart_.size() + 1, 0);
+    for (size_t i = 0; i < locations.size(); i++)
+    {
+        size_t cell;
+        queryCells_[i] = FindCell(locations[i].x, locations[i].z, cell) ? cell : outside;
+        if (queryCells_[i] != outside)
+            queryCellStart_[cell + 1]++;
+    }
+    for (size_t cell = 1; cell < queryCellStart_.size(); cell++)
+        queryCellStart_[cell] += queryCellStart_[cell - 1];
+
+    size_t queryCount = queryCellStart_.back();
+    queryOrder_.resize(queryCount);
+    queryX_.resize(queryCount);
+    queryZ_.resize(queryCount);
+    for (size_t i = 0; i < locations.size(); i++)
+    {
+        if (queryCells_[i] == outside)
+            continue;
+        // the start of each cell is moved forward as it is filled, and ends up at the start of the next cell
+        size_t sorted = queryCellStart_[queryCells_[i]]++;
+        queryOrder_[sorted] = i;
+        queryX_[sorted] = locations[i].x;
+        queryZ_[sorted] = locations[i].z;
+    }
+
+    size_t first = 0;
+    for (size_t cell = 0; cell + 1 < cellStart_.size(); cell++)
+    {
+        size_t last = queryCellStart_[cell];
+        size_t i = first;
+#ifdef GSL_USE_SSE
+        const __m128 tolerance = _mm_set1_ps(-EDGE_TOLERANCE);
+        const __m128 one = _mm_set1_ps(1.f);
+        for (; i + 4 <= last; i += 4)
+        {
+            __m128 x = _mm_loadu_ps(&queryX_[i]);
+            __m128 z = _mm_loadu_ps(&queryZ_[i]);
+            __m128 height = _mm_setzero_ps();
+            __m128 found = _mm_setzero_ps();
+            for (GLuint j = cellStart_[cell]; j < cellStart_[cell + 1]; j++)
+            {
+                GLuint triangle = cellTriangles_[j];
+                const gsl::Vector3D& a = vertices_[indices_[triangle]].XYZ_;
+                const gsl::Vector3D& b = vertices_[indices_[triangle + 1]].XYZ_;
+                const gsl::Vector3D& c = vertices_[indices_[triangle + 2]].XYZ_;
+                float area = (b.x - a.x) * (c.z - a.z) - (c.x - a.x) * (b.z - a.z);
+                if (area == 0.f)
+                    continue;
+
+                __m128 toAX = _mm_sub_ps(_mm_set1_ps(a.x), x), toAZ = _mm_sub_ps(_mm_set1_ps(a.z), z);
+                __m128 toBX = _mm_sub_ps(_mm_set1_ps(b.x), x), toBZ = _mm_sub_ps(_mm_set1_ps(b.z), z);
+                __m128 toCX = _mm_sub_ps(_mm_set1_ps(c.x), x), toCZ = _mm_sub_ps(_mm_set1_ps(c.z), z);
+                __m128 areaVector = _mm_set1_ps(area);
+                __m128 weightA = _mm_div_ps(_mm_sub_ps(_mm_mul_ps(toBX, toCZ), _mm_mul_ps(toCX, toBZ)), areaVector);
+                __m128 weightB = _mm_div_ps(_mm_sub_ps(_mm_mul_ps(toCX, toAZ), _mm_mul_ps(toAX, toCZ)), areaVector);
+                __m128 weightC = _mm_sub_ps(_mm_sub_ps(one, weightA), weightB);
+
+                // the first triangle found wins, like in HeightInCell
+                __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(weightA, tolerance), _mm_cmpge_ps(weightB, tolerance)),
+                                           _mm_cmpge_ps(weightC, tolerance));
+                inside = _mm_andnot_ps(found, inside);
+                __m128 triangleHeight = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(a.y), weightA),
+                                                              _mm_mul_ps(_mm_set1_ps(b.y), weightB)),
+                                                   _mm_mul_ps(_mm_set1_ps(c.y), weightC));
+                height = _mm_or_ps(_mm_and_ps(inside, triangleHeight), _mm_andnot_ps(inside, height));
+                found = _mm_or_ps(found, inside);
+                if (_mm_movemask_ps(found) == 0xF)
+                    break;
+            }
+            float results[4];
+            _mm_storeu_ps(results, height);
+            for (size_t k = 0; k < 4; k++)
+                heights[queryOrder_[i + k]] = results[k];
+        }
+#endif
+        for (; i < last; i++)
+            HeightInCell(cell, queryX_[i], queryZ_[i], heights[queryOrder_[i]]);
+        first = last;
+    }
+}
@@ -0,0 +1,130 @@
+#ifndef LANDSCAPE_H
+#define LANDSCAPE_H
+
+#include <vector>
+#include "vertex.h"
+
+/// One square piece of the landscape, culled and given a LOD level on its own when rendered.
+struct LandscapeTile
+{
+    /// Lowest corner of the tile's world space bounding box.
+    gsl::Vector3D min_;
+    /// Highest corner of the tile's world space bounding box.
+    gsl::Vector3D max_;
+    /**
+     * Triangles of each LOD level, as indices into Landscape::vertices_.
+     * Vertices shared with other tiles are kept in every level, so neighbouring tiles never show cracks.
+     * There are Landscape::tileLODLevels_ levels.
+     */
+    std::vector<std::vector<GLuint>> indices_;
+};
+
+///The terrain of the engine.
+class Landscape
+{
+public:
+    Landscape(){}
+    /// ID of material used by landscape
+    size_t materialID_{3};
+    /// Distance between the points of a heightmap when one is loaded.
+    float heightmapSpacing_{1.f};
+    /// World height of the brightest heightmap value.
+    float heightmapHeightScale_{20.f};
+    /// Number of LOD levels each tile is built with, set from MeshManager::lodTriangleRatios_ so tiles and meshes have chains of the same length.
+    size_t tileLODLevels_{4};
+    /**
+     * The vertex data of tahe landscape.
+     * Used for calculations like Barycentric Coordinates.
+     */
+    std::vector<Vertex> vertices_;
+    /**
+     * The indice data of the landscape.
+     * Used for calculations like Barycentric Coordinates.
+     */
+    std::vector<GLuint> indices_;
+    /// The landscape split in tiles of TILE_CELLS by TILE_CELLS grid cells, rebuilt by SetMesh.
+    std::vector<LandscapeTile> tiles_;
+
+    /**
+     * Replaces the mesh data and rebuilds the height lookup grid and the tiles.
+     * @param vertices New vertex data.
+     * @param indices New indice data, three per triangle.
+     */
+    void SetMesh(std::vector<Vertex> vertices, std::vector<GLuint> indices);
+    /**
+     * Builds the landscape as a regular grid from a heightmap, centered on the world origin.
+     * Vertices and normals are generated on all hardware threads, and the heights are kept for height lookups.
+     * @param heights Height of each grid point, row by row along x, from 0 to 1.
+     * @param columns Number of grid points along x.
+     * @param rows Number of grid points along z.
+     * @param spacing Distance between neighbouring grid points.
+     * @param heightScale World height of a heightmap value of 1.
+     */
+    void SetHeightmap(std::vector<float> heights, int columns, int rows, float spacing, float heightScale);
+    /**
+     * Finds the height of the landscape at a location.
+     * A heightmap landscape reads the two to four grid points around it, a mesh landscape only tests the triangles in its grid cell.
+     * @param x World x coordinate.
+     * @param z World z coordinate.
+     * @param height Set to the height if the location is on the landscape.
+     * @return Whether the location is on the landscape.
+     */
+    bool GetHeight(float x, float z, float& height) const;
+    /**
+     * Finds the heights of many locations in one call.
+     * For a mesh landscape the locations are sorted by grid cell, and each cell's triangles are tested against four of them at a time.
+     * @param locations World locations, only x and z are used.
+     * @param heights Resized to the number of locations, 0 where a location is not on the landscape.
+     */
+    void GetHeights(const std::vector<gsl::Vector3D>& locations, std::vector<float>& heights) const;
+
+private:
+    /// Width of a tile in grid cells.
+    static constexpr int TILE_CELLS = 16;
+
+    /// Puts every triangle in the cells its XZ bounds cover.
+    void BuildGrid();
+    /// Height at a location read from heights_, the same triangles as the generated mesh are interpolated.
+    bool HeightmapHeight(float x, float z, float& height) const;
+    /// Puts every triangle in the tile its center is in, then builds the tiles' LOD levels.
+    void BuildTiles();
+    /**
+     * Builds a LOD level of a tile by vertex clustering in XZ.
+     * The vertices in each cluster are merged into the one closest to the cluster's center,
+     * and triangles that collapse or flip are left out.
+     * @param tile Tile to build the level for, its level 0 must be filled in.
+     * @param lodLevel Level to build, clusters are 2^lodLevel grid cells wide.
+     * @param isShared Whether each vertex is used by more than one tile, those are never moved.
+     */
+    void BuildTileLOD(LandscapeTile& tile, size_t lodLevel, const std::vector<bool>& isShared) const;
+    /// Cell coordinate of a world position along x or z, not clamped to the grid.
+    int CellCoordinate(float value, float gridMin) const;
+    /// Finds the cell of a location, returns false if it is outside the grid.
+    bool FindCell(float x, float z, size_t& cell) const;
+    /// Tests the triangles of one cell, the scalar version of the loop in GetHeights.
+    bool HeightInCell(size_t cell, float x, float z, float& height) const;
+
+    float gridMinX_{0};
+    float gridMinZ_{0};
+    float cellSize_{1};
+    int cellsX_{0};
+    int cellsZ_{0};
+    /**
+     * Triangles of cell x + z * cellsX_ are cellTriangles_[cellStart_[cell]] up to cellStart_[cell + 1].
+     * Stored as the index of the triangle's first entry in indices_.
+     */
+    std::vector<GLuint> cellStart_;
+    std::vector<GLuint> cellTriangles_;
+
+    /// Heights of a heightmap landscape in world units, empty for a mesh landscape which uses the cells instead.
+    std::vector<float> heights_;
+
+    /// Scratch buffers for GetHeights, kept so repeated calls don't allocate.
+    mutable std::vector<size_t> queryCells_;
+    mutable std::vector<size_t> queryCellStart_;
+    mutable std::vector<size_t> queryOrder_;
+    mutable std::vector<float> queryX_;
+    mutable std::vector<float> queryZ_;
+};
+
+#endif // LANDSCAPE_H
@@ -0,0 +1,129 @@
+#include "lightclusters.h"
+
+#include <algorithm>
+#include <cmath>
+#include "Managers/shadermanager.h"
+
+namespace
+{
+/**
+ * Range of tiles a view space box covers along one screen axis.
+ * The box is projected at both its depths, and the tile range is the union of the two.
+ * @param min Lowest coordinate of the box along the axis.
+ * @param max Highest coordinate of the box along the axis.
+ * @param nearDepth Depth of the box' side closest to the camera, must be positive.
+ * @param farDepth Depth of the box' side furthest from the camera.
+ * @param projectionScale The projection matrix' scale for the axis, cot(fov / 2) for y.
+ * @param count Number of tiles along the axis.
+ */
+std::pair<int, int> TileRange(float min, float max, float nearDepth, float farDepth, float projectionScale, int count)
+{
+    // x / depth is smallest at the near side when x is negative and at the far side when it is positive, and the other way around
+    float ndcMin = projectionScale * std::min(min / nearDepth, min / farDepth);
+    float ndcMax = projectionScale * std::max(max / nearDepth, max / farDepth);
+    int first = static_cast<int>(std::floor((ndcMin * 0.5f + 0.5f) * count));
+    int last = static_cast<int>(std::floor((ndcMax * 0.5f + 0.5f) * count));
+    return {std::max(first, 0), std::min(last, count - 1)};
+}
+
+/// Squared distance from a point to the closest point of an interval, 0 inside it.
+float DistanceSquared(float value, float min, float max)
+{
+    float distance = value < min ? min - value : (value > max ? value - max : 0.f);
+    return distance * distance;
+}
+}
+
+void LightClusters::Build(const PointLightData* lights, size_t lightCount, const Camera& camera)
+{
+    const size_t clusterCount = static_cast<size_t>(countX_ * countY_ * countZ_);
+    const float nearPlane = camera.nearPlane_;
+    const float farPlane = camera.farPlane_;
+    const gsl::Matrix4x4& view = camera.viewMatrix_;
+    const float scaleX = camera.projectionMatrix_(0, 0);
+    const float scaleY = camera.projectionMatrix_(1, 1);
+
+    // slice k starts at near * (far / near)^(k / countZ), so the slice of a depth is log(depth) * depthScale_ - depthBias_
+    const float logDepthRange = std::log(farPlane / nearPlane);
+    depthScale_ = countZ_ / logDepthRange;
+    depthBias_ = countZ_ * std::log(nearPlane) / logDepthRange;
+    sliceDepths_.resize(static_cast<size_t>(countZ_) + 1);
+    for (int slice = 0; slice <= countZ_; slice++)
+        sliceDepths_[static_cast<size_t>(slice)] = nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(slice) / countZ_);
+    auto depthSlice = [&](float depth){ return std::min(std::max(static_cast<int>(std::floor(std::log(depth) * depthScale_ - depthBias_)), 0), countZ_ - 1); };
+
+    assignedClusters_.clear();
+    assignedLights_.clear();
+    for (size_t light = 0; light < lightCount; light++)
+    {
+        const gsl::Vector3D& position = lights[light].position;
+        float radius = lights[light].radius;
+        gsl::Vector3D center(view(0, 0) * position.x + view(0, 1) * position.y + view(0, 2) * position.z + view(0, 3),
+                             view(1, 0) * position.x + view(1, 1) * position.y + view(1, 2) * position.z + view(1, 3),
+                             view(2, 0) * position.x + view(2, 1) * position.y + view(2, 2) * position.z + view(2, 3));
+        float depth = -center.z;
+        if (depth + radius < nearPlane || depth - radius > farPlane)
+            continue;
+
+        float nearDepth = std::max(depth - radius, nearPlane);
+        float farDepth = std::min(depth + radius, farPlane);
+        int firstSlice = depthSlice(nearDepth);
+        int lastSlice = depthSlice(farDepth);
+
+        // the projected box is only bounded in front of the camera, a light reaching behind the near plane can cover any tile
+        std::pair<int, int> tilesX{0, countX_ - 1};
+        std::pair<int, int> tilesY{0, countY_ - 1};
+        if (depth - radius > nearPlane)
+        {
+            tilesX = TileRange(center.x - radius, center.x + radius, depth - radius, depth + radius, scaleX, countX_);
+            tilesY = TileRange(center.y - radius, center.y + radius, depth - radius, depth + radius, scaleY, countY_);
+        }
+
+        for (int z = firstSlice; z <= lastSlice; z++)
+        {
+            float sliceNear = sliceDepths_[static_cast<size_t>(z)];
+            float sliceFar = sliceDepths_[static_cast<size_t>(z) + 1];
+            float depthDistance = DistanceSquared(depth, sliceNear, sliceFar);
+            for (int y = tilesY.first; y <= tilesY.second; y++)
+            {
+                // the cluster's view space box holds the tile's frustum between both depths of the slice
+                float ndcBottom = 2.f * y / countY_ - 1.f;
+                float ndcTop = 2.f * (y + 1) / countY_ - 1.f;
+                float boxBottom = std::min(ndcBottom * sliceNear, ndcBottom * sliceFar) / scaleY;
+                float boxTop = std::max(ndcTop * sliceNear, ndcTop * sliceFar) / scaleY;
+                float rowDistance = depthDistance + DistanceSquared(center.y, boxBottom, boxTop);
+                if (rowDistance > radius * radius)
+                    continue;
+                for (int x = tilesX.first; x <= tilesX.second; x++)
+                {
+                    float ndcLeft = 2.f * x / countX_ - 1.f;
+                    float ndcRight = 2.f * (x + 1) / countX_ - 1.f;
+                    float boxLeft = std::min(ndcLeft * sliceNear, ndcLeft * sliceFar) / scaleX;
+                    float boxRight = std::max(ndcRight * sliceNear, ndcRight * sliceFar) / scaleX;
+                    if (rowDistance + DistanceSquared(center.x, boxLeft, boxRight) > radius * radius)
+                        continue;
+                    assignedClusters_.push_back(static_cast<GLuint>(x + countX_ * (y + countY_ * z)));
+                    assignedLights_.push_back(static_cast<GLuint>(light));
+                }
+            }
+        }
+    }
+
+    // counting sort of the assignments by cluster, which keeps the lights of each cluster in order
+    clusters_.assign(clusterCount * 2, 0);
+    for (GLuint cluster : assignedClusters_)
+        clusters_[cluster * 2 + 1]++;
+    GLuint offset = 0;
+    for (size_t cluster = 0; cluster < clusterCount; cluster++)
+    {
+        clusters_[cluster * 2] = offset;
+        offset += clusters_[cluster * 2 + 1];
+    }
+    lightIndices_.resize(assignedLights_.size());
+    std::vector<GLuint> filled(clusterCount, 0);
+    for (size_t i = 0; i < assignedClusters_.size(); i++)
+    {
+        GLuint cluster = assignedClusters_[i];
+        lightIndices_[clusters_[cluster * 2] + filled[cluster]++] = assignedLights_[i];
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef LIGHTCLUSTERS_H
+#define LIGHTCLUSTERS_H
+
+#include <vector>
+#include "Legacy/innpch.h"
+
+class Camera;
+struct PointLightData;
+
+/**
+ * Assigns point lights to clusters of the view frustum for clustered forward shading.
+ * The screen is split into countX_ by countY_ tiles and the depth between the camera's near and far plane into countZ_ slices,
+ * thinner close to the camera. Each fragment then only loops over the lights in its cluster instead of all of them.
+ */
+class LightClusters
+{
+public:
+    /// Number of tiles across the screen.
+    int countX_{16};
+    /// Number of tiles up the screen.
+    int countY_{9};
+    /// Number of depth slices, spaced exponentially from the near to the far plane.
+    int countZ_{24};
+
+    /// Two values per cluster, where its lights start in lightIndices_ and how many there are.
+    /// Clusters are ordered x first, then y, then z.
+    std::vector<GLuint> clusters_;
+    /// Indices of the lights in each cluster, one cluster after another.
+    std::vector<GLuint> lightIndices_;
+    /// Multiplied with log(depth) in the shader to find the depth slice.
+    float depthScale_{0.f};
+    /// Subtracted after depthScale_ to find the depth slice, log(near) * depthScale_.
+    float depthBias_{0.f};
+
+    /**
+     * Finds the clusters each light reaches.
+     * A light is put in every cluster whose view space box its sphere of radius PointLightData::radius touches.
+     * @param lights Point lights with positions in world space.
+     * @param lightCount Number of lights.
+     * @param camera Camera whose view and projection matrices the clusters are made from.
+     */
+    void Build(const PointLightData* lights, size_t lightCount, const Camera& camera);
+
+private:
+    /// Depth where each slice starts, and the far plane last.
+    std::vector<float> sliceDepths_;
+    /// Cluster of each light to cluster assignment, kept between frames so its memory is reused.
+    std::vector<GLuint> assignedClusters_;
+    /// Light of each light to cluster assignment.
+    std::vector<GLuint> assignedLights_;
+};
+
+#endif // LIGHTCLUSTERS_H
@@ -1,5 +1,46 @@
 #include "meshmanager.h"
+#include "Managers/landscape.h"
+#include "Managers/meshoptimizer.h"
+#include "Managers/meshsimplifier.h"
 #include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <cstring>
+#include <unordered_map>
+
+namespace
+{
+/// Path of the file holding a LOD level, Tractor.obj has its level 1 in Tractor_L01.obj.
+QString LODFilePath(QString filePath, size_t lodLevel)
+{
+    if (lodLevel > 0)
+        filePath.insert(filePath.lastIndexOf("."), (lodLevel < 10 ? "_L0" : "_L") + QString::number(lodLevel));
+    return filePath;
+}
+
+/**
+ * Finds the share of LOD 0's triangles MeshSimplifier keeps when generating a LOD level.
+ * @param filePath Source file of LOD 0.
+ * @param lodLevel Level to check.
+ * @param isIndexed Whether LOD 0 is indexed, unindexed meshes are not simplified.
+ * @param generateLODs Whether missing LOD levels are generated at all.
+ * @param lodTriangleRatios Share of triangles for each level.
+ * @return The share, 0 if the level has a file of its own or is not generated.
+ */
+float GeneratedLODRatio(const QString& filePath, size_t lodLevel, bool isIndexed, bool generateLODs, const std::vector<float>& lodTriangleRatios)
+{
+    if (lodLevel == 0 || !isIndexed || !generateLODs || lodLevel >= lodTriangleRatios.size() || QFile::exists(LODFilePath(filePath, lodLevel)))
+        return 0.f;
+    return lodTriangleRatios[lodLevel];
+}
+
+/// Whether a mesh has a LOD level, from a file of its own or generated.
+bool HasLODLevel(const QString& filePath, size_t lodLevel, bool isIndexed, bool generateLODs, const std::vector<float>& lodTriangleRatios)
+{
+    return lodLevel == 0 || QFile::exists(LODFilePath(filePath, lodLevel))
+            || GeneratedLODRatio(filePath, lodLevel, isIndexed, generateLODs, lodTriangleRatios) > 0.f;
+}
+}
 
 MeshManager::MeshManager()
 {
@@ -48,188 +89,547 @@ void MeshManager::AddMesh(MeshType meshType, QString filePath)
 
 
         QString fileExtension = filePath.section('.', -1).toLower();
-
-        if(fileExtension == "obj")
-            data = readOBJFile(filePath.toStdString());
-        else if(fileExtension == "txt")
-            data.first = ReadTXTFile(filePath);
-        else
+        if(fileExtension != "obj" && fileExtension != "txt")
             return;
 
-        meshes_.push_back(std::make_shared<Mesh>(fileName, meshType, makeCollisionBox(data.first)));
-
-        if(QFile::exists(filePath))
-            UpdateMesh(meshes_.size() - 1, data.first, 0, data.second);
-
-        QString lod1filePath = filePath;
-        lod1filePath.insert(lod1filePath.lastIndexOf("."), "_L01");
+        if(ReadCookedMesh(filePath, fileName, meshType))
+            return;
 
-        if(QFile::exists(lod1filePath))
+        // the main file is always read, readOBJFile copies it into the mesh folder if it is somewhere else
+        std::vector<std::vector<Vertex>> vertices;
+        std::vector<std::vector<GLuint>> indices;
+        for(size_t lodLevel = 0; HasLODLevel(filePath, lodLevel, !indices.empty() && !indices[0].empty(), generateLODs_, lodTriangleRatios_); lodLevel++)
         {
+            QString lodFilePath = LODFilePath(filePath, lodLevel);
+            if(lodLevel > 0 && !QFile::exists(lodFilePath))
+            {
+                // levels without a file of their own are simplified from LOD 0
+                vertices.emplace_back();
+                indices.emplace_back();
+                MeshSimplifier::Simplify(vertices[0], indices[0], lodTriangleRatios_[lodLevel], vertices.back(), indices.back());
+                continue;
+            }
             if(fileExtension == "obj")
-                data = readOBJFile(lod1filePath.toStdString());
-            else if(fileExtension == "txt")
-                data.first = ReadTXTFile(lod1filePath);
-            UpdateMesh(meshes_.size() - 1, data.first, 1, data.second);
+                data = readOBJFile(lodFilePath.toStdString());
+            else
+                data = std::make_pair(ReadTXTFile(lodFilePath), std::vector<GLuint>());
+            vertices.push_back(std::move(data.first));
+            indices.push_back(std::move(data.second));
         }
-        QString lod2filePath = filePath;
-        lod2filePath.insert(lod2filePath.lastIndexOf("."), "_L02");
-        if(QFile::exists(lod2filePath))
+
+        std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>(fileName, meshType, makeCollisionBox(vertices[0]));
+        meshes_.push_back(mesh);
+
+        for(size_t lodLevel = 0; lodLevel < vertices.size(); lodLevel++)
         {
-            if(fileExtension == "obj")
-                data = readOBJFile(lod2filePath.toStdString());
-            else if(fileExtension == "txt")
-                data.first = ReadTXTFile(lod2filePath);
-            UpdateMesh(meshes_.size() - 1, data.first, 2, data.second);
+            if(vertices[lodLevel].empty())
+                continue;
+            OptimizeMesh(mesh, vertices[lodLevel], indices[lodLevel], static_cast<int>(lodLevel));
+            UploadMesh(mesh, static_cast<int>(lodLevel), vertices[lodLevel].data(), vertices[lodLevel].size(), indices[lodLevel].data(), indices[lodLevel].size());
         }
+        WriteCookedMesh(filePath, *mesh, vertices, indices);
         break;
     }
     }
 }
 
-std::pair <std::vector<Vertex>,std::vector<GLuint>> MeshManager::readOBJFile(std::string fileWithPath)
+namespace
 {
+/// Powers of ten for ParseFloat, enough for any float exponent.
+const double POWERS_OF_TEN[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
 
-    QString fileName = QString::fromStdString(fileWithPath).section('/', -1);
-    if(!QFile::exists(gsl::meshFilePath + fileName))
-    {
-        qDebug() << "File copying from" << QString::fromStdString(fileWithPath) << "to" << (gsl::meshFilePath + fileName);
-        QFile::copy(QString::fromStdString(fileWithPath), gsl::meshFilePath + fileName);
-
-    }
-    std::vector<Vertex> vertices;
-    std::vector<GLuint> indices;
+inline bool IsDigit(char character)
+{
+    return character >= '0' && character <= '9';
+}
 
-    std::ifstream fileIn;
-    fileIn.open (fileWithPath, std::ifstream::in);
-    if(!fileIn)
-        qDebug() << "Could not open file for reading: " << QString::fromStdString(fileWithPath);
+/// Moves cursor past spaces and tabs, but not past the end of the line.
+inline void SkipSpaces(const char*& cursor, const char* end)
+{
+    while (cursor < end && (*cursor == ' ' || *cursor == '\t'))
+        cursor++;
+}
 
-    //One line at a time-variable
-    std::string oneLine;
-    //One word at a time-variable
-    std::string oneWord;
+/// Moves cursor to the start of the next line.
+inline void SkipLine(const char*& cursor, const char* end)
+{
+    while (cursor < end && *cursor != '\n')
+        cursor++;
+    if (cursor < end)
+        cursor++;
+}
 
-    std::vector<gsl::Vector3D> tempVertecies;
-    std::vector<gsl::Vector3D> tempNormals;
-    std::vector<gsl::Vector2D> tempUVs;
+/**
+ * Parses a decimal number like 1, -0.25 or 1.5e-3 without allocating, moving cursor past it.
+ * The first 19 digits are kept exactly, then scaled once in double precision, which is well within float precision.
+ * @return Whether a number was found.
+ */
+bool ParseFloat(const char*& cursor, const char* end, float& value)
+{
+    const char* start = cursor;
+    bool negative = cursor < end && *cursor == '-';
+    if (cursor < end && (*cursor == '-' || *cursor == '+'))
+        cursor++;
+
+    unsigned long long mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool anyDigits = false;
+    for (; cursor < end && IsDigit(*cursor); cursor++, anyDigits = true)
+    {
+        if (digits < 19)
+        {
+            mantissa = mantissa * 10 + static_cast<unsigned long long>(*cursor - '0');
+            if (mantissa != 0)
+                digits++;
+        }
+        else
+            exponent++;
+    }
+    if (cursor < end && *cursor == '.')
+    {
+        for (cursor++; cursor < end && IsDigit(*cursor); cursor++, anyDigits = true)
+        {
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + static_cast<unsigned long long>(*cursor - '0');
+                if (mantissa != 0)
+                    digits++;
+                exponent--;
+            }
+        }
+    }
+    if (!anyDigits)
+    {
+        cursor = start;
+        return false;
+    }
+    if (cursor < end && (*cursor == 'e' || *cursor == 'E'))
+    {
+        const char* exponentStart = cursor++;
+        bool negativeExponent = cursor < end && *cursor == '-';
+        if (cursor < end && (*cursor == '-' || *cursor == '+'))
+            cursor++;
+        if (cursor < end && IsDigit(*cursor))
+        {
+            int written = 0;
+            for (; cursor < end && IsDigit(*cursor); cursor++)
+                written = std::min(written * 10 + (*cursor - '0'), 1000);
+            exponent += negativeExponent ? -written : written;
+        }
+        else
+            cursor = exponentStart;
+    }
 
-    // Varible for constructing the indices vector
-    unsigned int temp_index = 0;
+    double result = static_cast<double>(mantissa);
+    if (mantissa != 0)
+    {
+        // exponents this large are far outside float range, so the steps don't have to be exact
+        for (; exponent > 22; exponent -= 22)
+            result *= 1e22;
+        for (; exponent < -22; exponent += 22)
+            result /= 1e22;
+        if (exponent > 0)
+            result *= POWERS_OF_TEN[exponent];
+        else if (exponent < 0)
+            result /= POWERS_OF_TEN[-exponent];
+    }
+    value = static_cast<float>(negative ? -result : result);
+    return true;
+}
 
-    //Reading one line at a time from file to oneLine
-    while(std::getline(fileIn, oneLine))
+/// Parses a whole number, moving cursor past it. @return Whether a number was found.
+bool ParseInt(const char*& cursor, const char* end, long& value)
+{
+    const char* start = cursor;
+    bool negative = cursor < end && *cursor == '-';
+    if (cursor < end && (*cursor == '-' || *cursor == '+'))
+        cursor++;
+    if (cursor >= end || !IsDigit(*cursor))
     {
-        //Doing a trick to get one word at a time
-        std::stringstream sStream;
-        //Pushing line into stream
-        sStream << oneLine;
-        //Streaming one word out of line
-        oneWord = ""; //resetting the value or else the last value might survive!
+        cursor = start;
+        return false;
+    }
+    long result = 0;
+    for (; cursor < end && IsDigit(*cursor); cursor++)
+        result = result * 10 + (*cursor - '0');
+    value = negative ? -result : result;
+    return true;
+}
 
-        sStream >> oneWord;
+/// Turns a 1 based or negative, relative OBJ index into a 0 based one, or -1 if it is outside the list.
+inline long ResolveIndex(long index, size_t count)
+{
+    long resolved = index < 0 ? static_cast<long>(count) + index : index - 1;
+    return resolved >= 0 && resolved < static_cast<long>(count) ? resolved : -1;
+}
 
-        if (oneWord == "#")
-            continue;
-        if (oneWord == "")
-            continue;
+/// The position, uv and normal indices of a face corner, corners with the same indices share a vertex.
+struct CornerKey
+{
+    long position;
+    long uv;
+    long normal;
+    bool operator==(const CornerKey& other) const
+    {
+        return position == other.position && uv == other.uv && normal == other.normal;
+    }
+};
 
-        if (oneWord == "v")
-        {
-            gsl::Vector3D tempVertex;
-            sStream >> oneWord;
-            tempVertex.x = std::stof(oneWord);
-            sStream >> oneWord;
-            tempVertex.y = std::stof(oneWord);
-            sStream >> oneWord;
-            tempVertex.z = std::stof(oneWord);
+struct CornerKeyHash
+{
+    size_t operator()(const CornerKey& key) const
+    {
+        size_t hash = std::hash<long>()(key.position);
+        hash ^= std::hash<long>()(key.uv) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        hash ^= std::hash<long>()(key.normal) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        return hash;
+    }
+};
 
-            //Vertex made - pushing it into vertex-vector
-            tempVertecies.push_back(tempVertex);
+/**
+ * Parses OBJ text in one pass without allocating per line.
+ * Faces with more than three corners are split in a fan.
+ * Corners that use the same position, uv and normal are welded into one vertex, so the index buffer does the sharing.
+ */
+void ParseOBJ(const char* cursor, const char* end, std::vector<Vertex>& vertices, std::vector<GLuint>& indices)
+{
+    std::vector<gsl::Vector3D> positions;
+    std::vector<gsl::Vector3D> normals;
+    std::vector<gsl::Vector2D> uvs;
+    std::vector<GLuint> faceCorners;
+    std::unordered_map<CornerKey, GLuint, CornerKeyHash> weldedVertices;
+    size_t invalidFaces = 0;
+
+    while (cursor < end)
+    {
+        SkipSpaces(cursor, end);
+        if (cursor >= end)
+            break;
 
-            continue;
+        if (cursor[0] == 'v' && cursor + 1 < end && (cursor[1] == ' ' || cursor[1] == '\t'))
+        {
+            cursor += 1;
+            gsl::Vector3D position;
+            SkipSpaces(cursor, end); ParseFloat(cursor, end, position.x);
+            SkipSpaces(cursor, end); ParseFloat(cursor, end, position.y);
+            SkipSpaces(cursor, end); ParseFloat(cursor, end, position.z);
+            positions.push_back(position);
         }
-        if (oneWord == "vt")
+        else if (cursor[0] == 'v' && cursor + 2 < end && cursor[1] == 't' && (cursor[2] == ' ' || cursor[2] == '\t'))
         {
-            //            qDebug() << "Line is UV-coordinate "  << QString::fromStdString(oneWord) << " ";
-            gsl::Vector2D tempUV;
-            sStream >> oneWord;
-            tempUV.x = std::stof(oneWord);
-            sStream >> oneWord;
-            tempUV.y = std::stof(oneWord);
-
-            //UV made - pushing it into UV-vector
-            tempUVs.push_back(tempUV);
-
-            continue;
+            cursor += 2;
+            gsl::Vector2D uv;
+            SkipSpaces(cursor, end); ParseFloat(cursor, end, uv.x);
+            SkipSpaces(cursor, end); ParseFloat(cursor, end, uv.y);
+            uvs.push_back(uv);
         }
-        if (oneWord == "vn")
+        else if (cursor[0] == 'v' && cursor + 2 < end && cursor[1] == 'n' && (cursor[2] == ' ' || cursor[2] == '\t'))
         {
-            gsl::Vector3D tempNormal;
-            sStream >> oneWord;
-            tempNormal.x = std::stof(oneWord);
-            sStream >> oneWord;
-            tempNormal.y = std::stof(oneWord);
-            sStream >> oneWord;
-            tempNormal.z = std::stof(oneWord);
-
-            //Vertex made - pushing it into vertex-vector
-            tempNormals.push_back(tempNormal);
-            continue;
+            cursor += 2;
+            gsl::Vector3D normal;
+            SkipSpaces(cursor, end); ParseFloat(cursor, end, normal.x);
+            SkipSpaces(cursor, end); ParseFloat(cursor, end, normal.y);
+            SkipSpaces(cursor, end); ParseFloat(cursor, end, normal.z);
+            normals.push_back(normal);
         }
-        if (oneWord == "f")
+        else if (cursor[0] == 'f' && cursor + 1 < end && (cursor[1] == ' ' || cursor[1] == '\t'))
         {
-            //int slash; //used to get the / from the v/t/n - format
-            int index, normal, uv;
-            for(size_t i = 0; i < 3; i++)
+            cursor += 1;
+            // faces come after the positions in practice, and most meshes end up with about one vertex per position
+            if (weldedVertices.empty())
+                weldedVertices.reserve(positions.size());
+            faceCorners.clear();
+            bool valid = true;
+            long position, uv, normal;
+            // corners are v, v/vt, v//vn or v/vt/vn
+            for (SkipSpaces(cursor, end); ParseInt(cursor, end, position); SkipSpaces(cursor, end))
             {
-                sStream >> oneWord;     //one word read
-                std::stringstream tempWord(oneWord);    //to use getline on this one word
-                std::string segment;    //the numbers in the f-line
-                std::vector<std::string> segmentArray;  //temp array of the numbers
-                while(std::getline(tempWord, segment, '/')) //splitting word in segments
+                uv = 0;
+                normal = 0;
+                if (cursor < end && *cursor == '/')
                 {
-                    segmentArray.push_back(segment);
+                    cursor++;
+                    ParseInt(cursor, end, uv);
+                    if (cursor < end && *cursor == '/')
+                    {
+                        cursor++;
+                        ParseInt(cursor, end, normal);
+                    }
                 }
-                index = std::stoi(segmentArray[0]);     //first is vertex
-                if (segmentArray[1] != "")              //second is uv
-                    uv = std::stoi(segmentArray[1]);
-                else
+                long positionIndex = ResolveIndex(position, positions.size());
+                long uvIndex = uv != 0 ? ResolveIndex(uv, uvs.size()) : -1;
+                long normalIndex = normal != 0 ? ResolveIndex(normal, normals.size()) : -1;
+                if (positionIndex < 0 || (uv != 0 && uvIndex < 0) || (normal != 0 && normalIndex < 0))
+                    valid = false;
+                if (!valid)
+                    continue;
+                auto welded = weldedVertices.emplace(CornerKey{positionIndex, uvIndex, normalIndex}, static_cast<GLuint>(vertices.size()));
+                if (welded.second)
                 {
-                    //qDebug() << "No uvs in mesh";       //uv not present
-                    uv = 0;                             //this will become -1 in a couple of lines
+                    vertices.emplace_back(positions[static_cast<size_t>(positionIndex)],
+                                          normalIndex >= 0 ? normals[static_cast<size_t>(normalIndex)] : gsl::Vector3D(0.f, 0.f, 0.f),
+                                          uvIndex >= 0 ? uvs[static_cast<size_t>(uvIndex)] : gsl::Vector2D(0.f, 0.f));
                 }
-                normal = std::stoi(segmentArray[2]);    //third is normal
-
-                //Fixing the indexes
-                //because obj f-lines starts with 1, not 0
-                --index;
-                --uv;
-                --normal;
+                faceCorners.push_back(welded.first->second);
+            }
 
-                if (uv > -1)    //uv present!
-                {
-                    Vertex tempVert(tempVertecies[static_cast<size_t>(index)], tempNormals[static_cast<size_t>(normal)], tempUVs[static_cast<size_t>(uv)]);
-                    vertices.push_back(tempVert);
-                }
-                else            //no uv in mesh data, use 0, 0 as uv
+            if (!valid || faceCorners.size() < 3)
+                invalidFaces++;
+            else
+            {
+                for (size_t corner = 2; corner < faceCorners.size(); corner++)
                 {
-                    Vertex tempVert(tempVertecies[static_cast<size_t>(index)], tempNormals[static_cast<size_t>(normal)], gsl::Vector2D(0.0f, 0.0f));
-                    vertices.push_back(tempVert);
+                    indices.push_back(faceCorners[0]);
+                    indices.push_back(faceCorners[corner - 1]);
+                    indices.push_back(faceCorners[corner]);
                 }
-                indices.push_back(temp_index++);
             }
-
-            //            continue;
         }
+        // comments, groups, materials and anything unknown are skipped
+        SkipLine(cursor, end);
     }
 
-    //beeing a nice boy and closing the file after use
-    fileIn.close();
+    if (invalidFaces > 0)
+        qDebug() << "Skipped" << invalidFaces << "faces with missing or invalid indices";
+}
+}
+
+std::pair <std::vector<Vertex>,std::vector<GLuint>> MeshManager::readOBJFile(std::string fileWithPath)
+{
+
+    QString fileName = QString::fromStdString(fileWithPath).section('/', -1);
+    if(!QFile::exists(gsl::meshFilePath + fileName))
+    {
+        qDebug() << "File copying from" << QString::fromStdString(fileWithPath) << "to" << (gsl::meshFilePath + fileName);
+        QFile::copy(QString::fromStdString(fileWithPath), gsl::meshFilePath + fileName);
+
+    }
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+
+    QFile file(QString::fromStdString(fileWithPath));
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        qDebug() << "Could not open file for reading: " << QString::fromStdString(fileWithPath);
+        return std::make_pair(vertices, indices);
+    }
+
+    // the file is mapped so it is parsed in place, read into memory if the system can't map it
+    const qint64 size = file.size();
+    uchar* mapped = size > 0 ? file.map(0, size) : nullptr;
+    if(mapped)
+    {
+        const char* begin = reinterpret_cast<const char*>(mapped);
+        ParseOBJ(begin, begin + size, vertices, indices);
+        file.unmap(mapped);
+    }
+    else
+    {
+        QByteArray contents = file.readAll();
+        ParseOBJ(contents.constData(), contents.constData() + contents.size(), vertices, indices);
+    }
+    file.close();
     qDebug() << "Obj file read: " << QString::fromStdString(fileWithPath);
 
-    return std::make_pair(vertices, indices);
+    return std::make_pair(std::move(vertices), std::move(indices));
+}
+
+namespace
+{
+/// Identifies a cooked mesh file, the last character is the format version.
+const char COOKED_MAGIC[8] = {'I', 'N', 'N', 'C', 'O', 'O', 'K', '3'};
+
+/// Start of a cooked mesh file, followed by a CookedLODHeader for each LOD level, then the vertices and indices of each level.
+struct CookedMeshHeader
+{
+    char magic_[8];
+    /// sizeof(Vertex) when cooked, the vertices are given to glBufferData as they are stored.
+    quint32 vertexSize_;
+    /// Whether MeshOptimizer ran on the data.
+    quint32 optimized_;
+    quint32 lodCount_;
+    quint32 padding_;
+    /// The eight corners of the mesh's bounding box.
+    float boundingBox_[8][3];
+};
+
+/// Where one LOD level of a cooked mesh came from, and the size of its data.
+struct CookedLODHeader
+{
+    /// Size and last modification time of the level's source file, -1 if there was none.
+    qint64 sourceSize_;
+    qint64 sourceModified_;
+    quint64 vertexCount_;
+    quint64 indexCount_;
+    /// Share of the triangles the level was generated with, 0 if it was not generated.
+    float lodTriangleRatio_;
+    float importedACMR_;
+    float optimizedACMR_;
+    quint32 padding_;
+};
+
+/// Reads the size and last modification time of a file, both -1 if it does not exist.
+void StampSource(const QString& filePath, qint64& size, qint64& modified)
+{
+    QFileInfo info(filePath);
+    size = info.exists() ? info.size() : -1;
+    modified = info.exists() ? info.lastModified().toMSecsSinceEpoch() : -1;
+}
+
+/**
+ * Checks that a cooked mesh was made by this version from the current source files and settings.
+ * @param header Header read from the start of the file.
+ * @param lods LOD headers read after it.
+ * @param fileSize Size of the whole cooked file, must fit the headers and every LOD level's data.
+ * @param filePath Source file of LOD 0.
+ * @param optimized Whether meshes are optimized now, data cooked with the other setting is not used.
+ * @param generateLODs Whether missing LOD levels are generated now.
+ * @param lodTriangleRatios Share of triangles each generated level would be made with now.
+ */
+bool IsCookedMeshCurrent(const CookedMeshHeader& header, const CookedLODHeader* lods, qint64 fileSize, const QString& filePath,
+                         bool optimized, bool generateLODs, const std::vector<float>& lodTriangleRatios)
+{
+    bool isIndexed = lods[0].indexCount_ > 0;
+    quint64 expectedSize = sizeof(CookedMeshHeader) + header.lodCount_ * sizeof(CookedLODHeader);
+    for(size_t lodLevel = 0; lodLevel < header.lodCount_; lodLevel++)
+    {
+        const CookedLODHeader& lod = lods[lodLevel];
+        qint64 size, modified;
+        StampSource(LODFilePath(filePath, lodLevel), size, modified);
+        if(size != lod.sourceSize_ || modified != lod.sourceModified_
+                || GeneratedLODRatio(filePath, lodLevel, isIndexed, generateLODs, lodTriangleRatios) != lod.lodTriangleRatio_)
+            return false;
+        // a damaged header could make the sum below wrap around
+        if(lod.vertexCount_ > static_cast<quint64>(fileSize) || lod.indexCount_ > static_cast<quint64>(fileSize))
+            return false;
+        expectedSize += lod.vertexCount_ * sizeof(Vertex) + lod.indexCount_ * sizeof(GLuint);
+    }
+    // a LOD file added since, or a longer generated chain, makes the cooked chain too short
+    if(HasLODLevel(filePath, header.lodCount_, isIndexed, generateLODs, lodTriangleRatios))
+        return false;
+    return expectedSize == static_cast<quint64>(fileSize);
+}
+}
+
+bool MeshManager::ReadCookedMesh(QString filePath, QString fileName, MeshType meshType)
+{
+    QFile file(filePath + ".cooked");
+    if(!file.exists() || !file.open(QIODevice::ReadOnly))
+        return false;
+
+    // the data is uploaded straight from the mapped file, read into memory if the system can't map it
+    const qint64 size = file.size();
+    QByteArray contents;
+    const char* begin = nullptr;
+    uchar* mapped = size > 0 ? file.map(0, size) : nullptr;
+    if(mapped)
+        begin = reinterpret_cast<const char*>(mapped);
+    else
+    {
+        contents = file.readAll();
+        begin = contents.constData();
+    }
+
+    CookedMeshHeader header;
+    std::vector<CookedLODHeader> lods;
+    bool isCurrent = size >= static_cast<qint64>(sizeof(header));
+    if(isCurrent)
+    {
+        std::memcpy(&header, begin, sizeof(header));
+        isCurrent = std::memcmp(header.magic_, COOKED_MAGIC, sizeof(COOKED_MAGIC)) == 0 && header.vertexSize_ == sizeof(Vertex)
+                && (header.optimized_ != 0) == optimizeMeshes_ && header.lodCount_ > 0
+                && static_cast<quint64>(size) >= sizeof(header) + static_cast<quint64>(header.lodCount_) * sizeof(CookedLODHeader);
+    }
+    if(isCurrent)
+    {
+        lods.resize(header.lodCount_);
+        std::memcpy(lods.data(), begin + sizeof(header), lods.size() * sizeof(CookedLODHeader));
+        isCurrent = IsCookedMeshCurrent(header, lods.data(), size, filePath, optimizeMeshes_, generateLODs_, lodTriangleRatios_);
+    }
+
+    if(isCurrent)
+    {
+        std::shared_ptr<BoundingBox> boundingBox = std::make_shared<BoundingBox>();
+        for(const float* corner : header.boundingBox_)
+            boundingBox->points_.push_back(gsl::Vector3D(corner[0], corner[1], corner[2]));
+        std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>(fileName, meshType, boundingBox);
+        meshes_.push_back(mesh);
+
+        const char* blob = begin + sizeof(header) + lods.size() * sizeof(CookedLODHeader);
+        for(size_t lodLevel = 0; lodLevel < lods.size(); lodLevel++)
+        {
+            const CookedLODHeader& lod = lods[lodLevel];
+            const Vertex* vertices = reinterpret_cast<const Vertex*>(blob);
+            blob += lod.vertexCount_ * sizeof(Vertex);
+            const GLuint* indices = reinterpret_cast<const GLuint*>(blob);
+            blob += lod.indexCount_ * sizeof(GLuint);
+            if(lod.vertexCount_ == 0)
+                continue;
+
+            UploadMesh(mesh, static_cast<int>(lodLevel), vertices, lod.vertexCount_, indices, lod.indexCount_);
+            mesh->lods_[lodLevel].importedACMR_ = lod.importedACMR_;
+            mesh->lods_[lodLevel].optimizedACMR_ = lod.optimizedACMR_;
+        }
+        qDebug() << "Cooked mesh read: " << file.fileName();
+    }
+
+    if(mapped)
+        file.unmap(mapped);
+    file.close();
+    return isCurrent;
+}
+
+void MeshManager::WriteCookedMesh(QString filePath, const Mesh& mesh, const std::vector<std::vector<Vertex>>& vertices, const std::vector<std::vector<GLuint>>& indices)
+{
+    if(!QFile::exists(filePath) || vertices.empty() || mesh.boundingBox_->points_.size() != 8)
+        return;
+
+    CookedMeshHeader header{};
+    std::memcpy(header.magic_, COOKED_MAGIC, sizeof(COOKED_MAGIC));
+    header.vertexSize_ = sizeof(Vertex);
+    header.optimized_ = optimizeMeshes_ ? 1 : 0;
+    header.lodCount_ = static_cast<quint32>(vertices.size());
+    for(size_t corner = 0; corner < 8; corner++)
+    {
+        const gsl::Vector3D& point = mesh.boundingBox_->points_[corner];
+        header.boundingBox_[corner][0] = point.x;
+        header.boundingBox_[corner][1] = point.y;
+        header.boundingBox_[corner][2] = point.z;
+    }
+
+    bool isIndexed = !indices[0].empty();
+    std::vector<CookedLODHeader> lods(vertices.size(), CookedLODHeader{});
+    for(size_t lodLevel = 0; lodLevel < lods.size(); lodLevel++)
+    {
+        CookedLODHeader& lod = lods[lodLevel];
+        StampSource(LODFilePath(filePath, lodLevel), lod.sourceSize_, lod.sourceModified_);
+        lod.lodTriangleRatio_ = GeneratedLODRatio(filePath, lodLevel, isIndexed, generateLODs_, lodTriangleRatios_);
+        lod.vertexCount_ = vertices[lodLevel].size();
+        lod.indexCount_ = indices[lodLevel].size();
+        if(lodLevel < mesh.lods_.size())
+        {
+            lod.importedACMR_ = mesh.lods_[lodLevel].importedACMR_;
+            lod.optimizedACMR_ = mesh.lods_[lodLevel].optimizedACMR_;
+        }
+    }
 
+    QFile file(filePath + ".cooked");
+    if(!file.open(QIODevice::WriteOnly))
+    {
+        qDebug() << "Could not open file for writing: " << file.fileName();
+        return;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(lods.data()), static_cast<qint64>(lods.size() * sizeof(CookedLODHeader)));
+    for(size_t lodLevel = 0; lodLevel < lods.size(); lodLevel++)
+    {
+        file.write(reinterpret_cast<const char*>(vertices[lodLevel].data()), static_cast<qint64>(lods[lodLevel].vertexCount_ * sizeof(Vertex)));
+        file.write(reinterpret_cast<const char*>(indices[lodLevel].data()), static_cast<qint64>(lods[lodLevel].indexCount_ * sizeof(GLuint)));
+    }
+    file.close();
+    qDebug() << "Cooked mesh written: " << file.fileName();
 }
 
 void MeshManager::UpdateMesh(size_t meshID, std::vector<Vertex> vertices, int lodLevel, std::vector<GLuint> indices)
@@ -239,20 +639,40 @@ void MeshManager::UpdateMesh(size_t meshID, std::vector<Vertex> vertices, int lo
 
 void MeshManager::UpdateMesh(std::shared_ptr<Mesh> mesh, std::vector<Vertex> vertices, int lodLevel, std::vector<GLuint> indices)
 {
-    mesh->numberOfVertices_[lodLevel] = vertices.size();
-    mesh->numberOfIndices_[lodLevel] = indices.size();
+    OptimizeMesh(mesh, vertices, indices, lodLevel);
+    UploadMesh(mesh, lodLevel, vertices.data(), vertices.size(), indices.data(), indices.size());
+}
+
+void MeshManager::OptimizeMesh(const std::shared_ptr<Mesh>& mesh, std::vector<Vertex>& vertices, std::vector<GLuint>& indices, int lodLevel)
+{
+    if (mesh->lods_.size() <= static_cast<size_t>(lodLevel))
+        mesh->lods_.resize(static_cast<size_t>(lodLevel) + 1);
+    MeshLOD& lod = mesh->lods_[static_cast<size_t>(lodLevel)];
+    lod.importedACMR_ = MeshOptimizer::ACMR(indices, vertices.size());
+    if (optimizeMeshes_ && indices.size() >= 3)
+        MeshOptimizer::Optimize(vertices, indices);
+    lod.optimizedACMR_ = MeshOptimizer::ACMR(indices, vertices.size());
+}
+
+void MeshManager::UploadMesh(const std::shared_ptr<Mesh>& mesh, int lodLevel, const Vertex* vertices, size_t vertexCount, const GLuint* indices, size_t indexCount)
+{
+    if (mesh->lods_.size() <= static_cast<size_t>(lodLevel))
+        mesh->lods_.resize(static_cast<size_t>(lodLevel) + 1);
+    MeshLOD& lod = mesh->lods_[static_cast<size_t>(lodLevel)];
+    lod.numberOfVertices_ = vertexCount;
+    lod.numberOfIndices_ = indexCount;
 
     //must call this to use OpenGL functions
     initializeOpenGLFunctions();
 
     //Vertex Array Object - VAO
-    glGenVertexArrays( 1, &mesh->VAO_[lodLevel]);
-    glBindVertexArray( mesh->VAO_[lodLevel]);
+    glGenVertexArrays( 1, &lod.VAO_);
+    glBindVertexArray( lod.VAO_);
 
     //Vertex Buffer Object to hold vertices - VBO
-    glGenBuffers( 1, &mesh->VBO_[lodLevel] );
-    glBindBuffer( GL_ARRAY_BUFFER, mesh->VBO_[lodLevel] );
-    glBufferData( GL_ARRAY_BUFFER, static_cast<int>(mesh->numberOfVertices_[lodLevel]*sizeof(Vertex)), vertices.data(), GL_STATIC_DRAW );
+    glGenBuffers( 1, &lod.VBO_ );
+    glBindBuffer( GL_ARRAY_BUFFER, lod.VBO_ );
+    glBufferData( GL_ARRAY_BUFFER, static_cast<int>(lod.numberOfVertices_*sizeof(Vertex)), vertices, GL_STATIC_DRAW );
 
     // 1rst attribute buffer : vertices
     glVertexAttribPointer(0, 3, GL_FLOAT,GL_FALSE, sizeof(Vertex), static_cast<GLvoid*>(nullptr));
@@ -266,63 +686,92 @@ void MeshManager::UpdateMesh(std::shared_ptr<Mesh> mesh, std::vector<Vertex> ver
     glVertexAttribPointer(2, 2,  GL_FLOAT, GL_FALSE, sizeof( Vertex ), reinterpret_cast<GLvoid*>( 6 * sizeof( GLfloat ) ));
     glEnableVertexAttribArray(2);
 
-    if (mesh->numberOfIndices_[lodLevel] > 0)
+    // 4th to 7th attribute buffer : model matrix, one row each, advancing once per instance
+    if (instanceVBO_ == 0)
+    {
+        gsl::Matrix4x4 identity(true);
+        glGenBuffers(1, &instanceVBO_);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO_);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(gsl::Matrix4x4), identity.constData(), GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO_);
+    for (GLuint row = 0; row < 4; row++)
+    {
+        glVertexAttribPointer(3 + row, 4, GL_FLOAT, GL_FALSE, sizeof(gsl::Matrix4x4), reinterpret_cast<GLvoid*>(row * 4 * sizeof(GLfloat)));
+        glEnableVertexAttribArray(3 + row);
+        glVertexAttribDivisor(3 + row, 1);
+    }
+
+    if (lod.numberOfIndices_ > 0)
     {
         //Second buffer - holds the indices (Element Array Buffer - EAB):
-        glGenBuffers(1, &mesh->EAB_[lodLevel]);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->EAB_[lodLevel]);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(mesh->numberOfIndices_[lodLevel] * sizeof(GLuint)), indices.data(), GL_STATIC_DRAW);
+        glGenBuffers(1, &lod.EAB_);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lod.EAB_);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(lod.numberOfIndices_ * sizeof(GLuint)), indices, GL_STATIC_DRAW);
     }
 
-    // BOUNDING BOX TEST
+    glBindVertexArray(0);
+
+    // the bounding box is shared by all LOD levels, so it is only uploaded with the first one
+    if (mesh->boundingBox_ && mesh->boundingBox_->VAO_ == 0)
+        UploadBoundingBox(*mesh->boundingBox_);
+
+    qDebug() << "VAO: " << lod.VAO_ << "bb VAO: " << (mesh->boundingBox_ ? mesh->boundingBox_->VAO_ : 0) << " VBO: " << lod.VBO_ << " EAB: " << lod.EAB_ << "bb VBO: " << (mesh->boundingBox_ ? mesh->boundingBox_->VBO_ : 0);
+}
 
+void MeshManager::UploadBoundingBox(BoundingBox& boundingBox)
+{
     //Vertex Array Object - VAO
-    glGenVertexArrays( 1, &mesh->boundingBox_->VAO_);
-    glBindVertexArray( mesh->boundingBox_->VAO_);
+    glGenVertexArrays( 1, &boundingBox.VAO_);
+    glBindVertexArray( boundingBox.VAO_);
 
     //Vertex Buffer Object to hold vertices - VBO
-    glGenBuffers( 1, &mesh->boundingBox_->VBO_ );
-    glBindBuffer( GL_ARRAY_BUFFER, mesh->boundingBox_->VBO_ );
-    glBufferData( GL_ARRAY_BUFFER, static_cast<int>(mesh->boundingBox_->points_.size()*sizeof(gsl::Vector3D)), mesh->boundingBox_->points_.data(), GL_STATIC_DRAW );
+    glGenBuffers( 1, &boundingBox.VBO_ );
+    glBindBuffer( GL_ARRAY_BUFFER, boundingBox.VBO_ );
+    glBufferData( GL_ARRAY_BUFFER, static_cast<int>(boundingBox.points_.size()*sizeof(gsl::Vector3D)), boundingBox.points_.data(), GL_STATIC_DRAW );
 
     // 1rst attribute buffer : vertices
     glVertexAttribPointer(0, 3, GL_FLOAT,GL_FALSE, sizeof(gsl::Vector3D), static_cast<GLvoid*>(nullptr));
     glEnableVertexAttribArray(0);
 
     // indices
-    glGenBuffers(1, &mesh->boundingBox_->EAB_);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->boundingBox_->EAB_);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(mesh->boundingBox_->indices_.size() * sizeof(GLuint)), mesh->boundingBox_->indices_.data(), GL_STATIC_DRAW);
+    glGenBuffers(1, &boundingBox.EAB_);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, boundingBox.EAB_);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(boundingBox.indices_.size() * sizeof(GLuint)), boundingBox.indices_.data(), GL_STATIC_DRAW);
 
-    qDebug() << "VAO: " << mesh->VAO_[lodLevel] << "bb VAO: " << mesh->boundingBox_->VAO_ << " VBO: " << mesh->VBO_[lodLevel] << " EAB: " << mesh->EAB_[lodLevel] << "bb VBO: " << mesh->boundingBox_->VBO_;
     glBindVertexArray(0);
 }
 
 void MeshManager::DeleteMesh(std::shared_ptr<Mesh> mesh)
 {
-    for(int lodLevel = 0; lodLevel < 3; lodLevel++)
+    //must call this to use OpenGL functions
+    initializeOpenGLFunctions();
+
+    for(size_t lodLevel = 0; lodLevel < mesh->lods_.size(); lodLevel++)
     {
-        if (mesh->VAO_[lodLevel] == 0)
+        MeshLOD& lod = mesh->lods_[lodLevel];
+        if (lod.VAO_ == 0)
             continue;
 
-        //must call this to use OpenGL functions
-        initializeOpenGLFunctions();
-
         //Vertex Array Object - VAO
-        glDeleteVertexArrays(1, &mesh->VAO_[lodLevel]);
+        glDeleteVertexArrays(1, &lod.VAO_);
 
         //Vertex Buffer Object to hold vertices - VBO
-        glDeleteBuffers( 1, &mesh->VBO_[lodLevel] );
+        glDeleteBuffers( 1, &lod.VBO_ );
 
 
-        if (mesh->numberOfIndices_[lodLevel] > 0)
+        if (lod.numberOfIndices_ > 0)
         {
             //Second buffer - holds the indices (Element Array Buffer - EAB):
-            glDeleteBuffers(1, &mesh->EAB_[lodLevel]);
+            glDeleteBuffers(1, &lod.EAB_);
         }
 
-        // BOUNDING BOX TEST
+        qDebug() << "Mesh deleted" << mesh->name_ << "Lod level " << lodLevel << "VAO: " << lod.VAO_ << " VBO: " << lod.VBO_ << " EAB: " << lod.EAB_;
+    }
 
+    // BOUNDING BOX TEST
+    if (mesh->boundingBox_ && mesh->boundingBox_->VAO_ != 0)
+    {
         //Vertex Array Object - VAO
         glDeleteVertexArrays( 1, &mesh->boundingBox_->VAO_);
 
@@ -332,7 +781,10 @@ void MeshManager::DeleteMesh(std::shared_ptr<Mesh> mesh)
         // indices
         glDeleteBuffers(1, &mesh->boundingBox_->EAB_);
 
-        qDebug() << "Mesh deleted" << mesh->name_ << "Lod level " << lodLevel << "VAO: " << mesh->VAO_[lodLevel] << "bb VAO: " << mesh->boundingBox_->VAO_ << " VBO: " << mesh->VBO_[lodLevel] << " EAB: " << mesh->EAB_[lodLevel] << "bb VBO: " << mesh->boundingBox_->VBO_;
+        qDebug() << "bb VAO: " << mesh->boundingBox_->VAO_ << "bb VBO: " << mesh->boundingBox_->VBO_;
+        mesh->boundingBox_->VAO_ = 0;
+        mesh->boundingBox_->VBO_ = 0;
+        mesh->boundingBox_->EAB_ = 0;
     }
 }
 
@@ -511,15 +963,64 @@ std::shared_ptr<BoundingBox> MeshManager::makeCollisionBox(std::vector<Vertex> v
     return boundingBox;
 }
 
-std::pair<std::vector<Vertex>, std::vector<GLuint> > MeshManager::updateLandscapeMesh(QString fileWithPath)
+bool MeshManager::readHeightmap(QString fileWithPath, std::vector<float>& heights, int& columns, int& rows)
 {
-    QString fileName = fileWithPath.section('/', -1);
-    std::pair<std::vector<Vertex>,std::vector<GLuint>> data;
-    data = readOBJFile(fileWithPath.toStdString());
-    if(!landscapeMesh_)
-        landscapeMesh_ = std::make_shared<Mesh>(fileName, FILE_MESH, makeCollisionBox(data.first));
-    UpdateMesh(landscapeMesh_, data.first, 0, data.second);
-    return data;
+    QImage image(fileWithPath);
+    if (image.isNull())
+    {
+        qDebug() << "Could not read heightmap: " << fileWithPath;
+        return false;
+    }
+    image = image.convertToFormat(QImage::Format_Grayscale16);
+
+    columns = image.width();
+    rows = image.height();
+    heights.resize(static_cast<size_t>(columns) * static_cast<size_t>(rows));
+    for (int z = 0; z < rows; z++)
+    {
+        const quint16* line = reinterpret_cast<const quint16*>(image.constScanLine(z));
+        for (int x = 0; x < columns; x++)
+            heights[static_cast<size_t>(z) * columns + x] = line[x] / 65535.f;
+    }
+    return true;
+}
+
+void MeshManager::UpdateLandscapeTiles(const Landscape& landscape)
+{
+    for (const std::shared_ptr<Mesh>& tile : landscapeTiles_)
+        DeleteMesh(tile);
+    landscapeTiles_.clear();
+
+    // maps the landscape's vertex indices to the tile's, reset after each level
+    const GLuint notInTile = static_cast<GLuint>(-1);
+    std::vector<GLuint> tileIndex(landscape.vertices_.size(), notInTile);
+    for (size_t i = 0; i < landscape.tiles_.size(); i++)
+    {
+        const LandscapeTile& tile = landscape.tiles_[i];
+        std::shared_ptr<Mesh> mesh;
+        for (size_t lodLevel = 0; lodLevel < tile.indices_.size(); lodLevel++)
+        {
+            std::vector<Vertex> vertices;
+            std::vector<GLuint> indices;
+            indices.reserve(tile.indices_[lodLevel].size());
+            for (GLuint index : tile.indices_[lodLevel])
+            {
+                if (tileIndex[index] == notInTile)
+                {
+                    tileIndex[index] = static_cast<GLuint>(vertices.size());
+                    vertices.push_back(landscape.vertices_[index]);
+                }
+                indices.push_back(tileIndex[index]);
+            }
+            for (GLuint index : tile.indices_[lodLevel])
+                tileIndex[index] = notInTile;
+
+            if (!mesh)
+                mesh = std::make_shared<Mesh>("Landscape tile " + QString::number(i), FILE_MESH, makeCollisionBox(vertices));
+            UpdateMesh(mesh, vertices, static_cast<int>(lodLevel), indices);
+        }
+        landscapeTiles_.push_back(mesh);
+    }
 }
 
 std::pair <std::vector<Vertex>,std::vector<GLuint>> MeshManager::SkyBox()
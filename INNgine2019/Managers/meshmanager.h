@@ -3,6 +3,7 @@
 
 class Shader;
 class Texture;
+class Landscape;
 
 /// Contains BoundingBox data
 struct BoundingBox
@@ -35,6 +36,34 @@ enum MeshType
     SKYBOX_MESH
 };
 
+/// The OpenGL buffers of one level of detail of a mesh.
+struct MeshLOD
+{
+    /// Vertex Array Object.
+    /// Stores info on how to interpret the data in the VBO.
+    uint VAO_{0};
+    /// Vertex Buffer Object.
+    /// Stores the actual data on how to render the mesh, such as vertices.
+    uint VBO_{0};
+    /// Element Array Buffer.
+    /// Optional, stores the order of vertices in indiced mesh.
+    uint EAB_{0};
+
+    /// Total number of vertices.
+    /// Ussed with glDrawArrays.
+    size_t numberOfVertices_{0};
+    /// Total number of indices.
+    /// Used with glDrawElements.
+    size_t numberOfIndices_{0};
+    /// Average cache miss ratio as imported, see MeshOptimizer::ACMR.
+    float importedACMR_{0};
+    /// Average cache miss ratio after MeshOptimizer, the same as importedACMR_ if it did not run.
+    float optimizedACMR_{0};
+
+    /// Number of triangles drawn, from the indices or from the vertices of an unindexed mesh.
+    size_t TriangleCount() const { return (numberOfIndices_ > 0 ? numberOfIndices_ : numberOfVertices_) / 3; }
+};
+
 /// Contains mesh data.
 struct Mesh
 {
@@ -46,22 +75,8 @@ struct Mesh
     /// Used to define some exceptions when rendering specific mesh types.
     MeshType meshType_;
     
-    /// Vertex Array Object, one for each LOD.
-    /// Stores info on how to interpret the data in the VBO.
-    uint VAO_[3]{0};
-    /// Vertex Buffer Object, one for each LOD.
-    /// Stores the actual data on how to render the mesh, such as vertices.
-    uint VBO_[3]{0};
-    /// Element Array Buffer, one for each LOD.
-    /// Optional, stores the order of vertices in indiced mesh.
-    uint EAB_[3]{0};
-    
-    /// Total number of vertices, one for each LOD.
-    /// Ussed with glDrawArrays.
-    size_t numberOfVertices_[3]{0};
-    /// Total number of indices, one for each LOD.
-    /// Used with glDrawElements.
-    size_t numberOfIndices_[3]{0};
+    /// The levels of detail, from full detail at 0 to fewer triangles at each level after it.
+    std::vector<MeshLOD> lods_;
     
     /// The bounding box of the mesh.
     std::shared_ptr<BoundingBox> boundingBox_;
@@ -76,10 +91,24 @@ public:
     const size_t numberOfDefaultMeshes_{2};
     /// Mesh for all cameras
     std::shared_ptr<Mesh> cameraMesh_{nullptr};
-    /// Mesh for landscape
-    std::shared_ptr<Mesh> landscapeMesh_{nullptr};
+    /// Meshes for the landscape tiles, in the same order as Landscape::tiles_, with one LOD level for each level of the tile.
+    std::vector<std::shared_ptr<Mesh>> landscapeTiles_;
     /// Vector containing all meshes.
     std::vector<std::shared_ptr<Mesh>> meshes_;
+    /// Whether UpdateMesh reorders indexed meshes with MeshOptimizer before uploading them.
+    bool optimizeMeshes_{true};
+    /// Whether AddMesh generates LOD levels that have no _L01, _L02, ... file with MeshSimplifier.
+    bool generateLODs_{true};
+    /**
+     * Share of LOD 0's triangles each generated LOD level keeps, the first entry is LOD 0 itself.
+     * Its length is how many levels are generated, longer chains are kept if there are more LOD files.
+     */
+    std::vector<float> lodTriangleRatios_{1.f, 0.5f, 0.25f, 0.125f};
+    /**
+     * Buffer with one model matrix per instance, attached to attribute 3 to 6 of every mesh' VAOs.
+     * Refilled by the RenderSystem before each instanced draw, shaders that are not instanced ignore it.
+     */
+    GLuint instanceVBO_{0};
 
     /**
      * Reads vertex data from OBJ file.
@@ -87,8 +116,20 @@ public:
      * @return Vertex data read from obj file.
      */
     static std::pair<std::vector<Vertex>, std::vector<GLuint> > readOBJFile(std::string fileWithPath);
+    /**
+     * Reads a grayscale heightmap image, converted to 16 bits per pixel so 16 bit images keep their precision.
+     * @param fileWithPath FilePath of the image to read from.
+     * @param heights Set to the value of each pixel from 0 to 1, row by row.
+     * @param columns Set to the width of the image.
+     * @param rows Set to the height of the image.
+     * @return Whether the image could be read.
+     */
+    static bool readHeightmap(QString fileWithPath, std::vector<float>& heights, int& columns, int& rows);
     /**
      * Adds single mesh to meshes_.
+     * File meshes are cooked to a binary file next to the source the first time, later loads map that file instead of parsing.
+     * LOD levels are read from Name_L01, Name_L02 and so on until one is missing,
+     * and levels without a file of their own are generated when generateLODs_ is set.
      * @param meshType How to read the mesh.
      * @param filePath Filepath or filename(if placed in gsl::assetFilePath + "Meshes/" folder) of mesh data.
      * @return The newly created mesh, or an old one of duplicate found.
@@ -110,11 +151,11 @@ public:
      */
     void DeleteAllCustomMeshes();
     /**
-     * Updates landscape mesh.
-     * @param fileWithPath
-     * @return the new vertex and indice data to be used with barycentric coordinates.
+     * Replaces the landscape tile meshes.
+     * Each LOD level only gets the vertices its triangles use.
+     * @param landscape Landscape with the tiles to upload.
      */
-    std::pair<std::vector<Vertex>, std::vector<GLuint> > updateLandscapeMesh(QString fileWithPath);
+    void UpdateLandscapeTiles(const Landscape& landscape);
 
 private:
     /**
@@ -132,12 +173,47 @@ private:
     void UpdateMesh(size_t meshID, std::vector<Vertex> vertices, int lodLevel = 0, std::vector<GLuint> indices = std::vector<GLuint>());
     /**
      * Update or override existing mesh.
+     * Indexed meshes are run through MeshOptimizer first when optimizeMeshes_ is set.
      * @param mesh
      * @param vertices New Vertex data.
      * @param lodLevel Which lodLevel to update.
      * @param indices Optional, New Indice data.
      */
     void UpdateMesh(std::shared_ptr<Mesh> mesh, std::vector<Vertex> vertices, int lodLevel = 0, std::vector<GLuint> indices = std::vector<GLuint>());
+    /// Records the mesh's ACMR for the LOD level, and runs MeshOptimizer on the data when optimizeMeshes_ is set.
+    void OptimizeMesh(const std::shared_ptr<Mesh>& mesh, std::vector<Vertex>& vertices, std::vector<GLuint>& indices, int lodLevel);
+    /**
+     * Creates the OpenGL buffers of a LOD level from vertex and indice data anywhere in memory.
+     * The mesh's LOD chain is lengthened up to lodLevel if it is shorter.
+     * @param mesh Mesh to update.
+     * @param lodLevel Which lodLevel to update.
+     * @param vertices Vertex data, vertexCount of them.
+     * @param indices Indice data, indexCount of them, may be 0.
+     */
+    void UploadMesh(const std::shared_ptr<Mesh>& mesh, int lodLevel, const Vertex* vertices, size_t vertexCount, const GLuint* indices, size_t indexCount);
+    /**
+     * Creates the OpenGL buffers used to draw a bounding box, once per mesh since all LOD levels share it.
+     * @param boundingBox Bounding box to upload, its VAO_, VBO_ and EAB_ are set.
+     */
+    void UploadBoundingBox(BoundingBox& boundingBox);
+    /**
+     * Adds a mesh to meshes_ from the cooked file next to its source, uploading the mapped data directly.
+     * The cooked file is only used if it was written from source files of the same size and modification time,
+     * with the same optimizeMeshes_ and LOD generation settings.
+     * @param filePath Source file of LOD 0, the cooked file is filePath + ".cooked".
+     * @param fileName Name of the new mesh.
+     * @param meshType Type of the new mesh.
+     * @return Whether the mesh was added, false if the source has to be read instead.
+     */
+    bool ReadCookedMesh(QString filePath, QString fileName, MeshType meshType);
+    /**
+     * Writes the uploaded data of every LOD level and the bounding box next to the source, for ReadCookedMesh to use next time.
+     * @param filePath Source file of LOD 0.
+     * @param mesh Mesh the data was uploaded to.
+     * @param vertices Vertex data of each LOD level, as uploaded.
+     * @param indices Indice data of each LOD level, as uploaded.
+     */
+    void WriteCookedMesh(QString filePath, const Mesh& mesh, const std::vector<std::vector<Vertex>>& vertices, const std::vector<std::vector<GLuint>>& indices);
     /**
      * Creates SkyBox vertex and indice data.
      * @return Vertex and Indices for a SkyBox Mesh.
@@ -0,0 +1,258 @@
+#include "meshoptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+/// Size of the LRU cache simulated while ordering, a bit larger than real caches so the order works on most GPUs.
+constexpr int CACHE_SIZE = 32;
+/// Scores from Tom Forsyth's article, tuned for typical meshes.
+constexpr float CACHE_DECAY_POWER = 1.5f;
+constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+constexpr float VALENCE_BOOST_SCALE = 2.f;
+constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+/**
+ * How much adding a triangle using this vertex is worth.
+ * @param cachePosition Position in the LRU cache, -1 if not in it.
+ * @param remainingTriangles Triangles using the vertex that are not added yet.
+ */
+float VertexScore(int cachePosition, unsigned int remainingTriangles)
+{
+    if (remainingTriangles == 0)
+        return -1.f;
+
+    float score = 0.f;
+    if (cachePosition >= 0)
+    {
+        // the three vertices of the last triangle score the same, so the order they were added in doesn't matter
+        if (cachePosition < 3)
+            score = LAST_TRIANGLE_SCORE;
+        else
+            score = std::pow(1.f - static_cast<float>(cachePosition - 3) / (CACHE_SIZE - 3), CACHE_DECAY_POWER);
+    }
+    // vertices with few triangles left are finished first, so they don't end up needing a cache miss later
+    return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+}
+}
+
+void MeshOptimizer::Optimize(std::vector<Vertex>& vertices, std::vector<GLuint>& indices)
+{
+    if (indices.size() < 3 || vertices.empty())
+        return;
+
+    std::vector<size_t> clusterStarts;
+    OptimizeVertexCache(indices, vertices.size(), clusterStarts);
+    OptimizeOverdraw(vertices, indices, clusterStarts);
+    OptimizeVertexFetch(vertices, indices);
+}
+
+float MeshOptimizer::ACMR(const std::vector<GLuint>& indices, size_t vertexCount, size_t cacheSize)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return 0.f;
+
+    // a vertex is in a FIFO cache if it was one of the last cacheSize vertices put in, hits don't move it
+    std::vector<size_t> insertedAt(vertexCount, 0);
+    size_t insertions = cacheSize + 1;
+    size_t misses = 0;
+    for (size_t i = 0; i < triangleCount * 3; i++)
+    {
+        GLuint index = indices[i];
+        if (insertions - insertedAt[index] > cacheSize)
+        {
+            insertedAt[index] = insertions++;
+            misses++;
+        }
+    }
+    return static_cast<float>(misses) / static_cast<float>(triangleCount);
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<GLuint>& indices, size_t vertexCount, std::vector<size_t>& clusterStarts)
+{
+    const size_t triangleCount = indices.size() / 3;
+    clusterStarts.clear();
+
+    // triangles of each vertex, the first remaining[vertex] of them are the ones not added yet
+    std::vector<unsigned int> remaining(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+        remaining[indices[i]]++;
+    std::vector<size_t> adjacencyStart(vertexCount + 1, 0);
+    for (size_t vertex = 0; vertex < vertexCount; vertex++)
+        adjacencyStart[vertex + 1] = adjacencyStart[vertex] + remaining[vertex];
+    std::vector<unsigned int> adjacency(adjacencyStart.back());
+    {
+        std::vector<size_t> filled(adjacencyStart.begin(), adjacencyStart.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; i++)
+            adjacency[filled[indices[i]]++] = static_cast<unsigned int>(i / 3);
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t vertex = 0; vertex < vertexCount; vertex++)
+        vertexScore[vertex] = VertexScore(-1, remaining[vertex]);
+    std::vector<float> triangleScore(triangleCount);
+    for (size_t triangle = 0; triangle < triangleCount; triangle++)
+        triangleScore[triangle] = vertexScore[indices[triangle * 3]] + vertexScore[indices[triangle * 3 + 1]] + vertexScore[indices[triangle * 3 + 2]];
+    std::vector<bool> added(triangleCount, false);
+
+    std::vector<GLuint> result;
+    result.reserve(triangleCount * 3);
+    // room for the cache plus the three vertices pushed in front before the rest is cut off
+    GLuint cache[CACHE_SIZE + 3];
+    int cacheCount = 0;
+    size_t nextUnadded = 0;
+    size_t bestTriangle = triangleCount;
+
+    while (result.size() < triangleCount * 3)
+    {
+        // no triangle uses the cached vertices, continue with the first one left in the original order
+        if (bestTriangle == triangleCount)
+        {
+            while (added[nextUnadded])
+                nextUnadded++;
+            bestTriangle = nextUnadded;
+            clusterStarts.push_back(result.size() / 3);
+        }
+
+        const GLuint* corners = &indices[bestTriangle * 3];
+        added[bestTriangle] = true;
+        result.insert(result.end(), corners, corners + 3);
+        for (size_t corner = 0; corner < 3; corner++)
+        {
+            GLuint vertex = corners[corner];
+            unsigned int* first = &adjacency[adjacencyStart[vertex]];
+            unsigned int* last = first + remaining[vertex];
+            std::iter_swap(std::find(first, last, static_cast<unsigned int>(bestTriangle)), last - 1);
+            remaining[vertex]--;
+        }
+
+        // the triangle's vertices move to the front, the rest keep their order behind them
+        GLuint newCache[CACHE_SIZE + 3];
+        int newCount = 0;
+        for (size_t corner = 0; corner < 3; corner++)
+            newCache[newCount++] = corners[corner];
+        for (int i = 0; i < cacheCount; i++)
+        {
+            if (cache[i] != corners[0] && cache[i] != corners[1] && cache[i] != corners[2])
+                newCache[newCount++] = cache[i];
+        }
+        for (int i = 0; i < newCount; i++)
+            cachePosition[newCache[i]] = i < CACHE_SIZE ? i : -1;
+
+        // rescore everything that was in the cache, then pick the best triangle using those vertices
+        bestTriangle = triangleCount;
+        float bestScore = -1.f;
+        for (int i = 0; i < newCount; i++)
+        {
+            GLuint vertex = newCache[i];
+            float score = VertexScore(cachePosition[vertex], remaining[vertex]);
+            float change = score - vertexScore[vertex];
+            vertexScore[vertex] = score;
+            for (size_t j = adjacencyStart[vertex]; j < adjacencyStart[vertex] + remaining[vertex]; j++)
+                triangleScore[adjacency[j]] += change;
+        }
+        for (int i = 0; i < std::min(newCount, CACHE_SIZE); i++)
+        {
+            GLuint vertex = newCache[i];
+            for (size_t j = adjacencyStart[vertex]; j < adjacencyStart[vertex] + remaining[vertex]; j++)
+            {
+                unsigned int triangle = adjacency[j];
+                if (triangleScore[triangle] > bestScore)
+                {
+                    bestScore = triangleScore[triangle];
+                    bestTriangle = triangle;
+                }
+            }
+        }
+
+        cacheCount = std::min(newCount, CACHE_SIZE);
+        std::copy(newCache, newCache + cacheCount, cache);
+    }
+    indices.swap(result);
+}
+
+void MeshOptimizer::OptimizeOverdraw(const std::vector<Vertex>& vertices, std::vector<GLuint>& indices, const std::vector<size_t>& clusterStarts)
+{
+    if (clusterStarts.size() < 2)
+        return;
+
+    const size_t triangleCount = indices.size() / 3;
+    std::vector<gsl::Vector3D> clusterCenters(clusterStarts.size(), gsl::Vector3D(0.f, 0.f, 0.f));
+    std::vector<gsl::Vector3D> clusterNormals(clusterStarts.size(), gsl::Vector3D(0.f, 0.f, 0.f));
+    std::vector<float> clusterAreas(clusterStarts.size(), 0.f);
+    gsl::Vector3D meshCenter(0.f, 0.f, 0.f);
+    float meshArea = 0.f;
+
+    // centers are weighted by area, so a few tiny triangles don't pull them around
+    for (size_t cluster = 0; cluster < clusterStarts.size(); cluster++)
+    {
+        size_t end = cluster + 1 < clusterStarts.size() ? clusterStarts[cluster + 1] : triangleCount;
+        for (size_t triangle = clusterStarts[cluster]; triangle < end; triangle++)
+        {
+            const gsl::Vector3D& a = vertices[indices[triangle * 3]].XYZ_;
+            const gsl::Vector3D& b = vertices[indices[triangle * 3 + 1]].XYZ_;
+            const gsl::Vector3D& c = vertices[indices[triangle * 3 + 2]].XYZ_;
+            gsl::Vector3D normal = gsl::Vector3D::cross(b - a, c - a);
+            float area = normal.length();
+            clusterNormals[cluster] += normal;
+            clusterCenters[cluster] += (a + b + c) * (area / 3.f);
+            clusterAreas[cluster] += area;
+        }
+        meshCenter += clusterCenters[cluster];
+        meshArea += clusterAreas[cluster];
+    }
+    if (meshArea <= 0.f)
+        return;
+    meshCenter = meshCenter * (1.f / meshArea);
+
+    std::vector<float> facingOut(clusterStarts.size(), 0.f);
+    for (size_t cluster = 0; cluster < clusterStarts.size(); cluster++)
+    {
+        float normalLength = clusterNormals[cluster].length();
+        if (clusterAreas[cluster] <= 0.f || normalLength <= 0.f)
+            continue;
+        gsl::Vector3D center = clusterCenters[cluster] * (1.f / clusterAreas[cluster]);
+        facingOut[cluster] = gsl::Vector3D::dot(center - meshCenter, clusterNormals[cluster] * (1.f / normalLength));
+    }
+
+    std::vector<size_t> order(clusterStarts.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b){ return facingOut[a] > facingOut[b]; });
+
+    std::vector<GLuint> result;
+    result.reserve(indices.size());
+    for (size_t cluster : order)
+    {
+        size_t end = cluster + 1 < clusterStarts.size() ? clusterStarts[cluster + 1] : triangleCount;
+        result.insert(result.end(), indices.begin() + static_cast<long>(clusterStarts[cluster] * 3), indices.begin() + static_cast<long>(end * 3));
+    }
+    indices.swap(result);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<GLuint>& indices)
+{
+    const GLuint unused = static_cast<GLuint>(-1);
+    std::vector<GLuint> newIndex(vertices.size(), unused);
+    std::vector<Vertex> result;
+    result.reserve(vertices.size());
+    for (GLuint& index : indices)
+    {
+        if (newIndex[index] == unused)
+        {
+            newIndex[index] = static_cast<GLuint>(result.size());
+            result.push_back(vertices[index]);
+        }
+        index = newIndex[index];
+    }
+    // vertices no triangle uses are kept at the end, so the vertex count doesn't change
+    for (size_t vertex = 0; vertex < vertices.size(); vertex++)
+    {
+        if (newIndex[vertex] == unused)
+            result.push_back(vertices[vertex]);
+    }
+    vertices.swap(result);
+}
@@ -0,0 +1,391 @@
+#include "meshsimplifier.h"
+
+#include <algorithm>
+#include <cstring>
+#include <queue>
+#include <unordered_map>
+
+namespace
+{
+/// How much more moving an open border costs than moving across a surface, keeps holes and outlines in place.
+constexpr double BOUNDARY_WEIGHT = 10.0;
+
+/// Symmetric 4x4 matrix summing squared distances to planes, only the upper triangle is stored.
+struct Quadric
+{
+    double a2{0}, ab{0}, ac{0}, ad{0};
+    double b2{0}, bc{0}, bd{0};
+    double c2{0}, cd{0};
+    double d2{0};
+
+    /// Adds the plane ax + by + cz + d = 0, with (a, b, c) normalized.
+    void AddPlane(double a, double b, double c, double d, double weight)
+    {
+        a2 += weight * a * a; ab += weight * a * b; ac += weight * a * c; ad += weight * a * d;
+        b2 += weight * b * b; bc += weight * b * c; bd += weight * b * d;
+        c2 += weight * c * c; cd += weight * c * d;
+        d2 += weight * d * d;
+    }
+
+    void operator+=(const Quadric& rhs)
+    {
+        a2 += rhs.a2; ab += rhs.ab; ac += rhs.ac; ad += rhs.ad;
+        b2 += rhs.b2; bc += rhs.bc; bd += rhs.bd;
+        c2 += rhs.c2; cd += rhs.cd;
+        d2 += rhs.d2;
+    }
+
+    /// Summed squared distance from the point to the planes.
+    double Error(const gsl::Vector3D& point) const
+    {
+        double x = point.x, y = point.y, z = point.z;
+        return a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+                + b2 * y * y + 2 * bc * y * z + 2 * bd * y
+                + c2 * z * z + 2 * cd * z
+                + d2;
+    }
+};
+
+/// A possible move of position from_ onto position to_, valid while neither has changed since it was queued.
+struct Collapse
+{
+    double error_;
+    GLuint from_;
+    GLuint to_;
+    unsigned int fromVersion_;
+    unsigned int toVersion_;
+
+    bool operator>(const Collapse& rhs) const
+    {
+        return error_ > rhs.error_;
+    }
+};
+
+struct PositionKey
+{
+    uint32_t bits[3];
+    bool operator==(const PositionKey& other) const
+    {
+        return bits[0] == other.bits[0] && bits[1] == other.bits[1] && bits[2] == other.bits[2];
+    }
+};
+
+struct PositionKeyHash
+{
+    size_t operator()(const PositionKey& key) const
+    {
+        size_t hash = std::hash<uint32_t>()(key.bits[0]);
+        hash ^= std::hash<uint32_t>()(key.bits[1]) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        hash ^= std::hash<uint32_t>()(key.bits[2]) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        return hash;
+    }
+};
+
+/// Edge from position a to position b as one number.
+inline uint64_t EdgeKey(GLuint a, GLuint b)
+{
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+/// State of one simplification, positions and triangles are rewritten in place as edges collapse.
+class Simplification
+{
+public:
+    Simplification(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices);
+
+    /// Collapses edges until no more than targetTriangles are left, or no collapse is allowed.
+    void Run(size_t targetTriangles);
+    /// Builds the output mesh, welding corners that ended up with the same vertex and position.
+    void Output(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices,
+                std::vector<Vertex>& simplifiedVertices, std::vector<GLuint>& simplifiedIndices) const;
+
+private:
+    /// Queues the cheaper direction of collapsing the edge between a and b.
+    void QueueEdge(GLuint a, GLuint b);
+    /// Whether moving from onto to keeps every triangle facing the same way and the surface manifold.
+    bool IsCollapseAllowed(GLuint from, GLuint to);
+    void DoCollapse(GLuint from, GLuint to);
+
+    std::vector<gsl::Vector3D> positions_;
+    std::vector<Quadric> quadrics_;
+    std::vector<unsigned int> versions_;
+    std::vector<bool> isRemoved_;
+    /// Triangles of each position, including ones that have since collapsed.
+    std::vector<std::vector<GLuint>> positionTriangles_;
+    /// Three positions per triangle.
+    std::vector<GLuint> triangles_;
+    std::vector<bool> isCollapsed_;
+    size_t triangleCount_{0};
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue_;
+    /// Scratch lists for IsCollapseAllowed.
+    std::vector<GLuint> fromNeighbours_;
+    std::vector<GLuint> toNeighbours_;
+};
+
+Simplification::Simplification(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices)
+{
+    // vertices that only differ in normal or uv are one position, so seams don't split the surface
+    std::vector<GLuint> positionOf(vertices.size());
+    std::unordered_map<PositionKey, GLuint, PositionKeyHash> positionIndex;
+    positionIndex.reserve(vertices.size());
+    for (size_t vertex = 0; vertex < vertices.size(); vertex++)
+    {
+        PositionKey key;
+        std::memcpy(key.bits, &vertices[vertex].XYZ_, sizeof(key.bits));
+        auto inserted = positionIndex.emplace(key, static_cast<GLuint>(positions_.size()));
+        if (inserted.second)
+            positions_.push_back(vertices[vertex].XYZ_);
+        positionOf[vertex] = inserted.first->second;
+    }
+
+    triangleCount_ = indices.size() / 3;
+    triangles_.resize(triangleCount_ * 3);
+    for (size_t corner = 0; corner < triangleCount_ * 3; corner++)
+        triangles_[corner] = positionOf[indices[corner]];
+    isCollapsed_.assign(triangleCount_, false);
+
+    quadrics_.resize(positions_.size());
+    versions_.assign(positions_.size(), 0);
+    isRemoved_.assign(positions_.size(), false);
+    positionTriangles_.resize(positions_.size());
+
+    // triangles weighted by area, and the number of triangles using each edge in each direction to find the borders
+    std::unordered_map<uint64_t, unsigned int> edgeUses;
+    edgeUses.reserve(triangleCount_ * 3);
+    for (size_t triangle = 0; triangle < triangleCount_; triangle++)
+    {
+        const GLuint* corners = &triangles_[triangle * 3];
+        if (corners[0] == corners[1] || corners[1] == corners[2] || corners[2] == corners[0])
+        {
+            isCollapsed_[triangle] = true;
+            continue;
+        }
+        gsl::Vector3D normal = gsl::Vector3D::cross(positions_[corners[1]] - positions_[corners[0]], positions_[corners[2]] - positions_[corners[0]]);
+        float doubleArea = normal.length();
+        if (doubleArea > 0.f)
+        {
+            normal = normal * (1.f / doubleArea);
+            double d = -gsl::Vector3D::dot(normal, positions_[corners[0]]);
+            Quadric plane;
+            plane.AddPlane(normal.x, normal.y, normal.z, d, 0.5 * doubleArea);
+            for (size_t corner = 0; corner < 3; corner++)
+                quadrics_[corners[corner]] += plane;
+        }
+        for (size_t corner = 0; corner < 3; corner++)
+        {
+            positionTriangles_[corners[corner]].push_back(static_cast<GLuint>(triangle));
+            edgeUses[EdgeKey(corners[corner], corners[(corner + 1) % 3])]++;
+        }
+    }
+
+    // a border edge gets a plane through it, standing on its triangle, so collapses can't pull it inwards
+    // edges are matched by direction, so a surface stored twice over still finds its borders
+    for (size_t triangle = 0; triangle < triangleCount_; triangle++)
+    {
+        if (isCollapsed_[triangle])
+            continue;
+        const GLuint* corners = &triangles_[triangle * 3];
+        gsl::Vector3D faceNormal = gsl::Vector3D::cross(positions_[corners[1]] - positions_[corners[0]], positions_[corners[2]] - positions_[corners[0]]);
+        for (size_t corner = 0; corner < 3; corner++)
+        {
+            GLuint a = corners[corner];
+            GLuint b = corners[(corner + 1) % 3];
+            auto reverse = edgeUses.find(EdgeKey(b, a));
+            if (reverse != edgeUses.end() && reverse->second >= edgeUses[EdgeKey(a, b)])
+                continue;
+            gsl::Vector3D edge = positions_[b] - positions_[a];
+            gsl::Vector3D normal = gsl::Vector3D::cross(edge, faceNormal);
+            float length = normal.length();
+            if (length <= 0.f)
+                continue;
+            normal = normal * (1.f / length);
+            double d = -gsl::Vector3D::dot(normal, positions_[a]);
+            Quadric plane;
+            plane.AddPlane(normal.x, normal.y, normal.z, d, BOUNDARY_WEIGHT * gsl::Vector3D::dot(edge, edge));
+            quadrics_[a] += plane;
+            quadrics_[b] += plane;
+        }
+    }
+
+    for (const auto& edge : edgeUses)
+        QueueEdge(static_cast<GLuint>(edge.first >> 32), static_cast<GLuint>(edge.first & 0xffffffff));
+    for (size_t triangle = 0; triangle < triangleCount_; triangle++)
+    {
+        if (isCollapsed_[triangle])
+            triangleCount_--;
+    }
+}
+
+void Simplification::QueueEdge(GLuint a, GLuint b)
+{
+    Quadric sum = quadrics_[a];
+    sum += quadrics_[b];
+    double errorAtA = sum.Error(positions_[a]);
+    double errorAtB = sum.Error(positions_[b]);
+    // errors can come out slightly negative from rounding
+    if (errorAtB <= errorAtA)
+        queue_.push(Collapse{std::max(errorAtB, 0.0), a, b, versions_[a], versions_[b]});
+    else
+        queue_.push(Collapse{std::max(errorAtA, 0.0), b, a, versions_[b], versions_[a]});
+}
+
+bool Simplification::IsCollapseAllowed(GLuint from, GLuint to)
+{
+    fromNeighbours_.clear();
+    toNeighbours_.clear();
+    for (GLuint triangle : positionTriangles_[to])
+    {
+        if (isCollapsed_[triangle])
+            continue;
+        for (size_t corner = 0; corner < 3; corner++)
+            toNeighbours_.push_back(triangles_[triangle * 3 + corner]);
+    }
+
+    for (GLuint triangle : positionTriangles_[from])
+    {
+        if (isCollapsed_[triangle])
+            continue;
+        const GLuint* corners = &triangles_[triangle * 3];
+        if (corners[0] == to || corners[1] == to || corners[2] == to)
+            continue;
+        for (size_t corner = 0; corner < 3; corner++)
+            fromNeighbours_.push_back(corners[corner]);
+
+        // the triangle keeps the same winding, so its normal must not turn more than 90 degrees
+        gsl::Vector3D moved[3];
+        for (size_t corner = 0; corner < 3; corner++)
+            moved[corner] = positions_[corners[corner] == from ? to : corners[corner]];
+        gsl::Vector3D before = gsl::Vector3D::cross(positions_[corners[1]] - positions_[corners[0]], positions_[corners[2]] - positions_[corners[0]]);
+        gsl::Vector3D after = gsl::Vector3D::cross(moved[1] - moved[0], moved[2] - moved[0]);
+        if (gsl::Vector3D::dot(before, after) <= 0.f)
+            return false;
+    }
+
+    // the two positions may only share the opposite corners of the triangles on their edge, otherwise the surface pinches
+    std::sort(fromNeighbours_.begin(), fromNeighbours_.end());
+    fromNeighbours_.erase(std::unique(fromNeighbours_.begin(), fromNeighbours_.end()), fromNeighbours_.end());
+    std::sort(toNeighbours_.begin(), toNeighbours_.end());
+    toNeighbours_.erase(std::unique(toNeighbours_.begin(), toNeighbours_.end()), toNeighbours_.end());
+    size_t shared = 0;
+    for (GLuint neighbour : fromNeighbours_)
+    {
+        if (neighbour != from && neighbour != to && std::binary_search(toNeighbours_.begin(), toNeighbours_.end(), neighbour))
+            shared++;
+    }
+    size_t edgeTriangles = 0;
+    for (GLuint triangle : positionTriangles_[from])
+    {
+        const GLuint* corners = &triangles_[triangle * 3];
+        if (!isCollapsed_[triangle] && (corners[0] == to || corners[1] == to || corners[2] == to))
+            edgeTriangles++;
+    }
+    return edgeTriangles > 0 && shared <= edgeTriangles;
+}
+
+void Simplification::DoCollapse(GLuint from, GLuint to)
+{
+    quadrics_[to] += quadrics_[from];
+    isRemoved_[from] = true;
+    versions_[to]++;
+
+    for (GLuint triangle : positionTriangles_[from])
+    {
+        if (isCollapsed_[triangle])
+            continue;
+        GLuint* corners = &triangles_[triangle * 3];
+        bool hasTo = corners[0] == to || corners[1] == to || corners[2] == to;
+        if (hasTo)
+        {
+            isCollapsed_[triangle] = true;
+            triangleCount_--;
+            continue;
+        }
+        for (size_t corner = 0; corner < 3; corner++)
+        {
+            if (corners[corner] == from)
+                corners[corner] = to;
+        }
+        positionTriangles_[to].push_back(triangle);
+    }
+    positionTriangles_[from].clear();
+    positionTriangles_[from].shrink_to_fit();
+
+    // drop the collapsed triangles from the list, then queue every edge that changed
+    std::vector<GLuint>& toTriangles = positionTriangles_[to];
+    toTriangles.erase(std::remove_if(toTriangles.begin(), toTriangles.end(), [this](GLuint triangle){ return isCollapsed_[triangle]; }), toTriangles.end());
+    for (GLuint triangle : toTriangles)
+    {
+        for (size_t corner = 0; corner < 3; corner++)
+        {
+            GLuint neighbour = triangles_[triangle * 3 + corner];
+            if (neighbour != to)
+                QueueEdge(to, neighbour);
+        }
+    }
+}
+
+void Simplification::Run(size_t targetTriangles)
+{
+    while (triangleCount_ > targetTriangles && !queue_.empty())
+    {
+        Collapse collapse = queue_.top();
+        queue_.pop();
+        if (isRemoved_[collapse.from_] || isRemoved_[collapse.to_]
+                || versions_[collapse.from_] != collapse.fromVersion_ || versions_[collapse.to_] != collapse.toVersion_)
+            continue;
+        // a refused collapse is queued again when a neighbour changes
+        if (!IsCollapseAllowed(collapse.from_, collapse.to_))
+            continue;
+        DoCollapse(collapse.from_, collapse.to_);
+    }
+}
+
+void Simplification::Output(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices,
+                            std::vector<Vertex>& simplifiedVertices, std::vector<GLuint>& simplifiedIndices) const
+{
+    simplifiedVertices.clear();
+    simplifiedIndices.clear();
+    simplifiedIndices.reserve(triangleCount_ * 3);
+
+    // a corner keeps its own vertex's normal and uv, and takes the position it collapsed onto
+    std::unordered_map<uint64_t, GLuint> outputVertex;
+    outputVertex.reserve(triangleCount_ * 3);
+    for (size_t triangle = 0; triangle < isCollapsed_.size(); triangle++)
+    {
+        if (isCollapsed_[triangle])
+            continue;
+        for (size_t corner = triangle * 3; corner < triangle * 3 + 3; corner++)
+        {
+            GLuint position = triangles_[corner];
+            uint64_t key = (static_cast<uint64_t>(position) << 32) | indices[corner];
+            auto inserted = outputVertex.emplace(key, static_cast<GLuint>(simplifiedVertices.size()));
+            if (inserted.second)
+            {
+                Vertex vertex = vertices[indices[corner]];
+                vertex.XYZ_ = positions_[position];
+                simplifiedVertices.push_back(vertex);
+            }
+            simplifiedIndices.push_back(inserted.first->second);
+        }
+    }
+}
+}
+
+void MeshSimplifier::Simplify(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices, float triangleRatio,
+                              std::vector<Vertex>& simplifiedVertices, std::vector<GLuint>& simplifiedIndices)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || vertices.empty())
+    {
+        simplifiedVertices = vertices;
+        simplifiedIndices = indices;
+        return;
+    }
+
+    triangleRatio = std::min(std::max(triangleRatio, 0.f), 1.f);
+    size_t targetTriangles = std::max<size_t>(1, static_cast<size_t>(static_cast<float>(triangleCount) * triangleRatio));
+
+    Simplification simplification(vertices, indices);
+    simplification.Run(targetTriangles);
+    simplification.Output(vertices, indices, simplifiedVertices, simplifiedIndices);
+}
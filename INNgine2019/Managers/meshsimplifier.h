@@ -0,0 +1,30 @@
+#ifndef MESHSIMPLIFIER_H
+#define MESHSIMPLIFIER_H
+
+#include <vector>
+#include "vertex.h"
+
+/**
+ * Makes lower detail versions of indexed triangle meshes, used to generate LOD levels that have no file.
+ * Edges are collapsed in order of their quadric error (Garland and Heckbert), the summed squared distance
+ * to the planes of the original triangles around them, so flat areas are reduced first and the shape is kept.
+ */
+class MeshSimplifier
+{
+public:
+    /**
+     * Simplifies a mesh down to a share of its triangles.
+     * Vertices are joined by position, so meshes with split normals or uvs are simplified as one surface.
+     * Every remaining corner keeps the normal and uv it had, only its position moves.
+     * Collapses that would flip a triangle or pinch the surface are skipped, so the result can have more triangles than asked for.
+     * @param vertices Vertex data of the mesh.
+     * @param indices Indice data of the mesh, three per triangle.
+     * @param triangleRatio Share of the triangles to keep, from 0 to 1.
+     * @param simplifiedVertices Set to the vertex data of the simplified mesh.
+     * @param simplifiedIndices Set to the indice data of the simplified mesh.
+     */
+    static void Simplify(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices, float triangleRatio,
+                         std::vector<Vertex>& simplifiedVertices, std::vector<GLuint>& simplifiedIndices);
+};
+
+#endif // MESHSIMPLIFIER_H
@@ -6,8 +6,7 @@ SceneManager::SceneManager(QTreeWidget* entityTree)
     qDebug() << "\n\nINITIALIZING SCENE MANAGER";
     entityManager_ = std::make_shared<EntityManager>(entityTree);
     componentManager_ = std::make_shared<ComponentManager>();
-    componentManager_->numberOfEntities_ = static_cast<size_t>(entityManager_->numberOfEntities_);
-    componentManager_->ResizeComponentVectors(static_cast<size_t>(entityManager_->numberOfEntities_));
+    componentManager_->ResizeComponentVectors(entityManager_->GetSlotCount());
 }
 
 void SceneManager::TrophiesFromScript()
@@ -16,10 +15,15 @@ void SceneManager::TrophiesFromScript()
 
     if(TrophySpawnerScript_->GetDeleteOldTrophies())
     {
-        for (size_t i = componentManager_->numberOfEntities_ - 1; i != gsl::INVALID_SIZE; i--)
-            if(componentManager_->meshComponents_[i]->objectType_ == TROPHY
-                    || componentManager_->meshComponents_[i]->objectType_ == TAKEN_TROPHY)
-                DeleteEntity(i);
+        std::vector<size_t> oldTrophies;
+        for (size_t slot = 0; slot < componentManager_->meshComponents_.size(); slot++)
+        {
+            ObjectType objectType = componentManager_->meshComponents_[slot].objectType_;
+            if(objectType == TROPHY || objectType == TAKEN_TROPHY)
+                oldTrophies.push_back(componentManager_->meshComponents_.EntityAt(slot));
+        }
+        for (size_t entityID : oldTrophies)
+            DeleteEntity(entityID);
     }
 
 
@@ -59,28 +63,33 @@ void SceneManager::TrophiesFromScript()
 
 
     std::vector<gsl::Vector3D> points = TrophySpawnerScript_->GetTrophiesXZPositions();
+    std::vector<float> heights(points.size(), 0.f);
+    if(AssetManager::GetInstance()->landscape_)
+        AssetManager::GetInstance()->landscape_->GetHeights(points, heights);
     for (size_t i = 0; i < points.size(); i++)
     {
-        entityManager_->AddEntity("ScriptTrophy" + QString::number(i));
-        componentManager_->numberOfEntities_ = static_cast<size_t>(entityManager_->numberOfEntities_);
-        componentManager_->ResizeComponentVectors(static_cast<size_t>(entityManager_->numberOfEntities_));
-        size_t index = componentManager_->numberOfEntities_ - 1;
+        size_t index = entityManager_->AddEntity("ScriptTrophy" + QString::number(i));
+        componentManager_->ResizeComponentVectors(entityManager_->GetSlotCount());
 
         componentManager_->AddComponent(ComponentType::MESH, index);
-        componentManager_->meshComponents_[index]->meshID_ = static_cast<size_t>(meshID);
-        componentManager_->meshComponents_[index]->materialID_ = static_cast<size_t>(materialID);
+        MeshComponent* mesh = componentManager_->meshComponents_.Get(index);
+        mesh->meshID_ = static_cast<size_t>(meshID);
+        mesh->materialID_ = static_cast<size_t>(materialID);
 
-        componentManager_->meshComponents_[index]->objectType_ = TROPHY;
+        mesh->objectType_ = TROPHY;
 
         componentManager_->AddComponent(ComponentType::TRANSFORM, index);
+        TransformComponent* transform = componentManager_->transformComponents_.Get(index);
         gsl::Vector3D position = points[i];
-        position.y = MovementSystem::FindLandscapeYOnLocation(AssetManager::GetInstance()->landscape_, position) + 1;
-        componentManager_->transformComponents_[index]->position_relative_ = {position};
-        componentManager_->transformComponents_[index]->rotation_relative_ = {0, static_cast<GLfloat>(gsl::RandomNumber(0, 180)), 0};
+        position.y = heights[i] + 1;
+        transform->position_relative_ = {position};
+        transform->rotation_relative_ = {0, static_cast<GLfloat>(gsl::RandomNumber(0, 180)), 0};
+        transform->hasChanged_ = true;
 
         componentManager_->AddComponent(ComponentType::AUDIO, index);
-        componentManager_->audioComponents_[index]->soundID_ = static_cast<unsigned int>(soundID);
-        componentManager_->audioComponents_[index]->maxDistance_ = 1;
+        AudioComponent* audio = componentManager_->audioComponents_.Get(index);
+        audio->soundID_ = static_cast<unsigned int>(soundID);
+        audio->maxDistance_ = 1;
 
         componentManager_->AddComponent(ComponentType::LIGHT, index);
     }
@@ -93,26 +102,24 @@ void SceneManager::ResetScene()
 {
     qDebug() << "RESETTING SCENE...";
 
-    for (size_t i = 0; i < componentManager_->transformComponents_.size(); i++)
+    for (TransformComponent& transform : componentManager_->transformComponents_)
     {
-        if (componentManager_->transformComponents_[i])
-        {
-            componentManager_->transformComponents_[i]->position_relative_ = (componentManager_->transformComponents_[i]->position_default_);
-            componentManager_->transformComponents_[i]->rotation_relative_ = (componentManager_->transformComponents_[i]->rotation_default_);
-            componentManager_->transformComponents_[i]->scale_relative_    = (componentManager_->transformComponents_[i]->scale_default_);
-        }
-        if(componentManager_->aiComponents_[i])
-        {
-            componentManager_->aiComponents_[i]->locationOnSpline_ = 0;
-        }
-        if(!componentManager_->meshComponents_[i])
-            continue;
-        if(componentManager_->meshComponents_[i]->objectType_ == TAKEN_TROPHY)
+        transform.position_relative_ = (transform.position_default_);
+        transform.rotation_relative_ = (transform.rotation_default_);
+        transform.scale_relative_    = (transform.scale_default_);
+        transform.hasChanged_ = true;
+    }
+    for (AIComponent& ai : componentManager_->aiComponents_)
+    {
+        ai.locationOnSpline_ = 0;
+    }
+    for (MeshComponent& mesh : componentManager_->meshComponents_)
+    {
+        if(mesh.objectType_ == TAKEN_TROPHY)
         {
-            componentManager_->meshComponents_[i]->objectType_ = TROPHY;
-            componentManager_->meshComponents_[i]->enableCollision_ = true;
+            mesh.objectType_ = TROPHY;
+            mesh.enableCollision_ = true;
         }
-
     }
     UpdateAIsBasedOnThropies();
 }
@@ -122,72 +129,78 @@ void SceneManager::UpdateAIsBasedOnThropies()
     trophiesCounter_ = 0;
     std::vector<gsl::Vector3D> points;
     points.push_back({0});
-    for(size_t i = 0; i < componentManager_->meshComponents_.size(); i++)
+    for(size_t slot = 0; slot < componentManager_->meshComponents_.size(); slot++)
     {
-        if(!componentManager_->meshComponents_[i])
-            continue;
-        if(componentManager_->meshComponents_[i]->objectType_ == TROPHY)
+        if(componentManager_->meshComponents_[slot].objectType_ == TROPHY)
         {
-            if(componentManager_->transformComponents_[i])
+            size_t entityID = componentManager_->meshComponents_.EntityAt(slot);
+            if(TransformComponent* transform = componentManager_->transformComponents_.Get(entityID))
             {
-                points.push_back(componentManager_->transformComponents_[i]->position_world_);
+                points.push_back(transform->position_world_);
                 trophiesCounter_++;
             }
         }
     }
     points.push_back({0});
-    for(size_t i = 0; i < componentManager_->meshComponents_.size(); i++)
+    for(size_t slot = 0; slot < componentManager_->aiComponents_.size(); slot++)
     {
-        if(componentManager_->aiComponents_[i] && componentManager_->transformComponents_[i])
-        {
-            if(!componentManager_->aiComponents_[i]->spline_)
-                componentManager_->aiComponents_[i]->spline_ = std::make_shared<BSplineCurve>();
+        size_t entityID = componentManager_->aiComponents_.EntityAt(slot);
+        TransformComponent* transform = componentManager_->transformComponents_.Get(entityID);
+        if(!transform)
+            continue;
 
-            points.front() = componentManager_->transformComponents_[i]->position_world_;
-            points.back() = componentManager_->transformComponents_[i]->position_default_;
+        AIComponent& ai = componentManager_->aiComponents_[slot];
+        if(!ai.spline_)
+            ai.spline_ = std::make_shared<BSplineCurve>();
 
-            componentManager_->aiComponents_[i]->spline_->OverrideControlpoints(points);
-            componentManager_->aiComponents_[i]->spline_->RandomizeControlpointOrder();
-            componentManager_->aiComponents_[i]->locationOnSpline_ = 0;
+        points.front() = transform->position_world_;
+        points.back() = transform->position_default_;
 
-        }
+        ai.spline_->OverrideControlpoints(points);
+        ai.spline_->RandomizeControlpointOrder();
+        ai.locationOnSpline_ = 0;
     }
 }
 
 void SceneManager::SetActiveEntityToPlayer()
 {
-    for(unsigned int i = 0; i < componentManager_->meshComponents_.size(); i++)
+    for(size_t slot = 0; slot < componentManager_->meshComponents_.size(); slot++)
     {
-        if(!componentManager_->meshComponents_[i])
-            continue;
-        if(i == activeEntityID_)
+        MeshComponent& mesh = componentManager_->meshComponents_[slot];
+        if(componentManager_->meshComponents_.EntityAt(slot) == activeEntityID_)
         {
-            if(componentManager_->meshComponents_[i]->objectType_ != ObjectType::PLAYER)
-                componentManager_->meshComponents_[i]->objectType_ = ObjectType::PLAYER;
+            if(mesh.objectType_ != ObjectType::PLAYER)
+                mesh.objectType_ = ObjectType::PLAYER;
             continue;
         }
-        if(componentManager_->meshComponents_[i]->objectType_ == ObjectType::PLAYER)
-            componentManager_->meshComponents_[i]->objectType_ = ObjectType::DEFAULT;
+        if(mesh.objectType_ == ObjectType::PLAYER)
+            mesh.objectType_ = ObjectType::DEFAULT;
     }
-    playerEntityID_ = activeEntityID_;
+    playerEntity_ = entityManager_->GetHandle(activeEntityID_);
 }
 
 void SceneManager::SetPlayerID(size_t EntityID)
 {
-    if(EntityID >= entityManager_->numberOfEntities_)
+    if(!entityManager_->IsAlive(EntityID))
         return;
 
-    for(unsigned int i = 0; i < componentManager_->meshComponents_.size(); i++)
+    for(size_t slot = 0; slot < componentManager_->meshComponents_.size(); slot++)
     {
-        if(i == EntityID)
+        MeshComponent& mesh = componentManager_->meshComponents_[slot];
+        if(componentManager_->meshComponents_.EntityAt(slot) == EntityID)
         {
-            componentManager_->meshComponents_[i]->objectType_ = ObjectType::PLAYER;
+            mesh.objectType_ = ObjectType::PLAYER;
             continue;
         }
-        if(componentManager_->meshComponents_[i]->objectType_ == ObjectType::PLAYER)
-            componentManager_->meshComponents_[i]->objectType_ = ObjectType::DEFAULT;
+        if(mesh.objectType_ == ObjectType::PLAYER)
+            mesh.objectType_ = ObjectType::DEFAULT;
     }
-    playerEntityID_ = EntityID;
+    playerEntity_ = entityManager_->GetHandle(EntityID);
+}
+
+size_t SceneManager::GetPlayerEntityID() const
+{
+    return entityManager_->IsAlive(playerEntity_) ? playerEntity_.index : gsl::INVALID_SIZE;
 }
 
 void SceneManager::read(const QJsonObject &json)
@@ -233,18 +246,45 @@ void SceneManager::read(const QJsonObject &json)
                 entityManager_->SetChild(parentID, entityParentsAndChildren[parentID][childID]);
             }
         }
+
+        // the old player handle died with the old entities, the player is the entity with a player mesh, or else the first entity
+        size_t playerID{0};
+        for (size_t slot = 0; slot < componentManager_->meshComponents_.size(); slot++)
+        {
+            if (componentManager_->meshComponents_[slot].objectType_ == ObjectType::PLAYER)
+            {
+                playerID = componentManager_->meshComponents_.EntityAt(slot);
+                break;
+            }
+        }
+        playerEntity_ = entityManager_->GetHandle(playerID);
     }
 }
 
 void SceneManager::write(QJsonObject &json) const
 {
+    // entity IDs can have gaps after deletions, they are saved contiguously so they match the array index when read
+    std::vector<size_t> savedIDs(entityManager_->GetSlotCount(), gsl::INVALID_SIZE);
+    size_t nextSavedID{0};
+    for (size_t entityID = 0; entityID < savedIDs.size(); entityID++)
+    {
+        if (entityManager_->IsAlive(entityID))
+            savedIDs[entityID] = nextSavedID++;
+    }
+
     QJsonArray entities;
-    for (size_t entityID = 0; entityID < entityManager_->numberOfEntities_; entityID++)
+    for (size_t entityID = 0; entityID < savedIDs.size(); entityID++)
     {
+        if (savedIDs[entityID] == gsl::INVALID_SIZE)
+            continue;
+
         QJsonObject entity;
 
         QJsonObject entityInfo;
         entityManager_->write(entityInfo, entityID);
+        size_t parentID = entityManager_->GetParentEntityID(entityID);
+        entityInfo["entityID"] = static_cast<int>(savedIDs[entityID]);
+        entityInfo["parentID"] = static_cast<int>(parentID != gsl::INVALID_SIZE ? savedIDs[parentID] : gsl::INVALID_SIZE);
         entity["1_ENTITY_INFO"] = entityInfo;
 
         QJsonObject components;
@@ -313,7 +353,7 @@ bool SceneManager::SaveScene(QString filePath, SaveFormat saveFormat)
 void SceneManager::AddEntity(QString entityName)
 {
     entityManager_->AddEntity(entityName);
-    componentManager_->ResizeComponentVectors(entityManager_->numberOfEntities_);
+    componentManager_->ResizeComponentVectors(entityManager_->GetSlotCount());
 }
 
 void SceneManager::DeleteEntity(size_t entityID)
@@ -28,7 +28,8 @@ public:
     /// Defines which entity is selected and interactive, only one can be at a time.
     size_t activeEntityID_{0};
     /// Defines which entity is the player, can only be one at a time.
-    size_t playerEntityID_{0};
+    /// Defaults to the first entity created, and is picked again from the player mesh when a scene is read.
+    EntityHandle playerEntity_{0, 0};
     /// Script to load trophies from.
     std::shared_ptr<Script> TrophySpawnerScript_;
     /// Total amount of trophies in the scene.
@@ -62,6 +63,11 @@ public:
      * @param EntityID entity ID to set as new player.
      */
     void SetPlayerID(size_t EntityID);
+    /**
+     * Gets the ID of the player entity.
+     * @return ID of the player, gsl::INVALID_SIZE if the player entity has been deleted.
+     */
+    size_t GetPlayerEntityID() const;
     /**
      * Reads entity, component and asset data from json object.
      * @param json object to read from.
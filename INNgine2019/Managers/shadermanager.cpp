@@ -2,9 +2,26 @@
 
 #include "Managers/assetmanager.h"
 
+#include <limits>
+
+namespace
+{
+/// Uniform buffer binding points, every program's blocks are pointed to these.
+constexpr GLuint CAMERA_BLOCK_BINDING = 0;
+constexpr GLuint LIGHT_BLOCK_BINDING = 1;
+
+// the structs are copied straight into the buffers, so they must have the std140 sizes of the blocks in the shaders
+static_assert(sizeof(PointLightData) == 64, "PointLightData must be four RGBA32F texels");
+static_assert(sizeof(SpotLightData) == 80, "SpotLightData must match the std140 SpotLight struct");
+static_assert(sizeof(DirLightData) == 64, "DirLightData must match the std140 DirLight struct");
+static_assert(sizeof(CameraBlock) == 144, "CameraBlock must match the std140 CameraBlock");
+static_assert(sizeof(LightBlock) == (80 + 64) * gsl::MAX_NUMBER_OF_LIGHTS + 32, "LightBlock must match the std140 LightBlock");
+}
+
 ShaderManager::ShaderManager()
 {
     qDebug() << "\n\nINITIALIZING SHADER MANAGER";
+    CreateUniformBuffers();
     AddShader(PHONG_SHADER); //0
     qDebug() << "Phong shader program id: " << shaders_[0]->program_;
     AddShader(TEXTURE_SHADER); //1
@@ -16,12 +33,59 @@ ShaderManager::ShaderManager()
 
 }
 
+void ShaderManager::CreateUniformBuffers()
+{
+    initializeOpenGLFunctions();
+
+    glGenBuffers(1, &cameraBuffer_);
+    glBindBuffer(GL_UNIFORM_BUFFER, cameraBuffer_);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraBlock), &cameraBlock_, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, cameraBuffer_);
+
+    glGenBuffers(1, &lightBuffer_);
+    glBindBuffer(GL_UNIFORM_BUFFER, lightBuffer_);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(LightBlock), &lightBlock_, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, LIGHT_BLOCK_BINDING, lightBuffer_);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    CreateBufferTexture(pointLightBuffer_, pointLightTexture_, GL_RGBA32F);
+    CreateBufferTexture(clusterBuffer_, clusterTexture_, GL_RG32UI);
+    CreateBufferTexture(lightIndexBuffer_, lightIndexTexture_, GL_R32UI);
+}
+
+void ShaderManager::CreateBufferTexture(GLuint& buffer, GLuint& texture, GLenum format)
+{
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    glBufferData(GL_TEXTURE_BUFFER, 0, nullptr, GL_STREAM_DRAW);
+
+    glGenTextures(1, &texture);
+    glActiveTexture(GL_TEXTURE0 + texture);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
 void ShaderManager::SetActiveCamera(std::shared_ptr<Camera> camera)
 {
-    for(auto shader : shaders_)
-    {
-        shader->currentCamera_ = camera;
-    }
+    activeCamera_ = camera;
+}
+
+void ShaderManager::UpdateCameraBuffer()
+{
+    if (!activeCamera_)
+        return;
+
+    cameraBlock_.vMatrix = activeCamera_->viewMatrix_;
+    cameraBlock_.pMatrix = activeCamera_->projectionMatrix_;
+    cameraBlock_.viewPos = activeCamera_->position_;
+
+    glBindBuffer(GL_UNIFORM_BUFFER, cameraBuffer_);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(CameraBlock), &cameraBlock_);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
 }
 
 void ShaderManager::AddShader(ShaderType shaderType)
@@ -29,109 +93,76 @@ void ShaderManager::AddShader(ShaderType shaderType)
     switch (shaderType) {
     case PLAIN_SHADER:
         shaders_.push_back(std::make_shared<Shader>("PlainShader", shaderType));
-        LoadShadersFromFiles("plainshader");
-        shaders_.back()->mMatrixUniform_ = glGetUniformLocation( shaders_.back()->program_, "mMatrix" );
-        shaders_.back()->vMatrixUniform_ = glGetUniformLocation( shaders_.back()->program_, "vMatrix" );
-        shaders_.back()->pMatrixUniform_ = glGetUniformLocation( shaders_.back()->program_, "pMatrix" );
-
+        shaders_.back()->program_ = LoadShadersFromFiles("plainshader");
+        shaders_.back()->instanced_ = std::make_shared<Shader>("PlainShaderInstanced", shaderType);
+        shaders_.back()->instanced_->program_ = LoadShadersFromFiles("plainshader", "plainshaderinstanced");
         break;
     case TEXTURE_SHADER:
         shaders_.push_back(std::make_shared<Shader>("TextureShader", shaderType));
-        LoadShadersFromFiles("textureshader");
-        shaders_.back()->mMatrixUniform_ = glGetUniformLocation( shaders_.back()->program_, "mMatrix" );
-        shaders_.back()->vMatrixUniform_ = glGetUniformLocation( shaders_.back()->program_, "vMatrix" );
-        shaders_.back()->pMatrixUniform_ = glGetUniformLocation( shaders_.back()->program_, "pMatrix" );
-
-        shaders_.back()->objectColorUniform_ = glGetUniformLocation( shaders_.back()->program_, "objectColor" );
-        shaders_.back()->textureUniform_ = glGetUniformLocation(shaders_.back()->program_, "textureSampler");
-
+        shaders_.back()->program_ = LoadShadersFromFiles("textureshader");
+        shaders_.back()->instanced_ = std::make_shared<Shader>("TextureShaderInstanced", shaderType);
+        shaders_.back()->instanced_->program_ = LoadShadersFromFiles("textureshader", "textureshaderinstanced");
         break;
     case PHONG_SHADER:
-    {
         shaders_.push_back(std::make_shared<Shader>("PhongShader", shaderType));
-        LoadShadersFromFiles("lightshader");
-        shaders_.back()->mMatrixUniform_ = glGetUniformLocation( shaders_.back()->program_, "mMatrix" );
-        shaders_.back()->vMatrixUniform_ = glGetUniformLocation( shaders_.back()->program_, "vMatrix" );
-        shaders_.back()->pMatrixUniform_ = glGetUniformLocation( shaders_.back()->program_, "pMatrix" );
+        shaders_.back()->program_ = LoadShadersFromFiles("lightshader");
+        shaders_.back()->instanced_ = std::make_shared<Shader>("PhongShaderInstanced", shaderType);
+        shaders_.back()->instanced_->program_ = LoadShadersFromFiles("lightshader", "lightshaderinstanced");
+        break;
+    case MONO_COLOR_SHADER:
+        shaders_.push_back(std::make_shared<Shader>("MonoColorShader", shaderType));
+        shaders_.back()->program_ = LoadShadersFromFiles("MonoColorShader");
+        break;
+    }
 
-        shaders_.back()->numberOfPointLights_ = glGetUniformLocation( shaders_.back()->program_, "numberOfPointLights" );
-        shaders_.back()->numberOfSpotLights_ = glGetUniformLocation( shaders_.back()->program_, "numberOfSpotLights" );
-        shaders_.back()->numberOfDirectionalLights_ = glGetUniformLocation( shaders_.back()->program_, "numberOfDirectionalLights" );
+    FindUniformLocations(*shaders_.back());
+    if (shaders_.back()->instanced_)
+        FindUniformLocations(*shaders_.back()->instanced_);
+}
 
-        for(int i = 0; i < gsl::MAX_NUMBER_OF_LIGHTS; i++)
-        {
-            std::string light{""};
-            std::string index = "[" + std::to_string(i) + "].";
-            std::string variabel{""};
-
-            light = "pointLight";
-            variabel = "position";
-            shaders_.back()->pointLight_[i].position = glGetUniformLocation( shaders_.back()->program_, (light + index + variabel).c_str() );
-            variabel = "ambient";
-            shaders_.back()->pointLight_[i].ambient = glGetUniformLocation( shaders_.back()->program_, (light + index + variabel).c_str() );
-            variabel = "diffuse";
-            shaders_.back()->pointLight_[i].diffuse = glGetUniformLocation( shaders_.back()->program_, (light + index + variabel).c_str() );
-            variabel = "specular";
-            shaders_.back()->pointLight_[i].specular = glGetUniformLocation( shaders_.back()->program_, (light + index + variabel).c_str() );
-            variabel = "constant";
-            shaders_.back()->pointLight_[i].constant = glGetUniformLocation( shaders_.back()->program_, (light + index + variabel).c_str() );
-            variabel = "linear";
-            shaders_.back()->pointLight_[i].linear = glGetUniformLocation( shaders_.back()->program_, (light + index + variabel).c_str() );
-            variabel = "quadratic";
-            shaders_.back()->pointLight_[i].quadratic = glGetUniformLocation( shaders_.back()->program_, (light + index + variabel).c_str() );
-
-            light = "spotLight";
-            variabel = "position";
-            shaders_.back()->spotLight_[i].position = glGetUniformLocation( shaders_.back()->program_, (light + index + variabel).c_str() );
-            variabel = "direction";
-            shaders_.back()->spotLight_[i].direction = glGetUniformLocation( shaders_.back()->program_, (light + index + variabel).c_str() );
-            variabel = "cutOff";
-            shaders_.back()->spotLight_[i].cutOff = glGetUniformLocation( shaders_.back()->program_, (light + index + variabel).c_str() );
-            variabel = "outerCutOff";
-            shaders_.back()->spotLight_[i].outerCutOff = glGetUniformLocation( shaders_.back()->program_, (light + index + variabel).c_str() );
-            variabel = "ambient";
-            shaders_.back()->spotLight_[i].ambient = glGetUniformLocation( shaders_.back()->program_, (light + index + variabel).c_str() );
-            variabel = "diffuse";
-            shaders_.back()->spotLight_[i].diffuse = glGetUniformLocation( shaders_.back()->program_, (light + index + variabel).c_str() );
-            variabel = "specular";
-            shaders_.back()->spotLight_[i].specular = glGetUniformLocation( shaders_.back()->program_, (light + index + variabel).c_str() );
-
-            light = "dirLight";
-            variabel = "direction";
-            shaders_.back()->dirLight_[i].direction = glGetUniformLocation( shaders_.back()->program_, (light + index + variabel).c_str() );
-            variabel = "ambient";
-            shaders_.back()->dirLight_[i].ambient = glGetUniformLocation( shaders_.back()->program_, (light + index + variabel).c_str() );
-            variabel = "diffuse";
-            shaders_.back()->dirLight_[i].diffuse = glGetUniformLocation( shaders_.back()->program_, (light + index + variabel).c_str() );
-            variabel = "specular";
-            shaders_.back()->dirLight_[i].specular = glGetUniformLocation( shaders_.back()->program_, (light + index + variabel).c_str() );
-        }
-        // material info
-        shaders_.back()->material_.color = glGetUniformLocation( shaders_.back()->program_, "material.color" );
-        shaders_.back()->material_.diffuse = glGetUniformLocation( shaders_.back()->program_, "material.diffuse" );
-        shaders_.back()->material_.specular = glGetUniformLocation( shaders_.back()->program_, "material.specular" );
-        shaders_.back()->material_.shininess = glGetUniformLocation( shaders_.back()->program_, "material.shininess" );
+void ShaderManager::FindUniformLocations(Shader& shader)
+{
+    // blocks the program doesn't use have no index, like the light block in shaders without lighting
+    GLuint cameraBlock = glGetUniformBlockIndex(shader.program_, "CameraBlock");
+    if (cameraBlock != GL_INVALID_INDEX)
+        glUniformBlockBinding(shader.program_, cameraBlock, CAMERA_BLOCK_BINDING);
+    GLuint lightBlock = glGetUniformBlockIndex(shader.program_, "LightBlock");
+    if (lightBlock != GL_INVALID_INDEX)
+        glUniformBlockBinding(shader.program_, lightBlock, LIGHT_BLOCK_BINDING);
 
-        shaders_.back()->viewPosUniform_ = glGetUniformLocation( shaders_.back()->program_, "viewPos");
+    shader.mMatrixUniform_ = glGetUniformLocation( shader.program_, "mMatrix" );
+
+    switch (shader.type_) {
+    case PLAIN_SHADER:
+        break;
+    case TEXTURE_SHADER:
+        shader.objectColorUniform_ = glGetUniformLocation( shader.program_, "objectColor" );
+        shader.textureUniform_ = glGetUniformLocation(shader.program_, "textureSampler");
+        break;
+    case PHONG_SHADER:
+        // material info
+        shader.material_.color = glGetUniformLocation( shader.program_, "material.color" );
+        shader.material_.diffuse = glGetUniformLocation( shader.program_, "material.diffuse" );
+        shader.material_.specular = glGetUniformLocation( shader.program_, "material.specular" );
+        shader.material_.shininess = glGetUniformLocation( shader.program_, "material.shininess" );
+
+        // the clustered point light textures never move, so their units are set once
+        glUseProgram(shader.program_);
+        glUniform1i(glGetUniformLocation( shader.program_, "pointLights" ), static_cast<int>(pointLightTexture_));
+        glUniform1i(glGetUniformLocation( shader.program_, "clusterGrid" ), static_cast<int>(clusterTexture_));
+        glUniform1i(glGetUniformLocation( shader.program_, "clusterLightIndices" ), static_cast<int>(lightIndexTexture_));
         break;
-    }
     case MONO_COLOR_SHADER:
-        shaders_.push_back(std::make_shared<Shader>("MonoColorShader", shaderType));
-        LoadShadersFromFiles("MonoColorShader");
-        shaders_.back()->mMatrixUniform_ = glGetUniformLocation( shaders_.back()->program_, "mMatrix" );
-        shaders_.back()->vMatrixUniform_ = glGetUniformLocation( shaders_.back()->program_, "vMatrix" );
-        shaders_.back()->pMatrixUniform_ = glGetUniformLocation( shaders_.back()->program_, "pMatrix" );
-
-        shaders_.back()->objectColorUniform_ = glGetUniformLocation( shaders_.back()->program_, "objectColor" );
+        shader.objectColorUniform_ = glGetUniformLocation( shader.program_, "objectColor" );
         break;
     }
 }
 
-void ShaderManager::LoadShadersFromFiles(std::string shaderName, const GLchar* geometryPath)
+GLuint ShaderManager::LoadShadersFromFiles(std::string shaderName, std::string vertexShaderName, const GLchar* geometryPath)
 {
     initializeOpenGLFunctions();    //must do this to get access to OpenGL functions in QOpenGLFunctions
 
-    std::string vertexName = shaderName + ".vert";
+    std::string vertexName = (vertexShaderName.empty() ? shaderName : vertexShaderName) + ".vert";
     std::string fragmentName = shaderName + ".frag";
 
     // 1. Retrieve the vertex/fragment source code from filePath
@@ -231,17 +262,17 @@ void ShaderManager::LoadShadersFromFiles(std::string shaderName, const GLchar* g
     }
 
     // Shader Program
-    shaders_.back()->program_ = glCreateProgram( );
-    glAttachShader( shaders_.back()->program_, vertex );
-    glAttachShader( shaders_.back()->program_, fragment );
+    GLuint program = glCreateProgram( );
+    glAttachShader( program, vertex );
+    glAttachShader( program, fragment );
     if(geometryPath)
-        glAttachShader( shaders_.back()->program_, geometry );
-    glLinkProgram( shaders_.back()->program_ );
+        glAttachShader( program, geometry );
+    glLinkProgram( program );
     // Print linking errors if any
-    glGetProgramiv( shaders_.back()->program_, GL_LINK_STATUS, &success );
+    glGetProgramiv( program, GL_LINK_STATUS, &success );
     if (!success)
     {
-        glGetProgramInfoLog( shaders_.back()->program_, 512, nullptr, infoLog );
+        glGetProgramInfoLog( program, 512, nullptr, infoLog );
         qDebug() << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << QString::fromStdString(infoLog);
     }
     // Delete the shaders as they're linked into our program now and no longer needed
@@ -250,105 +281,167 @@ void ShaderManager::LoadShadersFromFiles(std::string shaderName, const GLchar* g
     if(geometryPath)
         glDeleteShader(geometry);
 
-    qDebug() << "Shader read: " << QString::fromStdString(shaderName);
+    qDebug() << "Shader read: " << QString::fromStdString(vertexName) << QString::fromStdString(fragmentName);
+    return program;
 }
 
-void ShaderManager::TransmitUniformDataToShader(size_t shaderID, gsl::Matrix4x4* modelMatrix, gsl::Vector3D color)
+void ShaderManager::TransmitUniformDataToShader(size_t shaderID, const gsl::Matrix4x4* modelMatrix, gsl::Vector3D color)
 {
-    glUseProgram(shaders_[shaderID]->program_);
     if (shaderID >= shaders_.size())
         return;
+    glUseProgram(shaders_[shaderID]->program_);
 
-    glUniformMatrix4fv( shaders_[shaderID]->vMatrixUniform_, 1, GL_TRUE, shaders_[shaderID]->currentCamera_->viewMatrix_.constData());
-    glUniformMatrix4fv( shaders_[shaderID]->pMatrixUniform_, 1, GL_TRUE, shaders_[shaderID]->currentCamera_->projectionMatrix_.constData());
     glUniformMatrix4fv( shaders_[shaderID]->mMatrixUniform_, 1, GL_TRUE, modelMatrix->constData());
 
     glUniform3f(shaders_[shaderID]->objectColorUniform_, color.x / gsl::MAX_COLORS, color.y / gsl::MAX_COLORS, color.z / gsl::MAX_COLORS);
 }
 
-void ShaderManager::TransmitUniformDataToShader(std::shared_ptr<Material> material, gsl::Matrix4x4* modelMatrix)
-{   
-    glUseProgram(shaders_[material->shaderID_]->program_);
+void ShaderManager::TransmitUniformDataToShader(const std::shared_ptr<Material>& material, const gsl::Matrix4x4* modelMatrix)
+{
+    UseShader(material->shaderID_);
+    TransmitMaterialDataToShader(material);
+    TransmitModelMatrixToShader(material->shaderID_, modelMatrix);
+}
 
-    glUniformMatrix4fv( shaders_[material->shaderID_]->vMatrixUniform_, 1, GL_TRUE, shaders_[material->shaderID_]->currentCamera_->viewMatrix_.constData());
-    glUniformMatrix4fv( shaders_[material->shaderID_]->pMatrixUniform_, 1, GL_TRUE, shaders_[material->shaderID_]->currentCamera_->projectionMatrix_.constData());
-    glUniformMatrix4fv( shaders_[material->shaderID_]->mMatrixUniform_, 1, GL_TRUE, modelMatrix->constData());
+void ShaderManager::UseShader(size_t shaderID, bool instanced)
+{
+    if (shaderID >= shaders_.size())
+        return;
+    const std::shared_ptr<Shader>& shader = instanced && shaders_[shaderID]->instanced_ ? shaders_[shaderID]->instanced_ : shaders_[shaderID];
+    glUseProgram(shader->program_);
+}
 
-    switch (shaders_[material->shaderID_]->type_) {
+void ShaderManager::TransmitMaterialDataToShader(const std::shared_ptr<Material>& material, bool instanced)
+{
+    const std::shared_ptr<Shader>& shader = instanced && shaders_[material->shaderID_]->instanced_ ? shaders_[material->shaderID_]->instanced_ : shaders_[material->shaderID_];
+    switch (shader->type_) {
     case PLAIN_SHADER:
         break;
     case TEXTURE_SHADER:
-        glUniform1i(shaders_[material->shaderID_]->textureUniform_, static_cast<int>(AssetManager::GetInstance()->GetTexture(material->textureID_)->glName_)); //TextureUnit = 0 as default);
-        glUniform3f(shaders_[material->shaderID_]->objectColorUniform_, material->color_.x / gsl::MAX_COLORS, material->color_.y / gsl::MAX_COLORS, material->color_.z / gsl::MAX_COLORS);
+        glUniform1i(shader->textureUniform_, static_cast<int>(AssetManager::GetInstance()->GetTexture(material->textureID_)->glName_)); //TextureUnit = 0 as default);
+        glUniform3f(shader->objectColorUniform_, material->color_.x / gsl::MAX_COLORS, material->color_.y / gsl::MAX_COLORS, material->color_.z / gsl::MAX_COLORS);
         break;
     case PHONG_SHADER:
-        glUniform3f(shaders_[material->shaderID_]->viewPosUniform_,
-                shaders_[material->shaderID_]->currentCamera_->position_.x,
-                shaders_[material->shaderID_]->currentCamera_->position_.y,
-                shaders_[material->shaderID_]->currentCamera_->position_.z);
-        glUniform3f(shaders_[material->shaderID_]->material_.color, material->color_.x / gsl::MAX_COLORS, material->color_.y / gsl::MAX_COLORS, material->color_.z / gsl::MAX_COLORS);
-        glUniform1f(shaders_[material->shaderID_]->material_.shininess, material->shininess_);
+        glUniform3f(shader->material_.color, material->color_.x / gsl::MAX_COLORS, material->color_.y / gsl::MAX_COLORS, material->color_.z / gsl::MAX_COLORS);
+        glUniform1f(shader->material_.shininess, material->shininess_);
 
         if (AssetManager::GetInstance()->GetTexture(material->textureID_))
-            glUniform1i(shaders_[material->shaderID_]->material_.diffuse, static_cast<int>(AssetManager::GetInstance()->GetTexture(material->textureID_)->glName_));
+            glUniform1i(shader->material_.diffuse, static_cast<int>(AssetManager::GetInstance()->GetTexture(material->textureID_)->glName_));
         else
-            glUniform1i(shaders_[material->shaderID_]->material_.diffuse, static_cast<int>(AssetManager::GetInstance()->GetTexture(0)->glName_));
+            glUniform1i(shader->material_.diffuse, static_cast<int>(AssetManager::GetInstance()->GetTexture(0)->glName_));
 
         if (AssetManager::GetInstance()->GetTexture(material->specularMapID_))
-            glUniform1i(shaders_[material->shaderID_]->material_.specular, static_cast<int>(AssetManager::GetInstance()->GetTexture(material->specularMapID_)->glName_));
+            glUniform1i(shader->material_.specular, static_cast<int>(AssetManager::GetInstance()->GetTexture(material->specularMapID_)->glName_));
         else
-            glUniform1i(shaders_[material->shaderID_]->material_.specular, static_cast<int>(AssetManager::GetInstance()->GetTexture(0)->glName_));
+            glUniform1i(shader->material_.specular, static_cast<int>(AssetManager::GetInstance()->GetTexture(0)->glName_));
         break;
     case MONO_COLOR_SHADER:
-        glUniform3f(shaders_[material->shaderID_]->objectColorUniform_, material->color_.x, material->color_.y, material->color_.z);
+        glUniform3f(shader->objectColorUniform_, material->color_.x, material->color_.y, material->color_.z);
         break;
     }
 }
 
-void ShaderManager::TransmitUniformLightDataToShader(size_t shaderID, int numberOfPointLights, int numberOfSpotLights, int numberOfDirectionalLights)
+void ShaderManager::TransmitModelMatrixToShader(size_t shaderID, const gsl::Matrix4x4* modelMatrix)
 {
-    glUseProgram(shaders_[shaderID]->program_);
+    glUniformMatrix4fv( shaders_[shaderID]->mMatrixUniform_, 1, GL_TRUE, modelMatrix->constData());
+}
 
-    glUniform1i(shaders_[shaderID]->numberOfPointLights_, numberOfPointLights);
-    glUniform1i(shaders_[shaderID]->numberOfSpotLights_, numberOfSpotLights);
-    glUniform1i(shaders_[shaderID]->numberOfDirectionalLights_, numberOfDirectionalLights);
+void ShaderManager::SetLightCount(int numberOfPointLights, int numberOfSpotLights, int numberOfDirectionalLights)
+{
+    pointLights_.resize(static_cast<size_t>(std::max(numberOfPointLights, 0)));
+    lightBlock_.numberOfSpotLights = std::min(numberOfSpotLights, gsl::MAX_NUMBER_OF_LIGHTS);
+    lightBlock_.numberOfDirectionalLights = std::min(numberOfDirectionalLights, gsl::MAX_NUMBER_OF_LIGHTS);
 
     qDebug() << "number of point Lights: "<< numberOfPointLights;
 }
 
-void ShaderManager::TransmitUniformLightDataToShader(size_t shaderID, gsl::Vector3D position, std::shared_ptr<LightComponent> light)
+void ShaderManager::SetLightData(gsl::Vector3D position, const LightComponent* light)
 {
-    glUseProgram(shaders_[shaderID]->program_);
+    if (light->lightIndexForShader_ < 0)
+        return;
+    size_t index = static_cast<size_t>(light->lightIndexForShader_);
+
     switch (light->lightType_)
     {
     case POINT_LIGHT:
-        glUniform3f(shaders_[shaderID]->pointLight_[light->lightIndexForShader_].position, position.x, position.y, position.z);
-        glUniform3f(shaders_[shaderID]->pointLight_[light->lightIndexForShader_].ambient, light->ambient_.x / gsl::MAX_COLORS, light->ambient_.y / gsl::MAX_COLORS, light->ambient_.z / gsl::MAX_COLORS);
-        glUniform3f(shaders_[shaderID]->pointLight_[light->lightIndexForShader_].diffuse, light->diffuse_.x / gsl::MAX_COLORS, light->diffuse_.y / gsl::MAX_COLORS, light->diffuse_.z / gsl::MAX_COLORS);
-        glUniform3f(shaders_[shaderID]->pointLight_[light->lightIndexForShader_].specular, light->specular_.x / gsl::MAX_COLORS, light->specular_.y / gsl::MAX_COLORS, light->specular_.z / gsl::MAX_COLORS);
-
-        glUniform1f(shaders_[shaderID]->pointLight_[light->lightIndexForShader_].constant, light->constant_);
-        glUniform1f(shaders_[shaderID]->pointLight_[light->lightIndexForShader_].linear, light->linear_);
-        glUniform1f(shaders_[shaderID]->pointLight_[light->lightIndexForShader_].quadratic, light->quadratic_);
+    {
+        if (index >= pointLights_.size())
+            return;
+        PointLightData& pointLight = pointLights_[index];
+        pointLight.position = position;
+        pointLight.ambient = light->ambient_ / gsl::MAX_COLORS;
+        pointLight.diffuse = light->diffuse_ / gsl::MAX_COLORS;
+        pointLight.specular = light->specular_ / gsl::MAX_COLORS;
+
+        pointLight.constant = light->constant_;
+        pointLight.linear = light->linear_;
+        pointLight.quadratic = light->quadratic_;
+
+        // the light is brightness / (constant + linear * d + quadratic * d^2) at distance d, solved for where that is lightCutoff_
+        gsl::Vector3D total = pointLight.ambient + pointLight.diffuse + pointLight.specular;
+        float brightness = std::max(total.x, std::max(total.y, total.z));
+        float attenuation = brightness / lightCutoff_ - pointLight.constant;
+        if (attenuation <= 0.f)
+            pointLight.radius = 0.f;
+        else if (pointLight.quadratic > 0.f)
+            pointLight.radius = (-pointLight.linear + std::sqrt(pointLight.linear * pointLight.linear + 4.f * pointLight.quadratic * attenuation)) / (2.f * pointLight.quadratic);
+        else if (pointLight.linear > 0.f)
+            pointLight.radius = attenuation / pointLight.linear;
+        else
+            pointLight.radius = std::numeric_limits<float>::infinity();
         break;
+    }
     case DIRECTIONAL_LIGHT:
-        glUniform3f(shaders_[shaderID]->dirLight_[light->lightIndexForShader_].ambient, light->ambient_.x / gsl::MAX_COLORS, light->ambient_.y / gsl::MAX_COLORS, light->ambient_.z / gsl::MAX_COLORS);
-        glUniform3f(shaders_[shaderID]->dirLight_[light->lightIndexForShader_].diffuse, light->diffuse_.x / gsl::MAX_COLORS, light->diffuse_.y / gsl::MAX_COLORS, light->diffuse_.z / gsl::MAX_COLORS);
-        glUniform3f(shaders_[shaderID]->dirLight_[light->lightIndexForShader_].specular, light->specular_.x / gsl::MAX_COLORS, light->specular_.y / gsl::MAX_COLORS, light->specular_.z / gsl::MAX_COLORS);
-
-        glUniform3f(shaders_[shaderID]->dirLight_[light->lightIndexForShader_].direction, light->direction_.x, light->direction_.y, light->direction_.z);
+    {
+        if (index >= static_cast<size_t>(gsl::MAX_NUMBER_OF_LIGHTS))
+            return;
+        DirLightData& dirLight = lightBlock_.dirLight[index];
+        dirLight.ambient = light->ambient_ / gsl::MAX_COLORS;
+        dirLight.diffuse = light->diffuse_ / gsl::MAX_COLORS;
+        dirLight.specular = light->specular_ / gsl::MAX_COLORS;
+
+        dirLight.direction = light->direction_;
         break;
+    }
     case SPOT_LIGHT:
-        glUniform3f(shaders_[shaderID]->spotLight_[light->lightIndexForShader_].position, position.x, position.y, position.z);
-        glUniform3f(shaders_[shaderID]->spotLight_[light->lightIndexForShader_].ambient, light->ambient_.x / gsl::MAX_COLORS, light->ambient_.y / gsl::MAX_COLORS, light->ambient_.z / gsl::MAX_COLORS);
-        glUniform3f(shaders_[shaderID]->spotLight_[light->lightIndexForShader_].diffuse, light->diffuse_.x / gsl::MAX_COLORS, light->diffuse_.y / gsl::MAX_COLORS, light->diffuse_.z / gsl::MAX_COLORS);
-        glUniform3f(shaders_[shaderID]->spotLight_[light->lightIndexForShader_].specular, light->specular_.x / gsl::MAX_COLORS, light->specular_.y / gsl::MAX_COLORS, light->specular_.z / gsl::MAX_COLORS);
-
-        glUniform1f(shaders_[shaderID]->spotLight_[light->lightIndexForShader_].cutOff, light->cutOff_);
-        glUniform1f(shaders_[shaderID]->spotLight_[light->lightIndexForShader_].outerCutOff, light->outerCutOff_);
-
-        glUniform3f(shaders_[shaderID]->spotLight_[light->lightIndexForShader_].direction, light->direction_.x, light->direction_.y, light->direction_.z);
+    {
+        if (index >= static_cast<size_t>(gsl::MAX_NUMBER_OF_LIGHTS))
+            return;
+        SpotLightData& spotLight = lightBlock_.spotLight[index];
+        spotLight.position = position;
+        spotLight.ambient = light->ambient_ / gsl::MAX_COLORS;
+        spotLight.diffuse = light->diffuse_ / gsl::MAX_COLORS;
+        spotLight.specular = light->specular_ / gsl::MAX_COLORS;
+
+        spotLight.cutOff = light->cutOff_;
+        spotLight.outerCutOff = light->outerCutOff_;
+
+        spotLight.direction = light->direction_;
         break;
     }
+    }
+}
 
+void ShaderManager::UpdateLightBuffer()
+{
+    if (activeCamera_)
+        lightClusters_.Build(pointLights_.data(), pointLights_.size(), *activeCamera_);
+    lightBlock_.clusterCountX = lightClusters_.countX_;
+    lightBlock_.clusterCountY = lightClusters_.countY_;
+    lightBlock_.clusterCountZ = lightClusters_.countZ_;
+    lightBlock_.clusterDepthScale = lightClusters_.depthScale_;
+    lightBlock_.clusterDepthBias = lightClusters_.depthBias_;
+
+    glBindBuffer(GL_UNIFORM_BUFFER, lightBuffer_);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LightBlock), &lightBlock_);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    // sizes change from frame to frame, so the buffers get a new store each time
+    glBindBuffer(GL_TEXTURE_BUFFER, pointLightBuffer_);
+    glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(pointLights_.size() * sizeof(PointLightData)), pointLights_.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, clusterBuffer_);
+    glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(lightClusters_.clusters_.size() * sizeof(GLuint)), lightClusters_.clusters_.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, lightIndexBuffer_);
+    glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(lightClusters_.lightIndices_.size() * sizeof(GLuint)), lightClusters_.lightIndices_.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
 }
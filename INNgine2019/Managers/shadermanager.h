@@ -4,6 +4,7 @@
 #include <vector>
 #include "Legacy/camera.h"
 #include "Legacy/innpch.h"
+#include "Managers/lightclusters.h"
 
 /// Used to define what type a shader is quickly.
 /// Especially when deciding what data to transfer to the shader when rendering.
@@ -15,43 +16,76 @@ enum ShaderType
     MONO_COLOR_SHADER
 };
 
-/// Contains directinal light uniform locations.
-/// Used to communicate with shaders.
-struct DirLightUniform
+/// Directional light as laid out in the shaders' LightBlock.
+/// std140 puts every vec3 on a 16 byte boundary, so the padding floats fill the gaps.
+struct DirLightData
 {
-    GLint direction{-1};
+    gsl::Vector3D direction;
+    float padding0{0};
 
-    GLint ambient{-1};
-    GLint diffuse{-1};
-    GLint specular{-1};
+    gsl::Vector3D ambient;
+    float padding1{0};
+    gsl::Vector3D diffuse;
+    float padding2{0};
+    gsl::Vector3D specular;
+    float padding3{0};
 };
 
-/// Contains spot light uniform locations.
-/// Used to communicate with shaders.
-struct SpotLightUniform
+/// Spot light as laid out in the shaders' LightBlock, the floats are put in the gaps after each vec3.
+struct SpotLightData
 {
-    GLint position{-1};
-    GLint direction{-1};
-    GLint cutOff{-1};
-    GLint outerCutOff{-1};
+    gsl::Vector3D position;
+    float cutOff{0};
+    gsl::Vector3D direction;
+    float outerCutOff{0};
 
-    GLint ambient{-1};
-    GLint diffuse{-1};
-    GLint specular{-1};
+    gsl::Vector3D ambient;
+    float padding0{0};
+    gsl::Vector3D diffuse;
+    float padding1{0};
+    gsl::Vector3D specular;
+    float padding2{0};
 };
 
-/// Contains point light uniform locations.
-/// Used to communicate with shaders.
-struct PointLightUniform
+/// Point light as read from the shaders' pointLights buffer texture, four RGBA texels per light.
+struct PointLightData
 {
-    GLint position{-1};
-    GLint constant{-1};
-    GLint linear{-1};
-    GLint quadratic{-1};
+    gsl::Vector3D position;
+    float constant{0};
 
-    GLint ambient{-1};
-    GLint diffuse{-1};
-    GLint specular{-1};
+    gsl::Vector3D ambient;
+    float linear{0};
+    gsl::Vector3D diffuse;
+    float quadratic{0};
+    gsl::Vector3D specular;
+    /// Distance where the light gets dimmer than ShaderManager::lightCutoff_, used to put it in clusters.
+    float radius{0};
+};
+
+/// Spot and directional lights, and how to find a fragment's cluster, as laid out in the shaders' std140 LightBlock uniform block.
+/// Point lights are in buffer textures instead, so there can be any number of them.
+struct LightBlock
+{
+    SpotLightData spotLight[gsl::MAX_NUMBER_OF_LIGHTS];
+    DirLightData dirLight[gsl::MAX_NUMBER_OF_LIGHTS];
+
+    GLint numberOfSpotLights{0};
+    GLint numberOfDirectionalLights{0};
+    GLint clusterCountX{0};
+    GLint clusterCountY{0};
+    GLint clusterCountZ{0};
+    float clusterDepthScale{0};
+    float clusterDepthBias{0};
+    float padding0{0};
+};
+
+/// Camera data as laid out in the shaders' std140 CameraBlock uniform block, the block is row major like gsl matrices.
+struct CameraBlock
+{
+    gsl::Matrix4x4 vMatrix;
+    gsl::Matrix4x4 pMatrix;
+    gsl::Vector3D viewPos;
+    float padding0{0};
 };
 
 /// Contains material uniform locations.
@@ -80,36 +114,18 @@ struct Shader
 
     /// Model Matrix uniform location.
     GLint mMatrixUniform_{-1};
-    /// View Matrix uniform location.
-    GLint vMatrixUniform_{-1};
-    /// Projection Matrix uniform location.
-    GLint pMatrixUniform_{-1};
 
     /// Color or Texture Shader: object color uniform location.
     GLint objectColorUniform_{-1};
     /// Texture Shader: texture uniform location.
     GLint textureUniform_{-1};
 
-    /// Model Matrix uniform location.
-    GLint numberOfPointLights_{-1};
-    /// View Matrix uniform location.
-    GLint numberOfSpotLights_{-1};
-    /// Projection Matrix uniform location.
-    GLint numberOfDirectionalLights_{-1};
-
-    /// Phong Shader: directional light uniform location.
-    DirLightUniform dirLight_[gsl::MAX_NUMBER_OF_LIGHTS];
-    /// Phong Shader: spot light uniform location.
-    SpotLightUniform spotLight_[gsl::MAX_NUMBER_OF_LIGHTS];
-    /// Phong Shader: point light uniform location.
-    PointLightUniform pointLight_[gsl::MAX_NUMBER_OF_LIGHTS];
     /// Phong Shader: material uniform location.
     MaterialUniform material_;
-    /// Phong Shader: Active camera to access camera's position
-    //TODO move out of shader
-    std::shared_ptr<Camera> currentCamera_{nullptr};
-    /// Phong Shader: Viewer position uniform location.
-    GLint viewPosUniform_{-1}; 
+
+    /// Variant reading the model matrix from a per instance attribute instead of mMatrix, nullptr if the shader has none.
+    /// Has its own program and uniform locations, used to draw many copies of a mesh in one call.
+    std::shared_ptr<Shader> instanced_{nullptr};
 
 };
 
@@ -120,13 +136,24 @@ public:
     ShaderManager();
     /// Vector containing all shaders.
     std::vector<std::shared_ptr<Shader>> shaders_;
+    /// Brightness under which a point light counts as not reaching, one step of an 8 bit color.
+    /// Decides how far each point light reaches when it is put in clusters.
+    float lightCutoff_{1.f / 256.f};
+    /// Point lights of the view frustum's clusters, rebuilt every UpdateLightBuffer.
+    LightClusters lightClusters_;
 
 public:
     /**
      * Sets active camera for all shaders.
+     * Its data is sent to the shaders with UpdateCameraBuffer.
      * @param camera Camera to be set as active camera in all shaders.
      */
     void SetActiveCamera(std::shared_ptr<Camera> camera);
+    /**
+     * Uploads the active camera's view and projection matrices and position to the camera uniform buffer.
+     * Every shader reads its CameraBlock from that one buffer, so this is done once per frame instead of for every draw.
+     */
+    void UpdateCameraBuffer();
     /**
      * Adds a shader of the specified type to shaders_.
      * This is hard coded for preset shaders and does not support custom shaders yet.
@@ -139,37 +166,102 @@ public:
      * @param modelMatrix Object's model matrix.
      * @param color Color to use for the object.
      */
-    void TransmitUniformDataToShader(size_t shaderID, gsl::Matrix4x4 *modelMatrix, gsl::Vector3D color = {0.5,0.5,0.5});
+    void TransmitUniformDataToShader(size_t shaderID, const gsl::Matrix4x4 *modelMatrix, gsl::Vector3D color = {0.5,0.5,0.5});
     /**
      * Transmits uniform data to shader.
      * @param material Material to get the transmission data from.
      * @param modelMatrix Object's model matrix.
      */
-    void TransmitUniformDataToShader(std::shared_ptr<Material> material, gsl::Matrix4x4* modelMatrix);
+    void TransmitUniformDataToShader(const std::shared_ptr<Material>& material, const gsl::Matrix4x4* modelMatrix);
+    /**
+     * Makes a shader the active program.
+     * Camera and light data come from the uniform buffers, so only material and model matrix are left to transmit.
+     * @param shaderID What shader to use.
+     * @param instanced Whether to use the shader's instanced variant, if it has one.
+     */
+    void UseShader(size_t shaderID, bool instanced = false);
+    /**
+     * Transmits material data to the active shader.
+     * Only has to be done when the material changes, draws with the same material can share it.
+     * @param material Material to get the transmission data from, UseShader must have been called with its shader.
+     * @param instanced Whether the instanced variant of the shader is the active one.
+     */
+    void TransmitMaterialDataToShader(const std::shared_ptr<Material>& material, bool instanced = false);
+    /**
+     * Transmits the model matrix to the active shader, the only data that changes between every draw.
+     * @param shaderID The active shader.
+     * @param modelMatrix Object's model matrix.
+     */
+    void TransmitModelMatrixToShader(size_t shaderID, const gsl::Matrix4x4* modelMatrix);
     /**
      * Loads shader from .vert and .frag files using preset shaderFilePath and shaderName.
-     * Hardcoded so that the .vert and .frag must share filename.
+     * The .vert and .frag share filename, unless a vertex shader variant is given.
      * This is because this project's doesnt current need custom shaders.
      * @param shaderName Name of shader, used in debugging and equals the filenames of the shaders.
+     * @param vertexShaderName Filename of the .vert to use instead, used for instanced variants sharing the .frag.
      * @param geometryPath Used for geometry shader, not fully supported yet.
+     * @return The linked program.
      */
-    void LoadShadersFromFiles(std::string shaderName, const GLchar* geometryPath = nullptr);
+    GLuint LoadShadersFromFiles(std::string shaderName, std::string vertexShaderName = "", const GLchar* geometryPath = nullptr);
     /**
-     * Transmits uniform data from light source to shader.
-     * Used for phong shader.
-     * @param shaderID ID of shader to transmit data to.
+     * Copies a light source into the light block, it is sent to the shaders with the next UpdateLightBuffer.
      * @param position Position of the light source.
-     * @param light The lightsource to transmit data from.
+     * @param light The lightsource to get the data from, its lightIndexForShader_ is the index within its light type.
      */
-    void TransmitUniformLightDataToShader(size_t shaderID, gsl::Vector3D position, std::shared_ptr<LightComponent> light);
+    void SetLightData(gsl::Vector3D position, const LightComponent* light);
     /**
-     * Transmits uniform data about number of lights per type to shader.
-     * @param shaderID ID of shader to transmit data to.
-     * @param numberOfPointLights number of points lights in the current scene.
+     * Sets the number of lights per type in the light block, it is sent to the shaders with the next UpdateLightBuffer.
+     * @param numberOfPointLights number of points lights in the current scene, there is no limit to these.
      * @param numberOfSpotLights number of spot lights in the current scene.
      * @param numberOfDirectionalLights number of directional lights in the current scene.
      */
-    void TransmitUniformLightDataToShader(size_t shaderID, int numberOfPointLights, int numberOfSpotLights, int numberOfDirectionalLights);
+    void SetLightCount(int numberOfPointLights, int numberOfSpotLights, int numberOfDirectionalLights);
+    /**
+     * Puts the point lights in clusters for the active camera, and uploads them and the light block for the phong shaders.
+     * Done once per frame after the lights have been set.
+     */
+    void UpdateLightBuffer();
+private:
+    /// Camera the camera block is made from.
+    std::shared_ptr<Camera> activeCamera_{nullptr};
+    /// CPU copy of the camera uniform buffer.
+    CameraBlock cameraBlock_;
+    /// CPU copy of the light uniform buffer.
+    LightBlock lightBlock_;
+    /// Uniform buffer with the CameraBlock of all shaders.
+    GLuint cameraBuffer_{0};
+    /// Uniform buffer with the LightBlock of all shaders.
+    GLuint lightBuffer_{0};
+    /// Point lights set with SetLightData, indexed by their lightIndexForShader_.
+    std::vector<PointLightData> pointLights_;
+    /// Buffer and buffer texture with pointLights_.
+    GLuint pointLightBuffer_{0};
+    GLuint pointLightTexture_{0};
+    /// Buffer and buffer texture with LightClusters::clusters_.
+    GLuint clusterBuffer_{0};
+    GLuint clusterTexture_{0};
+    /// Buffer and buffer texture with LightClusters::lightIndices_.
+    GLuint lightIndexBuffer_{0};
+    GLuint lightIndexTexture_{0};
+
+    /**
+     * Creates the camera and light uniform buffers and binds them to their binding points,
+     * and the buffer textures for the clustered point lights.
+     */
+    void CreateUniformBuffers();
+    /**
+     * Creates a buffer and a buffer texture reading from it.
+     * Like other textures the buffer texture is bound to the texture unit of its own name.
+     * @param buffer Set to the buffer.
+     * @param texture Set to the buffer texture.
+     * @param format Format of the texels.
+     */
+    void CreateBufferTexture(GLuint& buffer, GLuint& texture, GLenum format);
+    /**
+     * Finds the uniform locations used by the shader's type in its program, and points its uniform blocks to the shared buffers.
+     * @param shader Shader with a linked program.
+     */
+    void FindUniformLocations(Shader& shader);
 };
 
 #endif // SHADERMANAGER_H
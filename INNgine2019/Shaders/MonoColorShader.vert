@@ -3,8 +3,12 @@ layout(location = 0) in vec3 vertexPosition;
 layout(location = 1) in vec3 vertexNormal;
 
 uniform mat4 mMatrix;
-uniform mat4 vMatrix;
-uniform mat4 pMatrix;
+layout(std140, row_major) uniform CameraBlock
+{
+    mat4 vMatrix;
+    mat4 pMatrix;
+    vec3 viewPos;
+};
 
 void main() {
 
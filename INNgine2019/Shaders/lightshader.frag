@@ -1,5 +1,7 @@
 #version 330 core
 
+// the lights are laid out so each float fills the gap std140 leaves after a vec3, matching the structs in shadermanager.h
+// point lights are read from a buffer texture in the same order
 struct DirLight {
     vec3 direction;
 
@@ -10,8 +12,8 @@ struct DirLight {
 
 struct SpotLight {
     vec3 position;
-    vec3 direction;
     float cutOff;
+    vec3 direction;
     float outerCutOff;
 
     vec3 ambient;
@@ -21,13 +23,12 @@ struct SpotLight {
 
 struct PointLight {
     vec3 position;
-
     float constant;
-    float linear;
-    float quadratic;
 
     vec3 ambient;
+    float linear;
     vec3 diffuse;
+    float quadratic;
     vec3 specular;
 };
 
@@ -43,26 +44,43 @@ in vec3 Normal;
 in vec3 FragPos;
 in vec2 TexCoords;
 
-uniform vec3 viewPos;
+layout(std140, row_major) uniform CameraBlock
+{
+    mat4 vMatrix;
+    mat4 pMatrix;
+    vec3 viewPos;
+};
 uniform Material material;
-//uniform Light light;
-
-//uniform
 
-#define NR_POINT_LIGHTS 30;
-uniform PointLight pointLight[30];
-uniform SpotLight spotLight[30];
-uniform DirLight dirLight[30];
+// spot and directional lights reach everywhere, filled once per frame, 30 is gsl::MAX_NUMBER_OF_LIGHTS
+layout(std140) uniform LightBlock
+{
+    SpotLight spotLight[30];
+    DirLight dirLight[30];
+
+    int numberOfSpotLights;
+    int numberOfDirectionalLights;
+
+    // the view frustum is split into clusters, screen tiles times depth slices, with the point lights reaching each
+    int clusterCountX;
+    int clusterCountY;
+    int clusterCountZ;
+    float clusterDepthScale;
+    float clusterDepthBias;
+};
 
-uniform int numberOfPointLights;
-uniform int numberOfSpotLights;
-uniform int numberOfDirectionalLights;
+// four texels per point light, in the order of the PointLight struct
+uniform samplerBuffer pointLights;
+// where each cluster's lights start in clusterLightIndices and how many there are
+uniform usamplerBuffer clusterGrid;
+uniform usamplerBuffer clusterLightIndices;
 
 out vec4 FragColor;
 
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
 vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
+PointLight FetchPointLight(int index);
 
 
 //const float offset = 1.0 / 128.0;
@@ -74,9 +92,16 @@ void main()
 
     vec3 result;// = vec3(0.0);
 
-    for(int i = 0; i < numberOfPointLights; i++)
+    // only the point lights reaching this fragment's cluster, w is the view space depth
+    vec4 clipPos = pMatrix * vMatrix * vec4(FragPos, 1.0);
+    ivec2 tile = ivec2((clipPos.xy / clipPos.w * 0.5 + 0.5) * vec2(clusterCountX, clusterCountY));
+    tile = clamp(tile, ivec2(0), ivec2(clusterCountX - 1, clusterCountY - 1));
+    int slice = clamp(int(floor(log(clipPos.w) * clusterDepthScale - clusterDepthBias)), 0, clusterCountZ - 1);
+    uvec2 clusterLights = texelFetch(clusterGrid, tile.x + clusterCountX * (tile.y + clusterCountY * slice)).xy;
+    for(uint i = 0u; i < clusterLights.y; i++)
     {
-        result += CalcPointLight(pointLight[i], norm, FragPos, viewDir);
+        int lightIndex = int(texelFetch(clusterLightIndices, int(clusterLights.x + i)).r);
+        result += CalcPointLight(FetchPointLight(lightIndex), norm, FragPos, viewDir);
     }
     for(int i = 0; i < numberOfSpotLights; i++)
     {
@@ -117,6 +142,16 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
     return (ambient + diffuse + specular);
 }
 
+PointLight FetchPointLight(int index)
+{
+    vec4 positionConstant = texelFetch(pointLights, index * 4);
+    vec4 ambientLinear = texelFetch(pointLights, index * 4 + 1);
+    vec4 diffuseQuadratic = texelFetch(pointLights, index * 4 + 2);
+    vec4 specular = texelFetch(pointLights, index * 4 + 3);
+    return PointLight(positionConstant.xyz, positionConstant.w, ambientLinear.rgb, ambientLinear.w,
+                      diffuseQuadratic.rgb, diffuseQuadratic.w, specular.rgb);
+}
+
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
 {
     vec3 lightDir = normalize(light.position - fragPos);
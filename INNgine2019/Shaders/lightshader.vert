@@ -8,8 +8,12 @@ out vec3 Normal;
 out vec3 FragPos;
 out vec2 TexCoords;
 
-uniform mat4 pMatrix;
-uniform mat4 vMatrix;
+layout(std140, row_major) uniform CameraBlock
+{
+    mat4 vMatrix;
+    mat4 pMatrix;
+    vec3 viewPos;
+};
 uniform mat4 mMatrix;
 
 void main() {
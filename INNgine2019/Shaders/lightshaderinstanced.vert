@@ -0,0 +1,27 @@
+#version 330 core
+
+layout(location = 0) in vec3 posAttr;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aTexCoords;
+// one model matrix per instance, the rows of it since the engine's matrices are row major
+layout(location = 3) in mat4 instanceMatrixRows;
+
+out vec3 Normal;
+out vec3 FragPos;
+out vec2 TexCoords;
+
+layout(std140, row_major) uniform CameraBlock
+{
+    mat4 vMatrix;
+    mat4 pMatrix;
+    vec3 viewPos;
+};
+
+void main() {
+    mat4 mMatrix = transpose(instanceMatrixRows);
+    gl_Position = pMatrix * vMatrix * mMatrix * vec4(posAttr, 1.0);
+    FragPos = vec3(mMatrix * vec4(posAttr, 1.0));
+    // normal matrix to get the normal in world space
+    Normal = mat3(transpose(inverse(mMatrix))) * aNormal;
+    TexCoords = aTexCoords;
+}
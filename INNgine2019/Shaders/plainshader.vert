@@ -4,8 +4,12 @@ layout(location = 0) in vec4 posAttr;
 layout(location = 1) in vec4 colAttr;
 out vec4 col;
 uniform mat4 mMatrix;
-uniform mat4 vMatrix;
-uniform mat4 pMatrix;
+layout(std140, row_major) uniform CameraBlock
+{
+    mat4 vMatrix;
+    mat4 pMatrix;
+    vec3 viewPos;
+};
 
 void main() {
    col = abs(colAttr);
@@ -0,0 +1,18 @@
+#version 330 core
+
+layout(location = 0) in vec4 posAttr;
+layout(location = 1) in vec4 colAttr;
+// one model matrix per instance, the rows of it since the engine's matrices are row major
+layout(location = 3) in mat4 instanceMatrixRows;
+out vec4 col;
+layout(std140, row_major) uniform CameraBlock
+{
+    mat4 vMatrix;
+    mat4 pMatrix;
+    vec3 viewPos;
+};
+
+void main() {
+   col = abs(colAttr);
+   gl_Position = pMatrix * vMatrix * transpose(instanceMatrixRows) * posAttr;
+}
@@ -6,8 +6,12 @@ layout(location = 2) in vec2 vertexUV;
 out vec4 col;
 out vec2 UV;
 uniform mat4 mMatrix;
-uniform mat4 vMatrix;
-uniform mat4 pMatrix;
+layout(std140, row_major) uniform CameraBlock
+{
+    mat4 vMatrix;
+    mat4 pMatrix;
+    vec3 viewPos;
+};
 
 void main() {
    col = colAttr;
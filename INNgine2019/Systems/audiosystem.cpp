@@ -9,7 +9,7 @@ AudioSystem::AudioSystem()
 
 }
 
-void AudioSystem::InitializeAudioComponent(std::shared_ptr<AudioComponent> audio)
+void AudioSystem::InitializeAudioComponent(AudioComponent* audio)
 {
     alcMakeContextCurrent(AssetManager::GetInstance()->audioManager_->ALcontext_);
     audio->source_ = AssetManager::GetInstance()->audioManager_->GetNewSource();
@@ -25,7 +25,7 @@ void AudioSystem::InitializeAudioComponent(std::shared_ptr<AudioComponent> audio
     alSourcei(audio->source_, AL_BUFFER, static_cast<ALint>(AssetManager::GetInstance()->audioManager_->sounds_[audio->soundID_]->buffer_));
     audio->initialized_ = true;
 }
-void AudioSystem::Update(std::shared_ptr<Camera> camera_, std::vector<std::shared_ptr<TransformComponent>> transformComponents, std::vector<std::shared_ptr<AudioComponent>> audioComponents)
+void AudioSystem::Update(const std::shared_ptr<Camera>& camera_, ComponentView<const TransformComponent> transformComponents, ComponentView<AudioComponent> audioComponents)
 {
 
     alcMakeContextCurrent(AssetManager::GetInstance()->audioManager_->ALcontext_);
@@ -54,38 +54,37 @@ void AudioSystem::Update(std::shared_ptr<Camera> camera_, std::vector<std::share
     alListenerfv(AL_VELOCITY, velVec);
     alListenerfv(AL_ORIENTATION, headVec);
 
-    for(size_t i = 0; i < audioComponents.size(); i++)
+    for(size_t slot = 0; slot < audioComponents.size(); slot++)
     {
-        if(!audioComponents[i])
-            continue;
-        if(!audioComponents[i]->initialized_)
-            InitializeAudioComponent(audioComponents[i]);
-        if(transformComponents[i])
-            SetPosition(audioComponents[i],transformComponents[i]->position_world_);
+        AudioComponent* audioComponent = &audioComponents[slot];
+        if(!audioComponent->initialized_)
+            InitializeAudioComponent(audioComponent);
+        if(const TransformComponent* transformComponent = transformComponents.Get(audioComponents.EntityAt(slot)))
+            SetPosition(audioComponent,transformComponent->position_world_);
         else
-            SetPosition(audioComponents[i],pos);
+            SetPosition(audioComponent,pos);
     }
 }
 
-void AudioSystem::Play(std::shared_ptr<AudioComponent> component)
+void AudioSystem::Play(AudioComponent* component)
 {
     alcMakeContextCurrent(AssetManager::GetInstance()->audioManager_->ALcontext_);
     alSourcePlay(component->source_);
 }
 
-void AudioSystem::Pause(std::shared_ptr<AudioComponent> component)
+void AudioSystem::Pause(AudioComponent* component)
 {
     alcMakeContextCurrent(AssetManager::GetInstance()->audioManager_->ALcontext_);
     alSourcePause(component->source_);
 }
 
-void AudioSystem::Stop(std::shared_ptr<AudioComponent> component)
+void AudioSystem::Stop(AudioComponent* component)
 {
     alcMakeContextCurrent(AssetManager::GetInstance()->audioManager_->ALcontext_);
     alSourceStop(component->source_);
 }
 
-void AudioSystem::SetPosition(std::shared_ptr<AudioComponent> component, gsl::Vector3D newPosition)
+void AudioSystem::SetPosition(AudioComponent* component, gsl::Vector3D newPosition)
 {
     alcMakeContextCurrent(AssetManager::GetInstance()->audioManager_->ALcontext_);
     component->position_ = newPosition;
@@ -93,21 +92,21 @@ void AudioSystem::SetPosition(std::shared_ptr<AudioComponent> component, gsl::Ve
     alSourcefv(component->source_, AL_POSITION, temp);
 }
 
-void AudioSystem::SetSourceGain(std::shared_ptr<AudioComponent> component, ALfloat gain)
+void AudioSystem::SetSourceGain(AudioComponent* component, ALfloat gain)
 {
     alcMakeContextCurrent(AssetManager::GetInstance()->audioManager_->ALcontext_);
     component->gain_ = gain;
     alSourcef(component->source_, AL_GAIN, gain);
 }
 
-void AudioSystem::SetSourceIsLooping(std::shared_ptr<AudioComponent> component, bool arg)
+void AudioSystem::SetSourceIsLooping(AudioComponent* component, bool arg)
 {
     alcMakeContextCurrent(AssetManager::GetInstance()->audioManager_->ALcontext_);
     component->isLooping_ = arg;
     alSourcei(component->source_,AL_LOOPING,arg);
 }
 
-void AudioSystem::SetSourceMaxDistance(std::shared_ptr<AudioComponent> component, ALfloat distance)
+void AudioSystem::SetSourceMaxDistance(AudioComponent* component, ALfloat distance)
 {
     alcMakeContextCurrent(AssetManager::GetInstance()->audioManager_->ALcontext_);
     component->maxDistance_ = distance;
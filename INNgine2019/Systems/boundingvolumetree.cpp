@@ -0,0 +1,223 @@
+#include "boundingvolumetree.h"
+#include "GSL/gsl_simd.h"
+
+#include <algorithm>
+#include <cfloat>
+
+void BoundingVolumeTree::Build(const std::vector<gsl::Vector3D>& mins, const std::vector<gsl::Vector3D>& maxs)
+{
+    boxCount_ = mins.size();
+    nodes_.clear();
+    order_.resize(boxCount_);
+    centers_.resize(boxCount_);
+    for (size_t i = 0; i < boxCount_; i++)
+    {
+        order_[i] = i;
+        // twice the center, the halving doesn't change the order
+        centers_[i] = {mins[i].x + maxs[i].x, mins[i].y + maxs[i].y, mins[i].z + maxs[i].z};
+    }
+    if (boxCount_ == 0)
+        return;
+
+    nodes_.reserve(boxCount_ / 2 + 1);
+    BuildNode(0, boxCount_, mins, maxs);
+}
+
+int BoundingVolumeTree::BuildNode(size_t first, size_t last, const std::vector<gsl::Vector3D>& mins, const std::vector<gsl::Vector3D>& maxs)
+{
+    int nodeIndex = static_cast<int>(nodes_.size());
+    nodes_.emplace_back();
+    for (int slot = 0; slot < 4; slot++)
+    {
+        nodes_[static_cast<size_t>(nodeIndex)].children[slot] = EMPTY_SLOT;
+        SetSlot(nodes_[static_cast<size_t>(nodeIndex)], slot, gsl::Vector3D(FLT_MAX, FLT_MAX, FLT_MAX), gsl::Vector3D(-FLT_MAX, -FLT_MAX, -FLT_MAX));
+    }
+
+    // up to four boxes get a slot each, more are split in two twice, giving four groups
+    size_t groups[5]{first, first + 1, first + 2, first + 3, last};
+    if (last - first > 4)
+    {
+        groups[2] = SplitAtMedian(first, last);
+        groups[1] = SplitAtMedian(first, groups[2]);
+        groups[3] = SplitAtMedian(groups[2], last);
+    }
+
+    for (int slot = 0; slot < 4; slot++)
+    {
+        size_t groupFirst = std::min(groups[slot], last);
+        size_t groupLast = std::min(groups[slot + 1], last);
+        if (groupFirst >= groupLast)
+            continue;
+
+        if (groupLast - groupFirst == 1)
+        {
+            size_t box = order_[groupFirst];
+            Node& node = nodes_[static_cast<size_t>(nodeIndex)];
+            node.children[slot] = -static_cast<int>(box) - 1;
+            SetSlot(node, slot, mins[box], maxs[box]);
+            continue;
+        }
+        // the child is built before the slot is written, it adds nodes and can move nodes_
+        int child = BuildNode(groupFirst, groupLast, mins, maxs);
+        nodes_[static_cast<size_t>(nodeIndex)].children[slot] = child;
+        FitSlot(nodes_[static_cast<size_t>(nodeIndex)], slot);
+    }
+    return nodeIndex;
+}
+
+size_t BoundingVolumeTree::SplitAtMedian(size_t first, size_t last)
+{
+    gsl::Vector3D low(FLT_MAX, FLT_MAX, FLT_MAX);
+    gsl::Vector3D high(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (size_t i = first; i < last; i++)
+    {
+        const gsl::Vector3D& center = centers_[order_[i]];
+        low = {std::min(low.x, center.x), std::min(low.y, center.y), std::min(low.z, center.z)};
+        high = {std::max(high.x, center.x), std::max(high.y, center.y), std::max(high.z, center.z)};
+    }
+    float extentX = high.x - low.x;
+    float extentY = high.y - low.y;
+    float extentZ = high.z - low.z;
+    const float gsl::Vector3D::* axis = extentX >= extentY && extentX >= extentZ ? &gsl::Vector3D::x : (extentY >= extentZ ? &gsl::Vector3D::y : &gsl::Vector3D::z);
+
+    size_t middle = first + (last - first) / 2;
+    std::nth_element(order_.begin() + static_cast<long>(first), order_.begin() + static_cast<long>(middle), order_.begin() + static_cast<long>(last),
+                     [&](size_t a, size_t b){ return centers_[a].*axis < centers_[b].*axis; });
+    return middle;
+}
+
+void BoundingVolumeTree::SetSlot(Node& node, int slot, const gsl::Vector3D& min, const gsl::Vector3D& max)
+{
+    node.minX[slot] = min.x;
+    node.minY[slot] = min.y;
+    node.minZ[slot] = min.z;
+    node.maxX[slot] = max.x;
+    node.maxY[slot] = max.y;
+    node.maxZ[slot] = max.z;
+}
+
+void BoundingVolumeTree::FitSlot(Node& node, int slot)
+{
+    const Node& child = nodes_[static_cast<size_t>(node.children[slot])];
+    gsl::Vector3D min(FLT_MAX, FLT_MAX, FLT_MAX);
+    gsl::Vector3D max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (int childSlot = 0; childSlot < 4; childSlot++)
+    {
+        if (child.children[childSlot] == EMPTY_SLOT)
+            continue;
+        min = {std::min(min.x, child.minX[childSlot]), std::min(min.y, child.minY[childSlot]), std::min(min.z, child.minZ[childSlot])};
+        max = {std::max(max.x, child.maxX[childSlot]), std::max(max.y, child.maxY[childSlot]), std::max(max.z, child.maxZ[childSlot])};
+    }
+    SetSlot(node, slot, min, max);
+}
+
+void BoundingVolumeTree::Refit(const std::vector<gsl::Vector3D>& mins, const std::vector<gsl::Vector3D>& maxs)
+{
+    if (mins.size() != boxCount_)
+    {
+        Build(mins, maxs);
+        return;
+    }
+
+    // children come after their parent, so going backwards every child node is refit before its parent
+    for (size_t nodeIndex = nodes_.size(); nodeIndex-- > 0;)
+    {
+        Node& node = nodes_[nodeIndex];
+        for (int slot = 0; slot < 4; slot++)
+        {
+            int child = node.children[slot];
+            if (child == EMPTY_SLOT)
+                continue;
+            if (child < 0)
+            {
+                size_t box = static_cast<size_t>(-child - 1);
+                SetSlot(node, slot, mins[box], maxs[box]);
+                continue;
+            }
+            FitSlot(node, slot);
+        }
+    }
+}
+
+void BoundingVolumeTree::Cull(const gsl::Plane* planes, std::vector<char>& visible) const
+{
+    visible.assign(boxCount_, 0);
+    if (nodes_.empty())
+        return;
+
+    stack_.clear();
+    stack_.push_back(0);
+    while (!stack_.empty())
+    {
+        const Node& node = nodes_[static_cast<size_t>(stack_.back())];
+        stack_.pop_back();
+
+        // bit i is set when child i is outside a plane, or when it crosses a plane
+        int outside = 0;
+        int crossing = 0;
+        for (int plane = 0; plane < 6; plane++)
+        {
+            // the corner furthest along the normal is outside only if the whole box is,
+            // and the corner furthest against it is inside only if the whole box is
+            const gsl::Vector3D& normal = planes[plane].normal;
+            const float* farX = normal.x >= 0.f ? node.maxX : node.minX;
+            const float* farY = normal.y >= 0.f ? node.maxY : node.minY;
+            const float* farZ = normal.z >= 0.f ? node.maxZ : node.minZ;
+            const float* nearX = normal.x >= 0.f ? node.minX : node.maxX;
+            const float* nearY = normal.y >= 0.f ? node.minY : node.maxY;
+            const float* nearZ = normal.z >= 0.f ? node.minZ : node.maxZ;
+#ifdef GSL_USE_SSE
+            __m128 normalX = _mm_set1_ps(normal.x);
+            __m128 normalY = _mm_set1_ps(normal.y);
+            __m128 normalZ = _mm_set1_ps(normal.z);
+            __m128 distance = _mm_set1_ps(planes[plane].distanceToOrigo);
+            __m128 farDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(farX), normalX), _mm_mul_ps(_mm_load_ps(farY), normalY)),
+                                            _mm_add_ps(_mm_mul_ps(_mm_load_ps(farZ), normalZ), distance));
+            __m128 nearDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(nearX), normalX), _mm_mul_ps(_mm_load_ps(nearY), normalY)),
+                                             _mm_add_ps(_mm_mul_ps(_mm_load_ps(nearZ), normalZ), distance));
+            outside |= _mm_movemask_ps(_mm_cmplt_ps(farDistance, _mm_setzero_ps()));
+            crossing |= _mm_movemask_ps(_mm_cmplt_ps(nearDistance, _mm_setzero_ps()));
+#else
+            for (int slot = 0; slot < 4; slot++)
+            {
+                float farDistance = farX[slot] * normal.x + farY[slot] * normal.y + farZ[slot] * normal.z + planes[plane].distanceToOrigo;
+                float nearDistance = nearX[slot] * normal.x + nearY[slot] * normal.y + nearZ[slot] * normal.z + planes[plane].distanceToOrigo;
+                if (farDistance < 0.f)
+                    outside |= 1 << slot;
+                if (nearDistance < 0.f)
+                    crossing |= 1 << slot;
+            }
+#endif
+            if (outside == 0xF)
+                break;
+        }
+
+        for (int slot = 0; slot < 4; slot++)
+        {
+            int child = node.children[slot];
+            if (child == EMPTY_SLOT || (outside & (1 << slot)))
+                continue;
+            if (child < 0)
+                visible[static_cast<size_t>(-child - 1)] = 1;
+            else if (crossing & (1 << slot))
+                stack_.push_back(child);
+            else
+                MarkVisible(child, visible);
+        }
+    }
+}
+
+void BoundingVolumeTree::MarkVisible(int nodeIndex, std::vector<char>& visible) const
+{
+    const Node& node = nodes_[static_cast<size_t>(nodeIndex)];
+    for (int slot = 0; slot < 4; slot++)
+    {
+        int child = node.children[slot];
+        if (child == EMPTY_SLOT)
+            continue;
+        if (child < 0)
+            visible[static_cast<size_t>(-child - 1)] = 1;
+        else
+            MarkVisible(child, visible);
+    }
+}
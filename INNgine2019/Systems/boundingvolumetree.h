@@ -0,0 +1,83 @@
+#ifndef BOUNDINGVOLUMETREE_H
+#define BOUNDINGVOLUMETREE_H
+
+#include <vector>
+#include "GSL/vector3d.h"
+#include "Legacy/constants.h"
+
+/**
+ * Tree of axis aligned boxes with four children per node, used to frustum cull many entities at once.
+ * A node outside the frustum rejects everything under it, and a node fully inside accepts everything under it,
+ * so only the boxes along the frustum's sides are tested one by one.
+ * The four child boxes of a node are stored side by side, so they are tested against a plane together with SSE.
+ */
+class BoundingVolumeTree
+{
+public:
+    /**
+     * Builds the tree over the boxes, replacing the old one.
+     * Boxes are split at the median of their centers along the longest axis, twice per node.
+     * @param mins Lowest corner of each box.
+     * @param maxs Highest corner of each box, the same number as mins.
+     */
+    void Build(const std::vector<gsl::Vector3D>& mins, const std::vector<gsl::Vector3D>& maxs);
+    /**
+     * Updates the node boxes after the boxes have moved, keeping the tree's structure.
+     * Much cheaper than Build, but the tree gets looser the further boxes move from where they were built.
+     * @param mins Lowest corner of each box, the same number as the tree was built with.
+     * @param maxs Highest corner of each box.
+     */
+    void Refit(const std::vector<gsl::Vector3D>& mins, const std::vector<gsl::Vector3D>& maxs);
+    /// Number of boxes the tree was built with.
+    size_t Size() const { return boxCount_; }
+    /**
+     * Finds the boxes that are at least partly on the inner side of all the planes.
+     * @param planes The six frustum planes, normals pointing into the frustum.
+     * @param visible Resized to Size(), set to 1 for boxes inside and 0 for boxes outside.
+     */
+    void Cull(const gsl::Plane* planes, std::vector<char>& visible) const;
+
+private:
+    /// Four child boxes as separate arrays per coordinate, so each coordinate of all four loads as one SSE register.
+    struct alignas(16) Node
+    {
+        float minX[4];
+        float minY[4];
+        float minZ[4];
+        float maxX[4];
+        float maxY[4];
+        float maxZ[4];
+        /// Node index if 0 or more, box index as -(box + 1) if less, EMPTY_SLOT if unused.
+        int children[4];
+    };
+    static constexpr int EMPTY_SLOT = -2147483647 - 1;
+
+    /**
+     * Adds a node over the boxes in order_[first, last), with up to four child boxes or nodes.
+     * @return Index of the node.
+     */
+    int BuildNode(size_t first, size_t last, const std::vector<gsl::Vector3D>& mins, const std::vector<gsl::Vector3D>& maxs);
+    /**
+     * Reorders order_[first, last) so the first half has the lower centers along the longest axis of the centers.
+     * @return Where the second half starts.
+     */
+    size_t SplitAtMedian(size_t first, size_t last);
+    /// Sets the slot's box in the node.
+    void SetSlot(Node& node, int slot, const gsl::Vector3D& min, const gsl::Vector3D& max);
+    /// Sets the slot's box in the node to the box around the child node's slots.
+    void FitSlot(Node& node, int slot);
+    /// Marks every box under the node as visible.
+    void MarkVisible(int nodeIndex, std::vector<char>& visible) const;
+
+    /// Nodes with every parent before its children, the root first.
+    std::vector<Node> nodes_;
+    /// Box indices, reordered by Build so each node's boxes are next to each other.
+    std::vector<size_t> order_;
+    /// Twice the center of each box, used while building.
+    std::vector<gsl::Vector3D> centers_;
+    size_t boxCount_{0};
+    /// Nodes left to visit while culling, kept so its memory is reused.
+    mutable std::vector<int> stack_;
+};
+
+#endif // BOUNDINGVOLUMETREE_H
@@ -2,135 +2,175 @@
 #include "GSL/gsl_math.h"
 
 #include <quaternion.h>
+#include <algorithm>
 
-void MovementSystem::Update(std::shared_ptr<EntityManager> entityManager, std::vector<std::shared_ptr<TransformComponent> > transformComponents, std::vector<std::shared_ptr<MeshComponent> > meshComponents, std::vector<std::shared_ptr<AIComponent> > AIComponents , std::shared_ptr<Landscape> landscape_, std::vector<std::shared_ptr<LightComponent> > lightComponents, size_t PlayerID)
+void MovementSystem::Update(const std::shared_ptr<EntityManager>& entityManager, ComponentView<TransformComponent> transformComponents, ComponentView<MeshComponent> meshComponents, ComponentView<AIComponent> AIComponents , const std::shared_ptr<Landscape>& landscape_, ComponentView<LightComponent> lightComponents, size_t PlayerID)
 {
-    UpdateMovement(transformComponents,meshComponents,AIComponents,landscape_);
+    UpdateMovement(entityManager,transformComponents,meshComponents,AIComponents,landscape_);
 
-    for(size_t i = 0; i< caughtTrophies_.size(); i++)
-        UpdateTrophyAnimation(transformComponents[caughtTrophies_[i]],transformComponents[PlayerID],i);
+    caughtTrophies_.erase(std::remove_if(caughtTrophies_.begin(), caughtTrophies_.end(),
+                                         [&](EntityHandle trophy){ return !entityManager->IsAlive(trophy); }),
+                          caughtTrophies_.end());
 
-    for (size_t i = 0; i < transformComponents.size(); i++)
+    TransformComponent* playerTransform = transformComponents.Get(PlayerID);
+    for(size_t i = 0; i< caughtTrophies_.size(); i++)
     {
-        if (!transformComponents[i])
-            continue;
-        if(AIComponents[i] && update_)
-        {
-            if(transformComponents[PlayerID])
-                UpdateAIMovement(transformComponents[i],AIComponents[i], i, landscape_,transformComponents[PlayerID]->position_world_);
-            else
-                UpdateAIMovement(transformComponents[i],AIComponents[i], i, landscape_,{0,0,0});
-        }
-
-        // update modelMatrix
-        UpdateTransform(entityManager,transformComponents,i);
-
-        if(lightComponents[i])
-            if(lightComponents[i]->useEntityTransformForwardVectorAsDirection_)
-                lightComponents[i]->direction_ = transformComponents[i]->transform_.GetForwardVector().normalized();
+        TransformComponent* trophyTransform = transformComponents.Get(caughtTrophies_[i].index);
+        if(trophyTransform && playerTransform)
+            UpdateTrophyAnimation(trophyTransform,playerTransform,i);
     }
-}
 
-std::vector<gsl::Vector3D> MovementSystem::UpdateBoundingBoxes(size_t meshID, gsl::Vector3D position, std::shared_ptr<TransformComponent> transformComponent)
-{
-    std::vector<gsl::Vector3D> updatedBox;
-    std::shared_ptr<TransformComponent> x = std::make_shared<TransformComponent>();
-    *x = *transformComponent;
-    x->position_relative_ = (x->position_relative_ + (position));
-    for(gsl::Vector3D point : AssetManager::GetInstance()->meshManager_->meshes_[meshID]->boundingBox_->points_)
+    if(update_)
     {
-        gsl::Vector4D vec = x->transform_ * gsl::Vector4D(point+ (position));
-        //        meshComponent->mesh_->boundingBox_->pointsTransformed_.push_back(point + position + transformComponent->position_world_);
-        updatedBox.push_back(vec.toVector3D());
+        gsl::Vector3D playerPosition = playerTransform ? playerTransform->position_world_ : gsl::Vector3D(0,0,0);
+        ForEach(AIComponents, transformComponents, [&](size_t entityID, AIComponent& AI, TransformComponent& transform)
+        {
+            UpdateAIMovement(&transform, &AI, entityID, landscape_, playerPosition);
+        });
     }
-    return updatedBox;
 
+    UpdateTransforms(entityManager,transformComponents);
+    UpdateWorldBounds(meshComponents,transformComponents);
+
+    ForEach(lightComponents, transformComponents, [](size_t, LightComponent& light, TransformComponent& transform)
+    {
+        if(light.useEntityTransformForwardVectorAsDirection_)
+            light.direction_ = transform.transform_.GetForwardVector().normalized();
+    });
 }
 
-void MovementSystem::UpdateMovement(std::vector<std::shared_ptr<TransformComponent> > transformComponents, std::vector<std::shared_ptr<MeshComponent> > meshComponent, std::vector<std::shared_ptr<AIComponent>> AIComponents,std::shared_ptr<Landscape> landscape_)
+void MovementSystem::UpdateMovement(const std::shared_ptr<EntityManager>& entityManager, ComponentView<TransformComponent> transformComponents, ComponentView<MeshComponent> meshComponent, ComponentView<const AIComponent> AIComponents, const std::shared_ptr<Landscape>& landscape_)
 {
     for(size_t i = 0; i < movements_.size(); i++)
     {
-        if(!isColliding(movements_[i].first, meshComponent, transformComponents, movements_[i].second))
+        size_t entityID = movements_[i].first;
+        TransformComponent* transform = transformComponents.Get(entityID);
+        if(!transform)
+            continue;
+        if(!isColliding(entityID, entityManager, meshComponent, transformComponents, movements_[i].second))
         {
-            transformComponents[movements_[i].first]->position_relative_ += movements_[i].second;
-            gsl::Vector3D entityPosition = transformComponents[movements_[i].first]->position_relative_;
-            if(transformComponents[movements_[i].first]->followLandscape_ && !AIComponents[movements_[i].first])
+            transform->position_relative_ += movements_[i].second;
+            transform->hasChanged_ = true;
+            bool hasAI = AIComponents.Has(entityID);
+            if(transform->followLandscape_ && !hasAI)
             {
-                transformComponents[movements_[i].first]->position_relative_ = {entityPosition.x,FindLandscapeYOnLocation(landscape_,entityPosition),entityPosition.z};
+                landscapeFollowers_.push_back(transform);
+                landscapeLocations_.push_back(transform->position_relative_);
             }
-            if(transformComponents[movements_[i].first]->orientRotationBasedOnMovement_ && !AIComponents[movements_[i].first])
+            if(transform->orientRotationBasedOnMovement_ && !hasAI)
             {
-                transformComponents[movements_[i].first]->newForwardVector_ = movements_[i].second.normalized();
+                transform->newForwardVector_ = movements_[i].second.normalized();
             }
         }
     }
     movements_.clear();
+
+    // the collision checks above use the cached world bounds, so the heights can wait until every move is done
+    if(landscape_ && !landscapeFollowers_.empty())
+    {
+        landscape_->GetHeights(landscapeLocations_, landscapeHeights_);
+        for(size_t i = 0; i < landscapeFollowers_.size(); i++)
+            landscapeFollowers_[i]->position_relative_.y = landscapeHeights_[i];
+    }
+    landscapeFollowers_.clear();
+    landscapeLocations_.clear();
 }
 
-bool MovementSystem::isColliding(size_t ID, std::vector<std::shared_ptr<MeshComponent> > meshComponents,std::vector<std::shared_ptr<TransformComponent> > transformComponents, gsl::Vector3D position)
+void MovementSystem::UpdateWorldBounds(ComponentView<MeshComponent> meshComponents, ComponentView<const TransformComponent> transformComponents)
 {
-    if(!meshComponents[ID])
-        return false;
-    std::vector<gsl::Vector3D> mainUpdatedPoints = UpdateBoundingBoxes(meshComponents[ID]->meshID_, position, transformComponents[ID]);
-    float x = mainUpdatedPoints[1].x - mainUpdatedPoints[2].x;
-    float z = mainUpdatedPoints[0].z - mainUpdatedPoints[1].z;
-    std::vector<gsl::Vector3D> mainLineX = gsl::ProjectPointsOnVector(mainUpdatedPoints, gsl::Vector3D(x,0,0).normalized());
-    std::vector<gsl::Vector3D> mainLineY = gsl::ProjectPointsOnVector(mainUpdatedPoints, gsl::Vector3D(0,1,0));
-    std::vector<gsl::Vector3D> mainLineZ = gsl::ProjectPointsOnVector(mainUpdatedPoints, gsl::Vector3D(0,0,z).normalized());
-    std::pair<float, float> mainMinMaxX = gsl::findMinAndMaxInX(mainLineX);
-    std::pair<float, float> mainMinMaxY = gsl::findMinAndMaxInY(mainLineY);
-    std::pair<float, float> mainMinMaxZ = gsl::findMinAndMaxInZ(mainLineZ);
-
-    for(size_t otherID = 0; otherID < meshComponents.size(); otherID++)
+    for (size_t entityID : movedEntities_)
     {
+        isMoved_[entityID] = false;
+        MeshComponent* mesh = meshComponents.Get(entityID);
+        const TransformComponent* transform = transformComponents.Get(entityID);
+        const BoundingBox* boundingBox = mesh ? AssetManager::GetInstance()->meshManager_->meshes_[mesh->meshID_]->boundingBox_.get() : nullptr;
+        if (!mesh || !transform || !boundingBox)
+        {
+            if (mesh)
+                mesh->hasWorldBounds_ = false;
+            collisionGrid_.Remove(entityID);
+            continue;
+        }
 
+        const std::vector<gsl::Vector3D>& points = boundingBox->points_;
+        gsl::Vector3D min(HUGE_VALF, HUGE_VALF, HUGE_VALF);
+        gsl::Vector3D max(-HUGE_VALF, -HUGE_VALF, -HUGE_VALF);
+        for (size_t i = 0; i < mesh->worldCorners_.size() && i < points.size(); i++)
+        {
+            gsl::Vector3D corner = (transform->transform_ * gsl::Vector4D(points[i], 1.f)).toVector3D();
+            mesh->worldCorners_[i] = corner;
+            min = {std::min(min.x, corner.x), std::min(min.y, corner.y), std::min(min.z, corner.z)};
+            max = {std::max(max.x, corner.x), std::max(max.y, corner.y), std::max(max.z, corner.z)};
+        }
+        mesh->worldMin_ = min;
+        mesh->worldMax_ = max;
+        mesh->hasWorldBounds_ = true;
+        collisionGrid_.Update(entityID, min, max);
+    }
+    movedEntities_.clear();
+}
+
+void MovementSystem::ClearCollisionGrid()
+{
+    collisionGrid_.Clear();
+}
+
+bool MovementSystem::isColliding(size_t ID, const std::shared_ptr<EntityManager>& entityManager, ComponentView<MeshComponent> meshComponents, ComponentView<const TransformComponent> transformComponents, gsl::Vector3D position)
+{
+    MeshComponent* mesh = meshComponents.Get(ID);
+    const TransformComponent* transform = transformComponents.Get(ID);
+    if(!mesh || !transform || !mesh->hasWorldBounds_)
+        return false;
+    // the cached box moved by the movement being tested
+    std::array<gsl::Vector3D, 8> movedCorners = mesh->worldCorners_;
+    for(gsl::Vector3D& corner : movedCorners)
+        corner += position;
+
+    collisionGrid_.Query(mesh->worldMin_ + position, mesh->worldMax_ + position, collisionCandidates_);
+
+    for(size_t otherID : collisionCandidates_)
+    {
         if(otherID == ID)
             continue;
-        if(!meshComponents[otherID])
+        MeshComponent* otherMeshComponent = meshComponents.Get(otherID);
+        const TransformComponent* otherTransform = transformComponents.Get(otherID);
+        if(!otherMeshComponent || !otherTransform)
+        {
+            // deleted since the grid was updated
+            collisionGrid_.Remove(otherID);
             continue;
-        if(!meshComponents[otherID]->enableCollision_)
+        }
+        MeshComponent& otherMesh = *otherMeshComponent;
+        if(!otherMesh.enableCollision_ || !otherMesh.hasWorldBounds_)
             continue;
 
-        std::vector<gsl::Vector3D> iUpdatedPoints = UpdateBoundingBoxes(meshComponents[otherID]->meshID_, gsl::Vector3D(0,0,0), transformComponents[otherID]);
-        float x = iUpdatedPoints[1].x - iUpdatedPoints[2].x;
-        float z = iUpdatedPoints[0].z - iUpdatedPoints[1].z;
-        std::vector<gsl::Vector3D> iLineX = gsl::ProjectPointsOnVector(iUpdatedPoints, gsl::Vector3D(x,0,0).normalized());
-        std::vector<gsl::Vector3D> iLineY = gsl::ProjectPointsOnVector(iUpdatedPoints, gsl::Vector3D(0,1,0));
-        std::vector<gsl::Vector3D> iLineZ = gsl::ProjectPointsOnVector(iUpdatedPoints, gsl::Vector3D(0,0,z).normalized());
-        std::pair<float, float> iMinMaxX = gsl::findMinAndMaxInX(iLineX);
-        std::pair<float, float> iMinMaxY = gsl::findMinAndMaxInY(iLineY);
-        std::pair<float, float> iMinMaxZ = gsl::findMinAndMaxInZ(iLineZ);
-
-        if(overlaps(mainMinMaxX.first,mainMinMaxX.second,iMinMaxX.first,iMinMaxX.second))
-            if(overlaps(mainMinMaxY.first,mainMinMaxY.second,iMinMaxY.first,iMinMaxY.second))
-                if(overlaps(mainMinMaxZ.first,mainMinMaxZ.second,iMinMaxZ.first,iMinMaxZ.second))
+        if(gsl::obbOverlap(movedCorners, otherMesh.worldCorners_))
+        {
+            if(mesh->objectType_ == ENEMY)
+            {
+                if(otherMesh.objectType_ == PLAYER)
+                {
+                    AssetManager::GetInstance()->AddEvent(PLAYER_DEATH);
+                }
+                else
                 {
-                    if(meshComponents[ID]->objectType_ == ENEMY)
-                    {
-                        if(meshComponents[otherID]->objectType_ == PLAYER)
-                        {
-                            AssetManager::GetInstance()->AddEvent(0);
-                        }
-                        else
-                        {
-                            return false;
-                        }
-                    }
-                    else if(meshComponents[ID]->objectType_ == PLAYER)
-                    {
-                        if(meshComponents[otherID]->objectType_ == ENEMY)
-                        {
-                            AssetManager::GetInstance()->AddEvent(0);
-                        }
-                        else if(meshComponents[otherID]->objectType_ == TROPHY)
-                        {
-                            AssetManager::GetInstance()->AddEvent(static_cast<unsigned int>(otherID));
-                            meshComponents[otherID]->enableCollision_ = false;
-                        }
-                    }
-                    return true;
+                    return false;
                 }
+            }
+            else if(mesh->objectType_ == PLAYER)
+            {
+                if(otherMesh.objectType_ == ENEMY)
+                {
+                    AssetManager::GetInstance()->AddEvent(PLAYER_DEATH);
+                }
+                else if(otherMesh.objectType_ == TROPHY)
+                {
+                    AssetManager::GetInstance()->AddEvent(TROPHY_CAUGHT, entityManager->GetHandle(otherID));
+                    otherMesh.enableCollision_ = false;
+                }
+            }
+            return true;
+        }
     }
 
     //No collision found.
@@ -143,30 +183,15 @@ void MovementSystem::AddMovement(size_t ID, gsl::Vector3D value)
     //    qDebug() << ID << " | " << value;
 }
 
-float MovementSystem::FindLandscapeYOnLocation(std::shared_ptr<Landscape> landscape_, gsl::Vector3D location)
+float MovementSystem::FindLandscapeYOnLocation(const std::shared_ptr<Landscape>& landscape_, gsl::Vector3D location)
 {
-    if(!landscape_->indices_.empty())
-    {
-        std::vector<GLuint> ID = landscape_->indices_;
-        for(unsigned int i = 2; i < ID.size() ; i = i + 3)
-        {
-            gsl::Vector2D tri1(landscape_->vertices_[ID[i-2]].XYZ_.x,landscape_->vertices_[ID[i-2]].XYZ_.z);
-            gsl::Vector2D tri2(landscape_->vertices_[ID[i-1]].XYZ_.x,landscape_->vertices_[ID[i-1]].XYZ_.z);
-            gsl::Vector2D tri3(landscape_->vertices_[ID[i]].XYZ_.x,landscape_->vertices_[ID[i]].XYZ_.z);
-            gsl::Vector3D newplayerPos = gsl::barycentricCoordinates(tri3,tri2,tri1,gsl::Vector2D(location.x,location.z));
-            if(newplayerPos.getX()>0 && newplayerPos.getX()<1 &&newplayerPos.getY()>0 && newplayerPos.getY()<1 && newplayerPos.getZ()>0 && newplayerPos.getZ() <1)
-            {
-                float playerTempPos = (landscape_->vertices_[ID[i-2]].XYZ_.y *newplayerPos.getZ() +
-                        landscape_->vertices_[ID[i-1]].XYZ_.y*newplayerPos.getY() +
-                        landscape_->vertices_[ID[i]].XYZ_.y*newplayerPos.getX());
-                return playerTempPos;
-            }
-        }
-    }
+    float height = 0;
+    if(landscape_ && landscape_->GetHeight(location.x, location.z, height))
+        return height;
     return 0;
 }
 
-void MovementSystem::UpdateAIMovement(std::shared_ptr<TransformComponent> transformComponent, std::shared_ptr<AIComponent> AIComponent, size_t ID, std::shared_ptr<Landscape> landscape_, gsl::Vector3D playerPosition)
+void MovementSystem::UpdateAIMovement(TransformComponent* transformComponent, AIComponent* AIComponent, size_t ID, const std::shared_ptr<Landscape>& landscape_, gsl::Vector3D playerPosition)
 {
     gsl::Vector3D movement(0,0,0);
     if(AIComponent->aiState_ == AI_PATROL)
@@ -178,7 +203,7 @@ void MovementSystem::UpdateAIMovement(std::shared_ptr<TransformComponent> transf
 
 }
 
-void MovementSystem::CheckAIState(std::shared_ptr<AIComponent> AIComponent, gsl::Vector3D AIPosition, gsl::Vector3D playerPosition)
+void MovementSystem::CheckAIState(AIComponent* AIComponent, gsl::Vector3D AIPosition, gsl::Vector3D playerPosition)
 {
     if(AIComponent->aiState_ == AI_PATROL)
     {
@@ -198,7 +223,7 @@ void MovementSystem::CheckAIState(std::shared_ptr<AIComponent> AIComponent, gsl:
     }
 }
 
-gsl::Vector3D MovementSystem::AIPatrol(std::shared_ptr<TransformComponent> transformComponent, std::shared_ptr<AIComponent> AIComponent,std::shared_ptr<Landscape> landscape_)
+gsl::Vector3D MovementSystem::AIPatrol(TransformComponent* transformComponent, AIComponent* AIComponent, const std::shared_ptr<Landscape>& landscape_)
 {
     Lerp(AIComponent, transformComponent, landscape_);
     int knotBehind = AIComponent->spline_->findKnotInterval(AIComponent->locationOnSpline_);
@@ -208,6 +233,7 @@ gsl::Vector3D MovementSystem::AIPatrol(std::shared_ptr<TransformComponent> trans
     gsl::Vector3D movement = calculateSpline - transformComponent->position_relative_;
     if(transformComponent->orientRotationBasedOnMovement_)
     {
+        transformComponent->hasChanged_ = true;
         transformComponent->newForwardVector_ =  movement;
         //setting y as 0 because we only want it to rotate on the XZ basis.
         transformComponent->newForwardVector_.y = 0;
@@ -218,7 +244,7 @@ gsl::Vector3D MovementSystem::AIPatrol(std::shared_ptr<TransformComponent> trans
     return movement;
 }
 
-gsl::Vector3D MovementSystem::AIChase(std::shared_ptr<TransformComponent> transformComponent, std::shared_ptr<Landscape> landscape_,gsl::Vector3D playerPosition)
+gsl::Vector3D MovementSystem::AIChase(TransformComponent* transformComponent, const std::shared_ptr<Landscape>& landscape_,gsl::Vector3D playerPosition)
 {
     //    gsl::Vector3D playerpos(playerPosition.x,playerpositio,playerPosition.z);
     //    gsl::Vector3D AIpos(transformComponent->position_relative_.x,0,transformComponent->position_relative_.z);
@@ -231,6 +257,7 @@ gsl::Vector3D MovementSystem::AIChase(std::shared_ptr<TransformComponent> transf
 
     if(transformComponent->orientRotationBasedOnMovement_)
     {
+        transformComponent->hasChanged_ = true;
         transformComponent->newForwardVector_ =  towardsPlayer;
         //setting y as 0 because we only want it to rotate on the XZ basis.
         transformComponent->newForwardVector_.y = 0;
@@ -241,7 +268,7 @@ gsl::Vector3D MovementSystem::AIChase(std::shared_ptr<TransformComponent> transf
     return towardsPlayer;
 }
 
-void MovementSystem::Lerp(std::shared_ptr<AIComponent> AIComponent, std::shared_ptr<TransformComponent> transformComponent, std::shared_ptr<Landscape> landscape_)
+void MovementSystem::Lerp(AIComponent* AIComponent, TransformComponent* transformComponent, const std::shared_ptr<Landscape>& landscape_)
 {
     if(AIComponent->locationOnSpline_ > 1)
     {
@@ -252,12 +279,13 @@ void MovementSystem::Lerp(std::shared_ptr<AIComponent> AIComponent, std::shared_
         gsl::Vector3D AILocation = AIComponent->spline_->EvaluateBSpline(AIComponent->spline_->findKnotInterval(0),0);
         AILocation.y = FindLandscapeYOnLocation(landscape_,AILocation);
         transformComponent->position_relative_ = AILocation;
+        transformComponent->hasChanged_ = true;
     }
     else
         AIComponent->locationOnSpline_ += (AIComponent->speed_ * 5.f/ AIComponent->spline_->controlPoints_.size()) * AssetManager::GetInstance()->deltaTime_;
 }
 
-void MovementSystem::UpdateTrophyAnimation(std::shared_ptr<TransformComponent> cowTransform, std::shared_ptr<TransformComponent> playerTransform, size_t index)
+void MovementSystem::UpdateTrophyAnimation(TransformComponent* cowTransform, TransformComponent* playerTransform, size_t index)
 {
     //Y height maximum == 5
     if(cowTransform->position_world_.y > playerTransform->position_world_.y +4.5f || cowTransform->scale_relative_.x < 0.01f)
@@ -273,19 +301,91 @@ void MovementSystem::UpdateTrophyAnimation(std::shared_ptr<TransformComponent> c
     cowToPlayer.normalize();
     cowToPlayer = (cowToPlayer / (40.f)) * AssetManager::GetInstance()->deltaTime_;
     cowTransform->position_relative_ += cowToPlayer ;
+    cowTransform->hasChanged_ = true;
 
 }
 
-void MovementSystem::UpdateTransform(std::shared_ptr<EntityManager> entityManager, std::vector<std::shared_ptr<TransformComponent> > transformComponents, size_t ID)
+void MovementSystem::UpdateTransform(const std::shared_ptr<EntityManager>& entityManager, ComponentView<TransformComponent> transformComponents, size_t ID)
 {
+    TransformComponent* transform = transformComponents.Get(ID);
+    if (!transform)
+        return;
+
     size_t parentID = entityManager->GetParentEntityID(ID);
-    if (parentID != gsl::INVALID_SIZE)
-        UpdateFromParent(transformComponents[ID],transformComponents[static_cast<unsigned long long>(parentID)]);
+    TransformComponent* parentTransform = parentID != gsl::INVALID_SIZE ? transformComponents.Get(parentID) : nullptr;
+    if (parentTransform)
+        UpdateFromParent(transform,parentTransform);
     else
-        UpdateTransformMatrix(transformComponents[ID]);
+        UpdateTransformMatrix(transform);
+}
+
+void MovementSystem::UpdateTransforms(const std::shared_ptr<EntityManager>& entityManager, ComponentView<TransformComponent> transformComponents)
+{
+    changedTransforms_.clear();
+    for (size_t entityID : entityManager->GetDepthOrder())
+    {
+        TransformComponent* transform = transformComponents.Get(entityID);
+        if (!transform)
+            continue;
+
+        size_t parentID = entityManager->GetParentEntityID(entityID);
+        TransformComponent* parentTransform = parentID != gsl::INVALID_SIZE ? transformComponents.Get(parentID) : nullptr;
+        // a changed parent moves all its children with it
+        if (parentTransform && parentTransform->hasChanged_)
+            transform->hasChanged_ = true;
+        if (!transform->hasChanged_)
+            continue;
+
+        if (parentTransform)
+        {
+            // the parent may still be waiting in the batch
+            ComposeBatchedTransforms();
+            UpdateFromParent(transform,parentTransform);
+        }
+        else if (transform->orientRotationBasedOnMovement_)
+        {
+            UpdateTransformMatrix(transform);
+        }
+        else
+        {
+            transform->position_world_ = transform->position_relative_;
+            transform->rotation_world_ = transform->rotation_relative_;
+            transform->scale_world_ = transform->scale_relative_;
+            transformBatch_.add(transform->position_relative_, transform->rotation_relative_, transform->scale_relative_);
+            batchedTransforms_.push_back(transform);
+        }
+        changedTransforms_.push_back(transform);
+
+        if (entityID >= isMoved_.size())
+            isMoved_.resize(entityID + 1, false);
+        if (!isMoved_[entityID])
+        {
+            isMoved_[entityID] = true;
+            movedEntities_.push_back(entityID);
+        }
+    }
+    ComposeBatchedTransforms();
+
+    // cleared after the whole pass so every child could see its parent's flag
+    for (TransformComponent* transform : changedTransforms_)
+        transform->hasChanged_ = false;
+}
+
+void MovementSystem::ComposeBatchedTransforms()
+{
+    if (batchedTransforms_.empty())
+        return;
+
+    batchedMatrices_.resize(batchedTransforms_.size());
+    transformBatch_.compose(0, batchedTransforms_.size(), batchedMatrices_.data());
+    for (size_t i = 0; i < batchedTransforms_.size(); i++)
+        batchedTransforms_[i]->transform_ = batchedMatrices_[i];
+
+    transformBatch_.clear();
+    batchedTransforms_.clear();
 }
 
-void MovementSystem::UpdateFromParent(std::shared_ptr<TransformComponent> transform, std::shared_ptr<TransformComponent> transformParent)
+void MovementSystem::UpdateFromParent(TransformComponent* transform, TransformComponent* transformParent)
 {
 
     transform->position_world_ = transform->position_relative_+transformParent->position_world_;
@@ -310,7 +410,7 @@ void MovementSystem::UpdateFromParent(std::shared_ptr<TransformComponent> transf
     transform->transform_ = transformParent->transform_ * (positionMatrix_ * rotationMatrix_ * scaleMatrix_);
 }
 
-void MovementSystem::UpdateTransformMatrix(std::shared_ptr<TransformComponent> transform)
+void MovementSystem::UpdateTransformMatrix(TransformComponent* transform)
 {
 
     transform->position_world_ = transform->position_relative_;
@@ -3,9 +3,10 @@
 
 #include "Managers/entitymanager.h"
 #include "Managers/assetmanager.h"
+#include "GSL/transformbatch.h"
+#include "Systems/spatialgrid.h"
 
 
-//#include "landscape.h"
 ///Calculates and handles everything movement, and collisions.
 class MovementSystem
 {
@@ -15,29 +16,32 @@ public:
     /**
      * Updates the movement for each Entity that moves. Needs to be done each tick.
      * @param entityManager The Entity Manager that keeps all information about parent/child relationships.
-     * @param transformComponents The std::Vector of all Transform Components.
-     * @param meshComponents The std::Vector of all Mesh Components.
-     * @param AIComponents The std::Vector of all AI Components.
+     * @param transformComponents View of all Transform Components.
+     * @param meshComponents View of all Mesh Components.
+     * @param AIComponents View of all AI Components.
      * @param landscape_ The landscape that the entity may follow. used for Barycentric Cordinates.
+     * @param lightComponents View of all Light Components, their direction follows the entity's forward vector.
      */
-    void Update(std::shared_ptr<EntityManager> entityManager,
-                std::vector<std::shared_ptr<TransformComponent> > transformComponents,
-                std::vector<std::shared_ptr<MeshComponent> > meshComponents,
-                std::vector<std::shared_ptr<AIComponent> > AIComponents ,
-                std::shared_ptr<Landscape> landscape_,
-                std::vector<std::shared_ptr<LightComponent> > lightComponents,
+    void Update(const std::shared_ptr<EntityManager>& entityManager,
+                ComponentView<TransformComponent> transformComponents,
+                ComponentView<MeshComponent> meshComponents,
+                ComponentView<AIComponent> AIComponents ,
+                const std::shared_ptr<Landscape>& landscape_,
+                ComponentView<LightComponent> lightComponents,
                 size_t PlayerID = 0);
     /**
      * Goes through each movement input given to the system and uses the isColliding function to check collisions.
-     * @param transformComponents The std::Vector of all Transform Components.
-     * @param meshComponent The std::Vector of all Mesh Components.
-     * @param AIComponentsThe std::Vector of all AI Components.
+     * @param entityManager To make handles for entities that trigger events.
+     * @param transformComponents View of all Transform Components.
+     * @param meshComponent View of all Mesh Components.
+     * @param AIComponents Read-only view of all AI Components.
      * @param landscape_ The landscape that the entity may follow. used for Barycentric Cordinates.
      */
-    void UpdateMovement(std::vector<std::shared_ptr<TransformComponent> > transformComponents,
-                        std::vector<std::shared_ptr<MeshComponent> > meshComponent,
-                        std::vector<std::shared_ptr<AIComponent>> AIComponents,
-                        std::shared_ptr<Landscape> landscape_);
+    void UpdateMovement(const std::shared_ptr<EntityManager>& entityManager,
+                        ComponentView<TransformComponent> transformComponents,
+                        ComponentView<MeshComponent> meshComponent,
+                        ComponentView<const AIComponent> AIComponents,
+                        const std::shared_ptr<Landscape>& landscape_);
     /**
      * Moves the character the specified amount, if no collisions happen.
      * @param ID The Entity ID.
@@ -45,68 +49,115 @@ public:
      */
     void AddMovement(size_t ID, gsl::Vector3D value);
     /**
-     * Goes through the specified landscape and finds the Y coordinate of the specified location.
+     * Looks up the Y coordinate of the specified location in the landscape's height grid.
      * Used to set the Entity's height so that it corresponds to the landscape.
      * @param landscape_ The landscape to find the height in.
      * @param location The location of the entity, Usually their position in world.
      * @return the height amount on the landscape's specified location.
      */
-    static float FindLandscapeYOnLocation(std::shared_ptr<Landscape> landscape_, gsl::Vector3D location);
+    static float FindLandscapeYOnLocation(const std::shared_ptr<Landscape>& landscape_, gsl::Vector3D location);
 
-    ///Container that has the ID's of the cows that are currently getting caught. Used in the UpdateTrophyAnimation function.
-    std::vector<size_t> caughtTrophies_;
+    ///Container that has handles to the cows that are currently getting caught. Used in the UpdateTrophyAnimation function.
+    ///Handles to cows deleted while caught are dropped in Update.
+    std::vector<EntityHandle> caughtTrophies_;
 
     bool update_{false};
 
     /**
      * Updates the transform of the specified Entity. Use this if there is a chance a Entity has a parent.
      * @param entityManager To check parent/child relationships.
-     * @param transformComponents The std::Vector of all Transform Components.
+     * @param transformComponents View of all Transform Components.
      * @param ID The ID of the Entity.
      */
-    void UpdateTransform(std::shared_ptr<EntityManager> entityManager,
-                         std::vector<std::shared_ptr<TransformComponent> > transformComponents,
+    void UpdateTransform(const std::shared_ptr<EntityManager>& entityManager,
+                         ComponentView<TransformComponent> transformComponents,
                          size_t ID);
+    /**
+     * Updates the transform of every Entity whose Transform Component has changed, and of all their children.
+     * Goes through the entities parents first, so a child always uses its parent's updated transform.
+     * Transforms without a parent are composed together in a gsl::TransformBatch, which also covers a newly loaded scene.
+     * Clears hasChanged_ on the updated transforms, unchanged transforms cost no matrix operations.
+     * @param entityManager To get the depth order and parent/child relationships.
+     * @param transformComponents View of all Transform Components.
+     */
+    void UpdateTransforms(const std::shared_ptr<EntityManager>& entityManager,
+                          ComponentView<TransformComponent> transformComponents);
     /**
      * Updates the transform matrix of the specified Transform Component.
      * This function is unsafe, and must only be used if there is no possibility of the Entity having a parent Entity.
      * @param transform the Transform Component that to be updated.
      */
-    void UpdateTransformMatrix(std::shared_ptr<TransformComponent> transform);
-
-private:
+    void UpdateTransformMatrix(TransformComponent* transform);
     /**
-     * Updates the specified Mesh Component's bounding box for collision check. is used in the isColliding function.
-     * @param meshComponent the Mesh Component to update.
-     * @param position the movement the Entity wants to do
-     * @param transformComponent the Transform Component to multiply each point with.
-     * @return gives the specified mesh component's bounding box.
+     * Refreshes the cached world space bounding boxes on the Mesh Components of entities whose transforms changed
+     * since the last call, and moves them in the collision grid.
+     * Entities that lost their Mesh or Transform Component are removed from the grid.
+     * Must run after UpdateTransforms for the boxes to match the new transforms.
+     * @param meshComponents View of all Mesh Components.
+     * @param transformComponents Read-only view of all Transform Components.
      */
-    std::vector<gsl::Vector3D> UpdateBoundingBoxes(size_t meshComponent,
-                                                   gsl::Vector3D position,
-                                                   std::shared_ptr<TransformComponent> transformComponent);
+    void UpdateWorldBounds(ComponentView<MeshComponent> meshComponents,
+                           ComponentView<const TransformComponent> transformComponents);
     /**
-     * Goes through all bounding boxes to make sure no colliding happens with the movement input given.
+     * Empties the collision grid, must be called when the scene's entities are replaced.
+     * The Transform Components of a loaded scene start out changed, so the next UpdateWorldBounds adds them again.
+     */
+    void ClearCollisionGrid();
+
+private:
+    /**
+     * Goes through the bounding boxes near the entity to make sure no colliding happens with the movement input given.
+     * collisionGrid_ finds the nearby entities, gsl::obbOverlap decides if their cached boxes collide.
      * @param ID The entity that moves' ID.
-     * @param meshComponents The std::Vector of all Mesh Components.
-     * @param transformComponents The std::Vector of all Transform Components.
+     * @param entityManager To make handles for entities that trigger events.
+     * @param meshComponents View of all Mesh Components.
+     * @param transformComponents Read-only view of all Transform Components.
      * @param position The position the Entity is trying to move to. directly from the second portion of the std::vector<gsl::Vector3D> movements_ container.
      * @return retuns true if they're colliding, false if not.
      */
-    bool isColliding(size_t ID, std::vector<std::shared_ptr<MeshComponent> > meshComponents,
-                     std::vector<std::shared_ptr<TransformComponent> > transformComponents,
+    bool isColliding(size_t ID, const std::shared_ptr<EntityManager>& entityManager,
+                     ComponentView<MeshComponent> meshComponents,
+                     ComponentView<const TransformComponent> transformComponents,
                      gsl::Vector3D position);
 
+    ///Transforms updated in the current UpdateTransforms call, kept to avoid reallocating each tick.
+    std::vector<TransformComponent*> changedTransforms_;
+    ///Broad phase for isColliding, holds the world space bounding box of every entity with a Mesh Component.
+    SpatialGrid collisionGrid_;
+    ///Entities whose transform changed since the last UpdateWorldBounds call.
+    std::vector<size_t> movedEntities_;
+    ///Whether each entity is already in movedEntities_, indexed by entityID.
+    std::vector<bool> isMoved_;
+    ///Entities found by the last collisionGrid_ query, kept to avoid reallocating each check.
+    std::vector<size_t> collisionCandidates_;
+    ///Position, rotation and scale of the transforms waiting in batchedTransforms_.
+    gsl::TransformBatch transformBatch_;
+    ///Transforms without a parent whose matrices are built together by ComposeBatchedTransforms.
+    std::vector<TransformComponent*> batchedTransforms_;
+    ///Matrices written by the batch before they are copied to batchedTransforms_.
+    std::vector<gsl::Matrix4x4> batchedMatrices_;
+    ///Transforms moved this tick that follow the landscape, their heights are looked up together at the end of UpdateMovement.
+    std::vector<TransformComponent*> landscapeFollowers_;
+    ///Positions of landscapeFollowers_ and the heights found for them.
+    std::vector<gsl::Vector3D> landscapeLocations_;
+    std::vector<float> landscapeHeights_;
+
+    /**
+     * Builds the model matrices of all transforms in batchedTransforms_ in one pass, then empties the batch.
+     * Must run before a child reads its parent's transform_.
+     */
+    void ComposeBatchedTransforms();
+
     ///The actual container of movements. first entry is the specified Entity ID, the other is a Vector3d telling the direction they want to move.
     std::vector<std::pair<size_t,gsl::Vector3D>> movements_;
 
 
-    void UpdateAIMovement(std::shared_ptr<TransformComponent> transformComponent,
-                          std::shared_ptr<AIComponent> AIComponent,
+    void UpdateAIMovement(TransformComponent* transformComponent,
+                          AIComponent* AIComponent,
                           size_t ID,
-                          std::shared_ptr<Landscape> landscape_,
+                          const std::shared_ptr<Landscape>& landscape_,
                           gsl::Vector3D playerPosition);
-    void CheckAIState(std::shared_ptr<AIComponent> AIComponent, gsl::Vector3D AIPosition, gsl::Vector3D playerPosition);
+    void CheckAIState(AIComponent* AIComponent, gsl::Vector3D AIPosition, gsl::Vector3D playerPosition);
     /**
      * Updates the Entity with an AI and Transform Component's movement around a B-Spline curve.
      * Runs whenever the AI has the AI_PATROL state.
@@ -115,12 +166,12 @@ private:
      * @param ID The Specified Entity's ID.
      * @param landscape_ The landscape that the entity may follow. used so that the AI follows the height of the landscape.
      */
-    gsl::Vector3D AIPatrol(std::shared_ptr<TransformComponent> transformComponent,
-                           std::shared_ptr<AIComponent> AIComponent,
-                           std::shared_ptr<Landscape> landscape_);
+    gsl::Vector3D AIPatrol(TransformComponent* transformComponent,
+                           AIComponent* AIComponent,
+                           const std::shared_ptr<Landscape>& landscape_);
 
-    gsl::Vector3D AIChase(std::shared_ptr<TransformComponent> transformComponent,
-                          std::shared_ptr<Landscape> landscape_,
+    gsl::Vector3D AIChase(TransformComponent* transformComponent,
+                          const std::shared_ptr<Landscape>& landscape_,
                           gsl::Vector3D playerPosition);
     /**
      * Does linear interpolation for the specified AI Component. Changes the value locationOnSpline_ from 0 to 1.
@@ -128,31 +179,22 @@ private:
      * @param transformComponent The Entity's specified Transform Component.
      * @param landscape_ The landscape that the entity may follow. used so that the AI follows the height of the landscape.
      */
-    void Lerp(std::shared_ptr<AIComponent> AIComponent,
-              std::shared_ptr<TransformComponent> transformComponent,
-              std::shared_ptr<Landscape> landscape_);
+    void Lerp(AIComponent* AIComponent,
+              TransformComponent* transformComponent,
+              const std::shared_ptr<Landscape>& landscape_);
     /**
      * Updates any cow that gets abducted's animation.
      * @param cowTransform The cow's transform Component.
      * @param playerTransform The Player's transform Component.
      * @param index the index of the caughtCows_ the cow is in. used to remove it when the animation's done.
      */
-    void UpdateTrophyAnimation(std::shared_ptr<TransformComponent> cowTransform, std::shared_ptr<TransformComponent> playerTransform, size_t index);
+    void UpdateTrophyAnimation(TransformComponent* cowTransform, TransformComponent* playerTransform, size_t index);
     /**
      * Updates the Entity based on the parent's transform as well as their own.
      * @param transform the child's Transform Component.
      * @param transformParent the parent's Transform Component.
      */
-    void UpdateFromParent(std::shared_ptr<TransformComponent> transform, std::shared_ptr<TransformComponent> transformParent);
-
-    bool isBetweenOrdered( float val, float lowerBound, float upperBound )
-    {
-        return lowerBound <= val && val <= upperBound ;
-    }
-    bool overlaps( float min1, float max1, float min2, float max2 )
-    {
-        return isBetweenOrdered( min2, min1, max1 ) || isBetweenOrdered( min1, min2, max2 ) ;
-    }
+    void UpdateFromParent(TransformComponent* transform, TransformComponent* transformParent);
 };
 
 #endif // MOVEMENTSYSTEM_H
@@ -1,26 +1,108 @@
 #include "rendersystem.h"
 #include "Managers/assetmanager.h"
 
+#include <algorithm>
+
+namespace
+{
+/// Bits of the render queue sort key used for each part, the parts higher up change state that costs more.
+constexpr unsigned int SHADER_BITS = 8;
+constexpr unsigned int MATERIAL_BITS = 16;
+constexpr unsigned int MESH_BITS = 16;
+constexpr unsigned int LOD_BITS = 4;
+/// Enough for every primitive mode up to GL_PATCHES (0xE).
+constexpr unsigned int MODE_BITS = 4;
+constexpr unsigned int DEPTH_BITS = 16;
+static_assert(SHADER_BITS + MATERIAL_BITS + MESH_BITS + LOD_BITS + MODE_BITS + DEPTH_BITS == 64, "Render queue key must fill 64 bits");
+
+/// Puts value in the bits above shift, values too large for the bits are cut off.
+uint64_t KeyPart(uint64_t value, unsigned int bits, unsigned int shift)
+{
+    return (value & ((uint64_t(1) << bits) - 1)) << shift;
+}
+
+/**
+ * Makes the sort key for a draw, draws sharing a shader end up together, then those sharing material and so on.
+ * The draw mode is part of the key so draws that can share an instanced draw call are never split by another mode.
+ * @param depth Distance along the camera's forward vector divided by the far plane, draws close to the camera go first.
+ */
+uint64_t RenderKey(size_t shaderID, size_t materialID, size_t meshID, size_t lodLevel, GLenum mode, float depth)
+{
+    const uint64_t maxDepth = (uint64_t(1) << DEPTH_BITS) - 1;
+    uint64_t quantizedDepth = static_cast<uint64_t>(std::min(std::max(depth, 0.f), 1.f) * maxDepth);
+    return KeyPart(shaderID, SHADER_BITS, MATERIAL_BITS + MESH_BITS + LOD_BITS + MODE_BITS + DEPTH_BITS)
+         | KeyPart(materialID, MATERIAL_BITS, MESH_BITS + LOD_BITS + MODE_BITS + DEPTH_BITS)
+         | KeyPart(meshID, MESH_BITS, LOD_BITS + MODE_BITS + DEPTH_BITS)
+         | KeyPart(lodLevel, LOD_BITS, MODE_BITS + DEPTH_BITS)
+         | KeyPart(mode, MODE_BITS, DEPTH_BITS)
+         | quantizedDepth;
+}
+}
+
 RenderSystem::RenderSystem()
 {
 
 }
 
-void RenderSystem::UpdateLODlevel(std::shared_ptr<MeshComponent> meshComponent, std::shared_ptr<TransformComponent> transformComponent, std::shared_ptr<Camera> camera)
+void RenderSystem::UpdateLODlevel(MeshComponent* meshComponent, const TransformComponent* transformComponent, const std::shared_ptr<Camera>& camera)
 {
-    if(useLOD_)
+    const Mesh& mesh = *AssetManager::GetInstance()->meshManager_->meshes_[meshComponent->meshID_];
+    if(!useLOD_)
     {
         meshComponent->lodLevel_ = 0;
-        float distanceToCamera = gsl::Vector3D(transformComponent->position_world_ - camera->position_).length();
+        return;
+    }
 
-        if(AssetManager::GetInstance()->meshManager_->meshes_[meshComponent->meshID_]->VAO_[1] != 0)   //if this mesh has LOD levels
-        {
-            if (distanceToCamera > distanceLOD1_ && distanceToCamera < distanceLOD2_) //LOD 1
-                meshComponent->lodLevel_ = 1;
-            else if (distanceToCamera >= distanceLOD2_) //LOD 2
-                meshComponent->lodLevel_ = 2;
-        }
+    gsl::Vector3D center = transformComponent->position_world_;
+    float radius = 0.f;
+    if(meshComponent->hasWorldBounds_)
+    {
+        center = (meshComponent->worldMin_ + meshComponent->worldMax_) * 0.5f;
+        radius = (meshComponent->worldMax_ - meshComponent->worldMin_).length() * 0.5f;
+    }
+    else if(mesh.boundingBox_ && mesh.boundingBox_->points_.size() == 8)
+    {
+        // corners 0 and 7 are the highest and lowest corner of the mesh' box
+        const gsl::Vector3D& scale = transformComponent->scale_world_;
+        float largestScale = std::max(std::abs(scale.x), std::max(std::abs(scale.y), std::abs(scale.z)));
+        radius = (mesh.boundingBox_->points_[0] - mesh.boundingBox_->points_[7]).length() * 0.5f * largestScale;
     }
+    meshComponent->lodLevel_ = static_cast<unsigned int>(SelectLOD(mesh, meshComponent->lodLevel_, center, radius, camera));
+}
+
+size_t RenderSystem::SelectLOD(const Mesh& mesh, size_t currentLevel, const gsl::Vector3D& center, float radius, const std::shared_ptr<Camera>& camera) const
+{
+    if(mesh.lods_.size() < 2)
+        return 0;
+
+    gsl::Vector3D toCenter = center - camera->position_;
+    float distanceSquared = gsl::Vector3D::dot(toCenter, toCenter);
+    if(distanceSquared <= radius * radius)
+        return 0;
+
+    // the sphere's silhouette has the radius r / sqrt(d^2 - r^2) in view space, and (1, 1) of the projection is cot(fov / 2)
+    float projectedRadius = radius / std::sqrt(distanceSquared - radius * radius) * camera->projectionMatrix_(1, 1) * viewportHeight_ * 0.5f;
+    float wantedTriangles = gsl::PI * projectedRadius * projectedRadius / pixelsPerTriangle_;
+
+    // coarsest level that still has the triangles asked for, levels get coarser with their index
+    auto coarsestLevel = [&mesh](float triangles)
+    {
+        size_t level = 0;
+        while(level + 1 < mesh.lods_.size() && mesh.lods_[level + 1].VAO_ != 0
+              && static_cast<float>(mesh.lods_[level + 1].TriangleCount()) >= triangles)
+            level++;
+        return level;
+    };
+
+    // a level only changes once the size has moved a margin past the switch point, so it doesn't flicker right on it
+    currentLevel = std::min(currentLevel, mesh.lods_.size() - 1);
+    size_t coarser = coarsestLevel(wantedTriangles * (1.f + lodHysteresis_));
+    if(coarser > currentLevel)
+        return coarser;
+    size_t finer = coarsestLevel(wantedTriangles * (1.f - lodHysteresis_));
+    if(finer < currentLevel)
+        return finer;
+    return currentLevel;
 }
 
 void RenderSystem::SetRenderStyle(RenderStyle renderStyle)
@@ -61,20 +143,31 @@ void RenderSystem::SetRenderStyle(RenderStyle renderStyle)
     }
 }
 
-void RenderSystem::Update(std::vector<std::shared_ptr<Camera>> cameras,
+void RenderSystem::Update(const std::vector<std::shared_ptr<Camera>>& cameras,
                           size_t activeCameraID,
                           size_t activeEntityID,
-                          std::shared_ptr<EntityManager> entityManager,
-                          std::vector<std::shared_ptr<MeshComponent> > meshComponents,
-                          std::vector<std::shared_ptr<TransformComponent> > transformComponents,
-                          std::vector<std::shared_ptr<LightComponent>> lightComponents,
-                          std::shared_ptr<ShaderManager> shaderManager)
+                          const std::shared_ptr<EntityManager>& entityManager,
+                          ComponentView<MeshComponent> meshComponents,
+                          ComponentView<const TransformComponent> transformComponents,
+                          ComponentView<const LightComponent> lightComponents,
+                          const std::shared_ptr<ShaderManager>& shaderManager)
 {
 
     initializeOpenGLFunctions();
 
     verticesDrawn_ = 0;
     entitiesDrawn_ = 0;
+    stateChanges_ = 0;
+    drawCalls_ = 0;
+    renderQueue_.clear();
+
+    // camera and lights are read from uniform buffers shared by all shaders, so they are sent once here instead of for every draw
+    shaderManager->UpdateCameraBuffer();
+    ForEach(lightComponents, transformComponents, [&](size_t, const LightComponent& light, const TransformComponent& transform)
+    {
+        shaderManager->SetLightData(transform.position_world_, &light);
+    });
+    shaderManager->UpdateLightBuffer();
 
 
     // RENDER CAMERAS
@@ -86,65 +179,75 @@ void RenderSystem::Update(std::vector<std::shared_ptr<Camera>> cameras,
         }
     }
 
-    RenderLandscape();
-
-    bool renderActiveEntity = false;
+    RenderLandscape(cameras[activeCameraID]);
 
-    for (size_t i = 0; i < meshComponents.size(); i++)
-    {
-        if (!transformComponents[i])
-            continue;
+    if(useFrustumCulling_)
+        CullMeshes(meshComponents, transformComponents, cameras[activeCameraID]);
 
-        // ADD LIGHT DATA TO PHONG SHADER
-        if(lightComponents[i])
-        {
-            shaderManager->TransmitUniformLightDataToShader(PHONG_SHADER, transformComponents[i]->position_world_, lightComponents[i]);
-        }
+    const MeshComponent* activeMeshComponent = nullptr;
+    const TransformComponent* activeTransformComponent = nullptr;
 
-        if (!meshComponents[i])
+    for (size_t slot = 0; slot < meshComponents.size(); slot++)
+    {
+        size_t entityID = meshComponents.EntityAt(slot);
+        const TransformComponent* transformComponent = transformComponents.Get(entityID);
+        if (!transformComponent)
             continue;
+        MeshComponent* meshComponent = &meshComponents[slot];
 
         // RENDER BOUNDING BOX
-        if(showBoundingBoxes_ && AssetManager::GetInstance()->meshManager_->meshes_[meshComponents[i]->meshID_]->boundingBox_)
-            RenderOBB(AssetManager::GetInstance()->meshManager_->meshes_[meshComponents[i]->meshID_]->boundingBox_, transformComponents[i], shaderManager);
+        if(showBoundingBoxes_ && AssetManager::GetInstance()->meshManager_->meshes_[meshComponent->meshID_]->boundingBox_)
+            RenderOBB(AssetManager::GetInstance()->meshManager_->meshes_[meshComponent->meshID_]->boundingBox_, transformComponent, shaderManager);
 
-        if (entityManager->entities_[static_cast<int>(i)]->checkState(0) == Qt::CheckState::Unchecked)
+        if (!entityManager->IsVisible(entityID))
             continue;
 
         // CHECK IF WITHIN FRUSTUM
-        if(useFrustumCulling_)
-            if(meshComponents[i]->reactsToFrustumCulling_ && !insideFrustum(cameras[activeCameraID], transformComponents[i]->position_world_, frustumCullingDistance_))
-                continue;
+        if(useFrustumCulling_ && !visibleSlots_[slot])
+            continue;
 
-        UpdateLODlevel(meshComponents[i], transformComponents[i], cameras[activeCameraID]);
+        if (AssetManager::GetInstance()->meshManager_->meshes_[meshComponent->meshID_]->lods_.empty())
+            continue;
+        UpdateLODlevel(meshComponent, transformComponent, cameras[activeCameraID]);
 
-        verticesDrawn_ += AssetManager::GetInstance()->meshManager_->meshes_[meshComponents[i]->meshID_]->numberOfVertices_[meshComponents[i]->lodLevel_];
+        verticesDrawn_ += AssetManager::GetInstance()->meshManager_->meshes_[meshComponent->meshID_]->lods_[meshComponent->lodLevel_].numberOfVertices_;
         entitiesDrawn_++;
 
-        if(i == activeEntityID
+        if(entityID == activeEntityID
                 && showSelection_)
-            renderActiveEntity = true;
+        {
+            activeMeshComponent = meshComponent;
+            activeTransformComponent = transformComponent;
+        }
         else
-            RenderNormally(meshComponents[i], transformComponents[i], shaderManager);
-
+        {
+            const std::shared_ptr<Camera>& camera = cameras[activeCameraID];
+            gsl::Vector3D center = meshComponent->hasWorldBounds_ ? (meshComponent->worldMin_ + meshComponent->worldMax_) * 0.5f : transformComponent->position_world_;
+            float depth = gsl::Vector3D::dot(center - camera->position_, camera->forward()) / camera->farPlane_;
+            size_t shaderID = AssetManager::GetInstance()->materialManager_->materials_[meshComponent->materialID_]->shaderID_;
+            renderQueue_.push_back({RenderKey(shaderID, meshComponent->materialID_, meshComponent->meshID_, meshComponent->lodLevel_, meshComponent->mode_, depth),
+                                    meshComponent, transformComponent});
+        }
     }
 
-    if (renderActiveEntity)
-        RenderOutline(meshComponents[activeEntityID], transformComponents[activeEntityID], shaderManager);
+    RenderQueue(shaderManager);
+
+    if (activeMeshComponent)
+        RenderOutline(activeMeshComponent, activeTransformComponent, shaderManager);
 
 
 }
 
-void RenderSystem::RenderCamera(std::shared_ptr<Camera> camera,
-                                std::shared_ptr<ShaderManager> shaderManager)
+void RenderSystem::RenderCamera(const std::shared_ptr<Camera>& camera,
+                                const std::shared_ptr<ShaderManager>& shaderManager)
 {
     if (!AssetManager::GetInstance()->meshManager_->cameraMesh_)
         return;
 
     // Camera mesh
-    glBindVertexArray( AssetManager::GetInstance()->meshManager_->cameraMesh_->VAO_[0] );
+    glBindVertexArray( AssetManager::GetInstance()->meshManager_->cameraMesh_->lods_[0].VAO_ );
     shaderManager->TransmitUniformDataToShader(AssetManager::GetInstance()->materialManager_->materials_[0], &camera->CameraTransform_->transform_);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(AssetManager::GetInstance()->meshManager_->cameraMesh_->numberOfIndices_[0]), GL_UNSIGNED_INT, nullptr);
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(AssetManager::GetInstance()->meshManager_->cameraMesh_->lods_[0].numberOfIndices_), GL_UNSIGNED_INT, nullptr);
 
     //Frustum mesh
     glBindVertexArray(AssetManager::GetInstance()->meshManager_->meshes_[0]->boundingBox_->VAO_);
@@ -153,23 +256,42 @@ void RenderSystem::RenderCamera(std::shared_ptr<Camera> camera,
     glBindVertexArray(0);
 }
 
-void RenderSystem::RenderLandscape()
+void RenderSystem::RenderLandscape(const std::shared_ptr<Camera>& camera)
 {
-    if (!AssetManager::GetInstance()->meshManager_->landscapeMesh_)
+    const std::shared_ptr<Landscape>& landscape = AssetManager::GetInstance()->landscape_;
+    const std::vector<std::shared_ptr<Mesh>>& tiles = AssetManager::GetInstance()->meshManager_->landscapeTiles_;
+    if (!landscape || tiles.size() != landscape->tiles_.size())
         return;
 
+    landscapeTileLODs_.resize(tiles.size(), 0);
+
     gsl::Matrix4x4 tempModelMatrix;
     tempModelMatrix.setToIdentity();
-    // Landscape mesh
-    glBindVertexArray( AssetManager::GetInstance()->meshManager_->landscapeMesh_->VAO_[0] );
+    AssetManager::GetInstance()->shaderManager_->TransmitUniformDataToShader(AssetManager::GetInstance()->materialManager_->materials_[landscape->materialID_], &tempModelMatrix);
 
-    AssetManager::GetInstance()->shaderManager_->TransmitUniformDataToShader(AssetManager::GetInstance()->materialManager_->materials_[AssetManager::GetInstance()->landscape_->materialID_], &tempModelMatrix);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(AssetManager::GetInstance()->meshManager_->landscapeMesh_->numberOfIndices_[0]), GL_UNSIGNED_INT, nullptr);
+    for (size_t i = 0; i < tiles.size(); i++)
+    {
+        const LandscapeTile& tile = landscape->tiles_[i];
+        if (useFrustumCulling_ && !insideFrustum(camera, tile.min_, tile.max_))
+            continue;
+
+        // the tile the camera is over is inside its sphere, so it always gets full detail
+        size_t lodLevel = 0;
+        if (useLOD_)
+            lodLevel = SelectLOD(*tiles[i], landscapeTileLODs_[i], (tile.min_ + tile.max_) * 0.5f, (tile.max_ - tile.min_).length() * 0.5f, camera);
+        landscapeTileLODs_[i] = lodLevel;
+
+        const MeshLOD& lod = tiles[i]->lods_[lodLevel];
+        verticesDrawn_ += lod.numberOfVertices_;
+        glBindVertexArray(lod.VAO_);
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(lod.numberOfIndices_), GL_UNSIGNED_INT, nullptr);
+    }
+    glBindVertexArray(0);
 }
 
-void RenderSystem::RenderOBB(std::shared_ptr<BoundingBox> boundingBox,
-                             std::shared_ptr<TransformComponent> transformComponent,
-                             std::shared_ptr<ShaderManager> shaderManager)
+void RenderSystem::RenderOBB(const std::shared_ptr<BoundingBox>& boundingBox,
+                             const TransformComponent* transformComponent,
+                             const std::shared_ptr<ShaderManager>& shaderManager)
 {
     glStencilMask(0x00);
 
@@ -179,26 +301,89 @@ void RenderSystem::RenderOBB(std::shared_ptr<BoundingBox> boundingBox,
     glBindVertexArray(0);
 }
 
-void RenderSystem::RenderNormally(std::shared_ptr<MeshComponent> meshComponent,
-                                  std::shared_ptr<TransformComponent> transformComponent,
-                                  std::shared_ptr<ShaderManager> shaderManager)
+void RenderSystem::RenderQueue(const std::shared_ptr<ShaderManager>& shaderManager)
 {
+    std::sort(renderQueue_.begin(), renderQueue_.end(), [](const RenderItem& a, const RenderItem& b){ return a.key_ < b.key_; });
+
     glStencilMask(0x00);
 
-    glBindVertexArray( AssetManager::GetInstance()->meshManager_->meshes_[meshComponent->meshID_]->VAO_[meshComponent->lodLevel_] );
-    shaderManager->TransmitUniformDataToShader(AssetManager::GetInstance()->materialManager_->materials_[meshComponent->materialID_], &transformComponent->transform_);
-    RenderMesh(AssetManager::GetInstance()->meshManager_->meshes_[meshComponent->meshID_], meshComponent->lodLevel_, meshComponent->mode_);
+    const std::vector<std::shared_ptr<Mesh>>& meshes = AssetManager::GetInstance()->meshManager_->meshes_;
+    const std::vector<std::shared_ptr<Material>>& materials = AssetManager::GetInstance()->materialManager_->materials_;
+    const size_t none = static_cast<size_t>(-1);
+    size_t currentShader = none;
+    bool currentInstanced = false;
+    size_t currentMaterial = none;
+    GLuint currentVAO = 0;
+
+    for (size_t first = 0; first < renderQueue_.size();)
+    {
+        const MeshComponent* meshComponent = renderQueue_[first].meshComponent_;
+        const std::shared_ptr<Material>& material = materials[meshComponent->materialID_];
+
+        // the sort puts draws of the same mesh, LOD level and material next to each other, those can be one instanced draw
+        size_t end = first + 1;
+        while (end < renderQueue_.size()
+               && renderQueue_[end].meshComponent_->meshID_ == meshComponent->meshID_
+               && renderQueue_[end].meshComponent_->lodLevel_ == meshComponent->lodLevel_
+               && renderQueue_[end].meshComponent_->materialID_ == meshComponent->materialID_
+               && renderQueue_[end].meshComponent_->mode_ == meshComponent->mode_)
+            end++;
+        bool instanced = useInstancing_ && end - first >= minimumInstances_ && shaderManager->shaders_[material->shaderID_]->instanced_;
+        if (!instanced)
+            end = first + 1;
+
+        if (material->shaderID_ != currentShader || instanced != currentInstanced)
+        {
+            shaderManager->UseShader(material->shaderID_, instanced);
+            currentShader = material->shaderID_;
+            currentInstanced = instanced;
+            currentMaterial = none;
+            stateChanges_++;
+        }
+        if (meshComponent->materialID_ != currentMaterial)
+        {
+            shaderManager->TransmitMaterialDataToShader(material, instanced);
+            currentMaterial = meshComponent->materialID_;
+            stateChanges_++;
+        }
+        const std::shared_ptr<Mesh>& mesh = meshes[meshComponent->meshID_];
+        if (mesh->lods_[meshComponent->lodLevel_].VAO_ != currentVAO)
+        {
+            currentVAO = mesh->lods_[meshComponent->lodLevel_].VAO_;
+            glBindVertexArray(currentVAO);
+            stateChanges_++;
+        }
+
+        if (instanced)
+        {
+            instanceMatrices_.clear();
+            for (size_t i = first; i < end; i++)
+                instanceMatrices_.push_back(renderQueue_[i].transformComponent_->transform_);
+
+            // a new store each draw, so the driver doesn't have to wait for the last draw to finish reading the old one
+            glBindBuffer(GL_ARRAY_BUFFER, AssetManager::GetInstance()->meshManager_->instanceVBO_);
+            GLsizeiptr size = static_cast<GLsizeiptr>(instanceMatrices_.size() * sizeof(gsl::Matrix4x4));
+            glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, size, instanceMatrices_.data());
+        }
+        else
+            shaderManager->TransmitModelMatrixToShader(currentShader, &renderQueue_[first].transformComponent_->transform_);
+        RenderMesh(mesh, meshComponent->lodLevel_, meshComponent->mode_, end - first);
+
+        first = end;
+    }
+    glBindVertexArray(0);
 }
 
-void RenderSystem::RenderOutline(std::shared_ptr<MeshComponent> meshComponent,
-                                 std::shared_ptr<TransformComponent> transformComponent,
-                                 std::shared_ptr<ShaderManager> shaderManager)
+void RenderSystem::RenderOutline(const MeshComponent* meshComponent,
+                                 const TransformComponent* transformComponent,
+                                 const std::shared_ptr<ShaderManager>& shaderManager)
 {
     glStencilFunc(GL_ALWAYS, 1, 0xFF); // all fragments should update the stencil buffer
     glStencilMask(0xFF); // enable writing to the stencil buffer
 
     // RENDER OBJECT
-    glBindVertexArray( AssetManager::GetInstance()->meshManager_->meshes_[meshComponent->meshID_]->VAO_[meshComponent->lodLevel_] );
+    glBindVertexArray( AssetManager::GetInstance()->meshManager_->meshes_[meshComponent->meshID_]->lods_[meshComponent->lodLevel_].VAO_ );
     shaderManager->TransmitUniformDataToShader(AssetManager::GetInstance()->materialManager_->materials_[meshComponent->materialID_], &transformComponent->transform_);
     RenderMesh(AssetManager::GetInstance()->meshManager_->meshes_[meshComponent->meshID_], meshComponent->lodLevel_, meshComponent->mode_);
 
@@ -207,13 +392,14 @@ void RenderSystem::RenderOutline(std::shared_ptr<MeshComponent> meshComponent,
     glStencilMask(0x00); // disable writing to the stencil buffer
     glDisable(GL_DEPTH_TEST);
 
-    glBindVertexArray( AssetManager::GetInstance()->meshManager_->meshes_[meshComponent->meshID_]->VAO_[meshComponent->lodLevel_] );
+    glBindVertexArray( AssetManager::GetInstance()->meshManager_->meshes_[meshComponent->meshID_]->lods_[meshComponent->lodLevel_].VAO_ );
 
     gsl::Matrix4x4 tempTransform = transformComponent->transform_;
     tempTransform.scale(calculateOutlineSize(transformComponent->scale_relative_));
 
     shaderManager->TransmitUniformDataToShader(MONO_COLOR_SHADER, &tempTransform, selectionColor_);
     RenderMesh(AssetManager::GetInstance()->meshManager_->meshes_[meshComponent->meshID_], meshComponent->lodLevel_, GL_TRIANGLES);
+    glBindVertexArray(0);
 
     glStencilMask(0xFF);
     glEnable(GL_DEPTH_TEST);
@@ -237,25 +423,101 @@ gsl::Vector3D RenderSystem::calculateOutlineSize(gsl::Vector3D originalSize)
     return temp;
 }
 
-void RenderSystem::RenderMesh(std::shared_ptr<Mesh> mesh, uint lodLevel, GLenum mode)
+void RenderSystem::RenderMesh(const std::shared_ptr<Mesh>& mesh, uint lodLevel, GLenum mode, size_t instances)
 {
-    if (mesh->numberOfIndices_[lodLevel] > 0)
-        glDrawElements(mode, static_cast<GLsizei>(mesh->numberOfIndices_[lodLevel]), GL_UNSIGNED_INT, nullptr);
+    const MeshLOD& lod = mesh->lods_[lodLevel];
+    drawCalls_++;
+    if (instances > 1)
+    {
+        if (lod.numberOfIndices_ > 0)
+            glDrawElementsInstanced(mode, static_cast<GLsizei>(lod.numberOfIndices_), GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(instances));
+        else
+            glDrawArraysInstanced(mode, 0, static_cast<GLsizei>(lod.numberOfVertices_), static_cast<GLsizei>(instances));
+    }
+    else if (lod.numberOfIndices_ > 0)
+        glDrawElements(mode, static_cast<GLsizei>(lod.numberOfIndices_), GL_UNSIGNED_INT, nullptr);
     else
-        glDrawArrays(mode, 0, static_cast<GLsizei>(mesh->numberOfVertices_[lodLevel]));
-    glBindVertexArray(0);
+        glDrawArrays(mode, 0, static_cast<GLsizei>(lod.numberOfVertices_));
 }
 
-bool RenderSystem::insideFrustum(std::shared_ptr<Camera> camera, gsl::Vector3D position, float radius)
+bool RenderSystem::insideFrustum(const std::shared_ptr<Camera>& camera, const gsl::Vector3D& min, const gsl::Vector3D& max)
 {
     for (unsigned int i{0}; i < 6; i++)
     {
+        // the corner furthest along the plane normal, if it is outside the plane the whole box is
         gsl::Vector3D normal = camera->frustum_[i].normal;
-        float distance = camera->frustum_[i].distanceToOrigo;
-        float distanceToPlane = gsl::Vector3D::dot(position, normal) + distance;
-
-        if(distanceToPlane < radius)    //This should be distanceToPlane < 0.f and radius tested another way
+        gsl::Vector3D corner(normal.x >= 0.f ? max.x : min.x,
+                             normal.y >= 0.f ? max.y : min.y,
+                             normal.z >= 0.f ? max.z : min.z);
+        if(gsl::Vector3D::dot(corner, normal) + camera->frustum_[i].distanceToOrigo < 0.f)
             return false;
     }
     return true;
 }
+
+void RenderSystem::CullMeshes(ComponentView<MeshComponent> meshComponents, ComponentView<const TransformComponent> transformComponents, const std::shared_ptr<Camera>& camera)
+{
+    // boxes are written over last frame's, so the tree is only refit when one of them has changed
+    size_t boxCount = 0;
+    bool boxesChanged = false;
+    auto addBox = [&](size_t slot, const gsl::Vector3D& min, const gsl::Vector3D& max)
+    {
+        if (boxCount == cullingSlots_.size())
+        {
+            cullingMins_.push_back(min);
+            cullingMaxs_.push_back(max);
+            cullingSlots_.push_back(slot);
+            boxesChanged = true;
+        }
+        else if (cullingSlots_[boxCount] != slot || !(cullingMins_[boxCount] == min) || !(cullingMaxs_[boxCount] == max))
+        {
+            cullingMins_[boxCount] = min;
+            cullingMaxs_[boxCount] = max;
+            cullingSlots_[boxCount] = slot;
+            boxesChanged = true;
+        }
+        boxCount++;
+    };
+
+    visibleSlots_.assign(meshComponents.size(), 1);
+    for (size_t slot = 0; slot < meshComponents.size(); slot++)
+    {
+        const MeshComponent& meshComponent = meshComponents[slot];
+        const TransformComponent* transformComponent = transformComponents.Get(meshComponents.EntityAt(slot));
+        if (!transformComponent || !meshComponent.reactsToFrustumCulling_)
+            continue;
+
+        if (meshComponent.hasWorldBounds_)
+        {
+            addBox(slot, meshComponent.worldMin_, meshComponent.worldMax_);
+            continue;
+        }
+        const std::shared_ptr<BoundingBox>& boundingBox = AssetManager::GetInstance()->meshManager_->meshes_[meshComponent.meshID_]->boundingBox_;
+        if (!boundingBox || boundingBox->points_.empty())
+            continue;
+        // the sphere around the entity's position reaching the mesh' furthest corner holds the mesh at any rotation
+        const gsl::Vector3D& scale = transformComponent->scale_world_;
+        float largestScale = std::max(std::abs(scale.x), std::max(std::abs(scale.y), std::abs(scale.z)));
+        float radius = 0.f;
+        for (const gsl::Vector3D& point : boundingBox->points_)
+            radius = std::max(radius, point.length());
+        radius *= largestScale;
+        gsl::Vector3D extent(radius, radius, radius);
+        addBox(slot, transformComponent->position_world_ - extent, transformComponent->position_world_ + extent);
+    }
+    cullingMins_.resize(boxCount);
+    cullingMaxs_.resize(boxCount);
+    cullingSlots_.resize(boxCount);
+
+    if (cullingTree_.Size() != boxCount || (boxesChanged && ++framesSinceCullingBuild_ >= cullingRebuildInterval_))
+    {
+        cullingTree_.Build(cullingMins_, cullingMaxs_);
+        framesSinceCullingBuild_ = 0;
+    }
+    else if (boxesChanged)
+        cullingTree_.Refit(cullingMins_, cullingMaxs_);
+
+    cullingTree_.Cull(camera->frustum_, visibleBoxes_);
+    for (size_t box = 0; box < cullingSlots_.size(); box++)
+        visibleSlots_[cullingSlots_[box]] = visibleBoxes_[box];
+}
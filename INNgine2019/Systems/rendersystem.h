@@ -5,7 +5,9 @@
 #include "Managers/entitymanager.h"
 #include "Managers/meshmanager.h"
 #include "Managers/shadermanager.h"
+#include "Managers/componentview.h"
 #include "Legacy/camera.h"
+#include "Systems/boundingvolumetree.h"
 
 /// Used to change all materials to match a certain render style
 /// Should be a part of the render system, but for lack of time is placed here
@@ -19,6 +21,17 @@ enum RenderStyle
     LIGHT_ONLY
 };
 
+/// One draw in the render queue, built every frame and sorted by key to keep state changes down.
+struct RenderItem
+{
+    /// Sort key, from most to least significant bits: shader, material, mesh, LOD level and depth.
+    uint64_t key_{0};
+    /// Mesh to draw.
+    const MeshComponent* meshComponent_{nullptr};
+    /// Transform to draw it with.
+    const TransformComponent* transformComponent_{nullptr};
+};
+
 /// Contains the logic on how to render objects every tick.
 class RenderSystem : public QOpenGLFunctions_4_1_Core
 {
@@ -29,6 +42,10 @@ public:
     size_t verticesDrawn_{0};
     /// Number of entities drawn each frame, used to see perfomance.
     size_t entitiesDrawn_{0};
+    /// Number of program, material and VAO binds each frame, used to see perfomance.
+    size_t stateChanges_{0};
+    /// Number of mesh draw calls each frame, an instanced draw counts once, used to see perfomance.
+    size_t drawCalls_{0};
 
     /// Whether to use frustum culling.
     bool useFrustumCulling_{true};
@@ -40,12 +57,18 @@ public:
     bool useLOD_{true};
     /// Whether to render outline for selected entity.
     bool showSelection_{true};
-    /// Defines distance between camera and entity befor using a level 1 LOD for the entity.
-    float distanceLOD1_{20};
-    /// Defines distance between camera and entity befor using level 2 LOD for the entity.
-    float distanceLOD2_{50};
-    /// Defines distance from entity origo frustum plane can be before entity is not rendered.
-    float frustumCullingDistance_{-0.8f};
+    /// Whether to draw meshes sharing mesh, LOD level and material with one instanced draw call.
+    bool useInstancing_{true};
+    /// Fewest meshes drawn instanced, fewer are drawn one by one since filling the instance buffer costs more than it saves.
+    size_t minimumInstances_{4};
+    /// Screen area in pixels each triangle should cover, the coarsest LOD level with at least the triangles that asks for is used.
+    float pixelsPerTriangle_{10.f};
+    /// How far, as a share of the triangle count, the projected size must pass a switch point before the LOD level changes, avoids popping.
+    float lodHysteresis_{0.2f};
+    /// Height of the viewport in pixels, used to find the projected size of meshes.
+    float viewportHeight_{600.f};
+    /// Frames with moved entities the culling tree is refit before it is built again, refitting is cheaper but the tree loosens as entities move.
+    size_t cullingRebuildInterval_{120};
     /// Color of Boundting Boxes when rendered.
     gsl::Vector3D boundingBoxColor_{255, 0, 0};
     /// Color of Outline on Selected entity.
@@ -59,20 +82,22 @@ public:
      * @param activeCameraID
      * @param activeEntityID
      * @param entityManager
-     * @param meshComponents
-     * @param transformComponents
-     * @param lightComponents
+     * @param meshComponents View of all Mesh Components, iterated densely. Only the LOD level is written.
+     * @param transformComponents Read-only view of all Transform Components.
+     * @param lightComponents Read-only view of all Light Components.
      * @param shaderManager to get acces to all shaders.
      */
-    void Update(std::vector<std::shared_ptr<Camera> > cameras, size_t activeCameraID, size_t activeEntityID, std::shared_ptr<EntityManager> entityManager,
-                std::vector<std::shared_ptr<MeshComponent>> meshComponents,
-                std::vector<std::shared_ptr<TransformComponent>> transformComponents,
-                std::vector<std::shared_ptr<LightComponent>> lightComponents,
-                std::shared_ptr<ShaderManager> shaderManager);
+    void Update(const std::vector<std::shared_ptr<Camera> >& cameras, size_t activeCameraID, size_t activeEntityID, const std::shared_ptr<EntityManager>& entityManager,
+                ComponentView<MeshComponent> meshComponents,
+                ComponentView<const TransformComponent> transformComponents,
+                ComponentView<const LightComponent> lightComponents,
+                const std::shared_ptr<ShaderManager>& shaderManager);
     /**
      * Renders the scene landscape.
+     * Tiles outside the camera frustum are skipped, and tiles small on screen use their lower LOD levels.
+     * @param camera Active Camera.
      */
-    void RenderLandscape();
+    void RenderLandscape(const std::shared_ptr<Camera>& camera);
     /**
      * Sets the renderstyle for the scene.
      * @param renderStyle The render style to use.
@@ -84,26 +109,25 @@ private:
      * @param camera Camera to be rendered.
      * @param shaderManager
      */
-    void RenderCamera(std::shared_ptr<Camera> camera, std::shared_ptr<ShaderManager> shaderManager);
+    void RenderCamera(const std::shared_ptr<Camera>& camera, const std::shared_ptr<ShaderManager>& shaderManager);
     /**
      * Renders a Bounding box.
      * @param boundingBox Bounding box to render.
      * @param transformComponent Transform to use for bounding box.
      * @param shaderManager
      */
-    void RenderOBB(std::shared_ptr<BoundingBox> boundingBox,
-                   std::shared_ptr<TransformComponent> transformComponent,
-                   std::shared_ptr<ShaderManager> shaderManager);
+    void RenderOBB(const std::shared_ptr<BoundingBox>& boundingBox,
+                   const TransformComponent* transformComponent,
+                   const std::shared_ptr<ShaderManager>& shaderManager);
     /**
-     * Renders a mesh.
-     * Creates a stencilMask from a mesh when rendering it,
-     * @param meshComponent Mesh to render.
-     * @param transformComponent Transform to use for mesh.
+     * Sorts the render queue and draws it.
+     * The program, material and VAO are only changed when they differ from the draw before,
+     * so meshes sharing a material only cost a model matrix and a draw call each.
+     * Runs of at least minimumInstances_ draws of the same mesh, LOD level and material are drawn with one instanced draw call,
+     * their model matrices are put in the mesh manager's instance buffer.
      * @param shaderManager
      */
-    void RenderNormally(std::shared_ptr<MeshComponent> meshComponent,
-                      std::shared_ptr<TransformComponent> transformComponent,
-                      std::shared_ptr<ShaderManager> shaderManager);
+    void RenderQueue(const std::shared_ptr<ShaderManager>& shaderManager);
     /**
      * Renders a mesh and an outline for the mesh.
      * Creates a stencilMask from a mesh when rendering it,
@@ -114,18 +138,28 @@ private:
      * @param transformComponent Transform to use for mesh.
      * @param shaderManager
      */
-    void RenderOutline(std::shared_ptr<MeshComponent> meshComponent,
-                       std::shared_ptr<TransformComponent> transformComponent,
-                       std::shared_ptr<ShaderManager> shaderManager);
+    void RenderOutline(const MeshComponent* meshComponent,
+                       const TransformComponent* transformComponent,
+                       const std::shared_ptr<ShaderManager>& shaderManager);
     /**
-     * Checks if raius around position is within camera frustum.
-     * Used for frustum culling to see if mesh should be rendered.
+     * Frustum culls all meshes through cullingTree_ and fills visibleSlots_.
+     * The boxes are compared to last frame's, so a still scene costs one pass over the meshes and the tree's cull.
+     * Meshes use their cached world bounds, or a box around the sphere holding the mesh' box at the entity's position before those are calculated.
+     * Meshes without a box, or not reacting to frustum culling, are always visible.
+     * @param meshComponents View of all Mesh Components.
+     * @param transformComponents View of all Transform Components.
      * @param camera Active Camera.
-     * @param position Entity position.
-     * @param radius Radius around position to check for.
-     * @return Whether entity is within camera frustum.
      */
-    bool insideFrustum(std::shared_ptr<Camera> camera, gsl::Vector3D position, float radius);
+    void CullMeshes(ComponentView<MeshComponent> meshComponents, ComponentView<const TransformComponent> transformComponents, const std::shared_ptr<Camera>& camera);
+    /**
+     * Checks if an axis aligned box is at least partly within camera frustum.
+     * Used for frustum culling with the world space box cached on the Mesh Component.
+     * @param camera Active Camera.
+     * @param min Lowest corner of the box.
+     * @param max Highest corner of the box.
+     * @return Whether the box is within camera frustum.
+     */
+    bool insideFrustum(const std::shared_ptr<Camera>& camera, const gsl::Vector3D& min, const gsl::Vector3D& max);
     /**
      * Calculates a new slightly bigger scale to be used for outline based on mesh' original size.
      * @param originalSize Mesh' original scale.
@@ -134,18 +168,54 @@ private:
     gsl::Vector3D calculateOutlineSize(gsl::Vector3D originalSize);
     /**
      * OpenGL draw calls for basic mesh.
+     * The LOD level's VAO must be bound, and is left bound so the next draw of the same mesh can use it.
      * @param mesh mesh to render.
      * @param lodLevel current lod level to render.
      * @param mode what mode to render in.
+     * @param instances Number of copies to draw, more than one needs an instanced shader and the instance buffer filled.
      */
-    void RenderMesh(std::shared_ptr<Mesh> mesh, uint lodLevel = 0, GLenum mode = GL_TRIANGLES);
+    void RenderMesh(const std::shared_ptr<Mesh>& mesh, uint lodLevel = 0, GLenum mode = GL_TRIANGLES, size_t instances = 1);
     /**
      * Checks what LOD level to use and updates the mesh component
+     * Uses the sphere around the cached world bounds, or around the mesh' box at the entity's position before those are calculated.
      * @param meshComponent mesh component to update/check.
      * @param transformComponent transform component to check.
      * @param camera Camera to check distance from.
      */
-    void UpdateLODlevel(std::shared_ptr<MeshComponent> meshComponent, std::shared_ptr<TransformComponent> transformComponent, std::shared_ptr<Camera> camera);
+    void UpdateLODlevel(MeshComponent* meshComponent, const TransformComponent* transformComponent, const std::shared_ptr<Camera>& camera);
+    /**
+     * Picks a LOD level from the projected size of a bounding sphere.
+     * The sphere's screen area divided by pixelsPerTriangle_ is the number of triangles wanted,
+     * and the level only changes once that is lodHysteresis_ past the switch point.
+     * @param mesh Mesh with the LOD levels to pick from.
+     * @param currentLevel Level used last frame.
+     * @param center World space center of the sphere.
+     * @param radius Radius of the sphere.
+     * @param camera Camera to project with.
+     * @return The level to use, 0 if the camera is inside the sphere.
+     */
+    size_t SelectLOD(const Mesh& mesh, size_t currentLevel, const gsl::Vector3D& center, float radius, const std::shared_ptr<Camera>& camera) const;
+
+    /// LOD level of each landscape tile last frame, for the hysteresis in SelectLOD.
+    std::vector<size_t> landscapeTileLODs_;
+    /// Draws for this frame, kept between frames so its memory is reused.
+    std::vector<RenderItem> renderQueue_;
+    /// Model matrices of the instanced draw being built, kept between frames so its memory is reused.
+    std::vector<gsl::Matrix4x4> instanceMatrices_;
+    /// Bounds of the culled meshes, refit when they move, and built again every cullingRebuildInterval_ such frames or when the number of meshes changes.
+    BoundingVolumeTree cullingTree_;
+    /// Frames with moved entities since cullingTree_ was built.
+    size_t framesSinceCullingBuild_{0};
+    /// Lowest corner of each box in cullingTree_.
+    std::vector<gsl::Vector3D> cullingMins_;
+    /// Highest corner of each box in cullingTree_.
+    std::vector<gsl::Vector3D> cullingMaxs_;
+    /// Mesh Component slot of each box in cullingTree_.
+    std::vector<size_t> cullingSlots_;
+    /// Whether each box in cullingTree_ is inside the frustum.
+    std::vector<char> visibleBoxes_;
+    /// Whether the Mesh Component in each slot is inside the frustum, filled by CullMeshes.
+    std::vector<char> visibleSlots_;
 
 
 };
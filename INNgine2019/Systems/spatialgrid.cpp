@@ -0,0 +1,183 @@
+#include "spatialgrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+bool BoxesOverlap(const gsl::Vector3D& minA, const gsl::Vector3D& maxA, const gsl::Vector3D& minB, const gsl::Vector3D& maxB)
+{
+    return minA.x <= maxB.x && minB.x <= maxA.x &&
+           minA.y <= maxB.y && minB.y <= maxA.y &&
+           minA.z <= maxB.z && minB.z <= maxA.z;
+}
+
+/// Removes the first occurrence of value by swapping in the last element.
+void SwapRemove(std::vector<size_t>& values, size_t value)
+{
+    auto it = std::find(values.begin(), values.end(), value);
+    if (it == values.end())
+        return;
+    *it = values.back();
+    values.pop_back();
+}
+}
+
+SpatialGrid::SpatialGrid(float cellSize) : cellSize_(cellSize)
+{
+}
+
+int SpatialGrid::CellCoordinate(float value) const
+{
+    return static_cast<int>(std::floor(value / cellSize_));
+}
+
+unsigned long long SpatialGrid::CellKey(int x, int y, int z)
+{
+    const unsigned long long mask = (1ull << 21) - 1;
+    return (static_cast<unsigned long long>(x) & mask) |
+           ((static_cast<unsigned long long>(y) & mask) << 21) |
+           ((static_cast<unsigned long long>(z) & mask) << 42);
+}
+
+void SpatialGrid::InsertInCells(size_t entityID, const Entry& entry)
+{
+    for (int x = entry.minCell[0]; x <= entry.maxCell[0]; x++)
+        for (int y = entry.minCell[1]; y <= entry.maxCell[1]; y++)
+            for (int z = entry.minCell[2]; z <= entry.maxCell[2]; z++)
+                cells_[CellKey(x, y, z)].push_back(entityID);
+}
+
+void SpatialGrid::RemoveFromCells(size_t entityID, const Entry& entry)
+{
+    for (int x = entry.minCell[0]; x <= entry.maxCell[0]; x++)
+    {
+        for (int y = entry.minCell[1]; y <= entry.maxCell[1]; y++)
+        {
+            for (int z = entry.minCell[2]; z <= entry.maxCell[2]; z++)
+            {
+                auto cell = cells_.find(CellKey(x, y, z));
+                if (cell == cells_.end())
+                    continue;
+                SwapRemove(cell->second, entityID);
+                if (cell->second.empty())
+                    cells_.erase(cell);
+            }
+        }
+    }
+}
+
+void SpatialGrid::Update(size_t entityID, const gsl::Vector3D& min, const gsl::Vector3D& max)
+{
+    if (entityID >= entries_.size())
+    {
+        entries_.resize(entityID + 1);
+        lastQuery_.resize(entityID + 1, 0);
+    }
+
+    Entry newEntry;
+    newEntry.inGrid = true;
+    newEntry.min = min;
+    newEntry.max = max;
+    newEntry.minCell[0] = CellCoordinate(min.x);
+    newEntry.minCell[1] = CellCoordinate(min.y);
+    newEntry.minCell[2] = CellCoordinate(min.z);
+    newEntry.maxCell[0] = CellCoordinate(max.x);
+    newEntry.maxCell[1] = CellCoordinate(max.y);
+    newEntry.maxCell[2] = CellCoordinate(max.z);
+    long long cellCount = 1;
+    for (int axis = 0; axis < 3; axis++)
+        cellCount *= static_cast<long long>(newEntry.maxCell[axis]) - newEntry.minCell[axis] + 1;
+    newEntry.oversized = cellCount > MAX_CELLS_PER_ENTITY;
+
+    Entry& entry = entries_[entityID];
+    bool sameCells = entry.inGrid && entry.oversized == newEntry.oversized &&
+            std::equal(entry.minCell, entry.minCell + 3, newEntry.minCell) &&
+            std::equal(entry.maxCell, entry.maxCell + 3, newEntry.maxCell);
+    if (!sameCells)
+    {
+        Remove(entityID);
+        if (newEntry.oversized)
+            oversized_.push_back(entityID);
+        else
+            InsertInCells(entityID, newEntry);
+    }
+    entry = newEntry;
+}
+
+void SpatialGrid::Remove(size_t entityID)
+{
+    if (entityID >= entries_.size() || !entries_[entityID].inGrid)
+        return;
+
+    Entry& entry = entries_[entityID];
+    if (entry.oversized)
+        SwapRemove(oversized_, entityID);
+    else
+        RemoveFromCells(entityID, entry);
+    entry.inGrid = false;
+}
+
+void SpatialGrid::Clear()
+{
+    cells_.clear();
+    entries_.clear();
+    oversized_.clear();
+    lastQuery_.clear();
+}
+
+void SpatialGrid::Query(const gsl::Vector3D& min, const gsl::Vector3D& max, std::vector<size_t>& result) const
+{
+    result.clear();
+    if (++queryNumber_ == 0)
+    {
+        // wrapped around, old numbers could be mistaken for this query
+        std::fill(lastQuery_.begin(), lastQuery_.end(), 0);
+        queryNumber_ = 1;
+    }
+
+    auto consider = [&](size_t entityID)
+    {
+        if (lastQuery_[entityID] == queryNumber_)
+            return;
+        lastQuery_[entityID] = queryNumber_;
+        const Entry& entry = entries_[entityID];
+        if (BoxesOverlap(min, max, entry.min, entry.max))
+            result.push_back(entityID);
+    };
+
+    for (size_t entityID : oversized_)
+        consider(entityID);
+
+    int minCell[3] = {CellCoordinate(min.x), CellCoordinate(min.y), CellCoordinate(min.z)};
+    int maxCell[3] = {CellCoordinate(max.x), CellCoordinate(max.y), CellCoordinate(max.z)};
+    long long cellCount = 1;
+    for (int axis = 0; axis < 3; axis++)
+        cellCount *= static_cast<long long>(maxCell[axis]) - minCell[axis] + 1;
+
+    // a query box larger than the occupied cells is cheaper to answer by checking every entity
+    if (cellCount > static_cast<long long>(cells_.size()))
+    {
+        for (size_t entityID = 0; entityID < entries_.size(); entityID++)
+        {
+            if (entries_[entityID].inGrid)
+                consider(entityID);
+        }
+        return;
+    }
+
+    for (int x = minCell[0]; x <= maxCell[0]; x++)
+    {
+        for (int y = minCell[1]; y <= maxCell[1]; y++)
+        {
+            for (int z = minCell[2]; z <= maxCell[2]; z++)
+            {
+                auto cell = cells_.find(CellKey(x, y, z));
+                if (cell == cells_.end())
+                    continue;
+                for (size_t entityID : cell->second)
+                    consider(entityID);
+            }
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef SPATIALGRID_H
+#define SPATIALGRID_H
+
+#include <unordered_map>
+#include <vector>
+#include "GSL/vector3d.h"
+
+/**
+ * Uniform grid over world space axis aligned bounding boxes, used as broad phase for collision checks.
+ * Each entity is listed in every cell its box touches, so a query only looks at the entities near it
+ * instead of every entity in the scene. Entries are only moved when an entity's box moves to other cells.
+ * Boxes touching more than MAX_CELLS_PER_ENTITY cells are kept in one list that every query checks,
+ * so a few large objects don't fill thousands of cells.
+ */
+class SpatialGrid
+{
+public:
+    /**
+     * SpatialGrid Constructor.
+     * @param cellSize Width of the cubic cells, should be somewhat larger than the typical moving entity.
+     */
+    SpatialGrid(float cellSize = 5.f);
+
+    /**
+     * Adds an entity or moves it to its new box.
+     * @param entityID ID of entity.
+     * @param min Lowest corner of the entity's world space box.
+     * @param max Highest corner of the entity's world space box.
+     */
+    void Update(size_t entityID, const gsl::Vector3D& min, const gsl::Vector3D& max);
+    /// Removes an entity from the grid, does nothing if it is not in it.
+    void Remove(size_t entityID);
+    /// Removes all entities.
+    void Clear();
+    /**
+     * Finds the entities whose boxes overlap a box.
+     * @param min Lowest corner of the box to search.
+     * @param max Highest corner of the box to search.
+     * @param result Cleared, then filled with the entityIDs found, each listed once.
+     */
+    void Query(const gsl::Vector3D& min, const gsl::Vector3D& max, std::vector<size_t>& result) const;
+
+private:
+    /// Boxes touching more cells than this are not put in the cells.
+    static constexpr int MAX_CELLS_PER_ENTITY = 64;
+
+    /// Where an entity is stored, indexed by entityID.
+    struct Entry
+    {
+        bool inGrid{false};
+        bool oversized{false};
+        gsl::Vector3D min;
+        gsl::Vector3D max;
+        /// Cell coordinates of min and max, the entity is listed in all cells between them.
+        int minCell[3]{0, 0, 0};
+        int maxCell[3]{0, 0, 0};
+    };
+
+    /// Cell coordinate of a world position along one axis.
+    int CellCoordinate(float value) const;
+    /// Packs cell coordinates into one key, 21 bits per axis.
+    static unsigned long long CellKey(int x, int y, int z);
+    /// Adds or removes the entity from every cell in its range.
+    void InsertInCells(size_t entityID, const Entry& entry);
+    void RemoveFromCells(size_t entityID, const Entry& entry);
+
+    float cellSize_;
+    std::unordered_map<unsigned long long, std::vector<size_t>> cells_;
+    std::vector<Entry> entries_;
+    /// Entities too large to put in the cells.
+    std::vector<size_t> oversized_;
+
+    /// Query number each entity was last found in, so entities touching several cells are listed once.
+    mutable std::vector<unsigned int> lastQuery_;
+    mutable unsigned int queryNumber_{0};
+};
+
+#endif // SPATIALGRID_H
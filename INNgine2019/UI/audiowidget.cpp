@@ -51,7 +51,7 @@ void AudioWidget::InitializeWidget()
 
 }
 
-void AudioWidget::UpdateAudioWidget(std::shared_ptr<AudioComponent> audio)
+void AudioWidget::UpdateAudioWidget(AudioComponent* audio)
 {
     UpdateSoundBox(audio);
 
@@ -60,7 +60,7 @@ void AudioWidget::UpdateAudioWidget(std::shared_ptr<AudioComponent> audio)
     maxDistance_->SetSpinBoxValue(0,audio->maxDistance_);
 }
 
-void AudioWidget::UpdateAudioComponent(std::shared_ptr<AudioComponent> audio, std::shared_ptr<AudioSystem> audioSystem)
+void AudioWidget::UpdateAudioComponent(AudioComponent* audio, std::shared_ptr<AudioSystem> audioSystem)
 {
     if(sound_->GetBoxIndexValue(0) != audio->soundID_)
         AssetManager::GetInstance()->audioManager_->SetSound(sound_->GetCurrentBoxText(0),audio);
@@ -72,7 +72,7 @@ void AudioWidget::UpdateAudioComponent(std::shared_ptr<AudioComponent> audio, st
         audioSystem->SetSourceMaxDistance(audio,maxDistance_->GetSpinBoxValue(0));
 }
 
-void AudioWidget::UpdateSoundBox(std::shared_ptr<AudioComponent> audio)
+void AudioWidget::UpdateSoundBox(AudioComponent* audio)
 {
     sound_->ClearAllBoxes();
 
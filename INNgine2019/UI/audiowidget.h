@@ -39,18 +39,18 @@ public:
      * @param audio the Active Entity's AudioComponent.
      * @param audioSystem the Audio System.
      */
-    void UpdateAudioWidget(std::shared_ptr<AudioComponent> audio);
+    void UpdateAudioWidget(AudioComponent* audio);
     /**
      * Updates the values from the Widget to the AudioComponent.
      * @param audio the Active Entity's AudioComponent.
      * @param audioSystem the Audio System.
      */
-    void UpdateAudioComponent(std::shared_ptr<AudioComponent> audio, std::shared_ptr<AudioSystem> audioSystem);
+    void UpdateAudioComponent(AudioComponent* audio, std::shared_ptr<AudioSystem> audioSystem);
     /**
      * Updates all sounds loaded into the system and creates a menu item in the sounds_ ComboBoxProperty.
      * @param audioSystem the Audio System.
      */
-    void UpdateSoundBox(std::shared_ptr<AudioComponent> audio);
+    void UpdateSoundBox(AudioComponent* audio);
 
 
 public slots:
@@ -50,7 +50,7 @@ void LandscapeEditor::event_setMesh_clicked()
 {
     QString filepath = QFileDialog::getOpenFileName(this,
                                                     tr("Load Landscape"), gsl::textureFilePath,
-                                                    tr("OBJ (*.obj)"));
+                                                    tr("Landscape (*.obj *.png *.tif *.tiff *.pgm)"));
     if(filepath != "")
     {
         AssetManager::GetInstance()->updateLandscape(filepath);
@@ -46,7 +46,7 @@ void LightWidget::InitializeWidget()
     this->setLayout(masterLayout);
 }
 
-void LightWidget::UpdateLightWidget(std::shared_ptr<LightComponent> light)
+void LightWidget::UpdateLightWidget(LightComponent* light)
 {
     SetSpinBoxValuesFromVector3D(ambient_,light->ambient_);
     SetSpinBoxValuesFromVector3D(diffuse_,light->diffuse_);
@@ -64,7 +64,7 @@ void LightWidget::UpdateLightWidget(std::shared_ptr<LightComponent> light)
     outerCutOff_->SetSpinBoxValue(0,light->outerCutOff_);
 }
 
-void LightWidget::UpdateLightComponent(std::shared_ptr<LightComponent> light)
+void LightWidget::UpdateLightComponent(LightComponent* light)
 {
     light->ambient_ = SpinBoxToVector3D(ambient_);
     light->diffuse_ = SpinBoxToVector3D(diffuse_);
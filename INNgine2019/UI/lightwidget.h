@@ -18,12 +18,12 @@ public:
      * Updates the values from the LightComponent to the Widget.
      * @param light the Active Entity's LightComponent.
      */
-    void UpdateLightWidget(std::shared_ptr<LightComponent> light);
+    void UpdateLightWidget(LightComponent* light);
     /**
      * Updates the values from the Widget to the LightComponent.
      * @param light the Active Entity's LightComponent.
      */
-    void UpdateLightComponent(std::shared_ptr<LightComponent> light);
+    void UpdateLightComponent(LightComponent* light);
 
     /**
      * Sets the ComboBox to its correct light type position.
@@ -58,7 +58,7 @@ void MeshWidget::InitializeWidget()
     this->setLayout(finalLayout);
 }
 
-void MeshWidget::UpdateMeshWidget(std::shared_ptr<MeshComponent> mesh)
+void MeshWidget::UpdateMeshWidget(MeshComponent* mesh)
 {
     UpdateComboBoxValues(mesh);
     collisionEnabled_->setChecked(mesh->enableCollision_);
@@ -66,7 +66,7 @@ void MeshWidget::UpdateMeshWidget(std::shared_ptr<MeshComponent> mesh)
     selectObjectType->SetBoxCurrentIndex(0,mesh->objectType_);
 }
 
-void MeshWidget::UpdateMeshComponent(std::shared_ptr<MeshComponent> mesh)
+void MeshWidget::UpdateMeshComponent(MeshComponent* mesh)
 {
     mesh->meshID_ = selectMesh_->GetBoxIndexValue(0);
     mesh->materialID_ = selectMaterial_->GetBoxIndexValue(0);
@@ -75,7 +75,7 @@ void MeshWidget::UpdateMeshComponent(std::shared_ptr<MeshComponent> mesh)
     SetGLTypeInComponent(mesh);
 }
 
-void MeshWidget::UpdateComboBoxValues(std::shared_ptr<MeshComponent> mesh)
+void MeshWidget::UpdateComboBoxValues(MeshComponent* mesh)
 {
     selectMaterial_->ClearAllBoxes();
     unsigned int activeID = 0;
@@ -110,7 +110,7 @@ void MeshWidget::CreateGLSelection()
     selectGLDraw_->AddBoxValue(0,"GL_POLYGON");       // 9
 }
 
-void MeshWidget::SetGLTypeInComponent(std::shared_ptr<MeshComponent> mesh)
+void MeshWidget::SetGLTypeInComponent(MeshComponent* mesh)
 {
     GLenum x = GL_TRIANGLES;
     switch(selectGLDraw_->GetBoxIndexValue(0))
@@ -149,7 +149,7 @@ void MeshWidget::SetGLTypeInComponent(std::shared_ptr<MeshComponent> mesh)
     mesh->mode_ = x;
 }
 
-void MeshWidget::SetGLTypeInWidget(std::shared_ptr<MeshComponent> mesh)
+void MeshWidget::SetGLTypeInWidget(MeshComponent* mesh)
 {
 
 
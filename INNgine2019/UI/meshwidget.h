@@ -25,17 +25,17 @@ public:
      * @param materialManager The MaterialManager.
      * @param meshManager The MeshManager.
      */
-    void UpdateMeshWidget(std::shared_ptr<MeshComponent> mesh);
+    void UpdateMeshWidget(MeshComponent* mesh);
     /**
      * Updates the values from the Widget to the MeshComponent.
      * @param mesh the Active Entity's MeshComponent.
      */
-    void UpdateMeshComponent(std::shared_ptr<MeshComponent> mesh);
+    void UpdateMeshComponent(MeshComponent* mesh);
     /**
      * Updates the selectMesh and sleectMaterial ComboBoxProperties to add or remove any meshes that has been added/deleted in runtime.
      * @param mesh the Active Entity's MeshComponent.
      */
-    void UpdateComboBoxValues(std::shared_ptr<MeshComponent> mesh);
+    void UpdateComboBoxValues(MeshComponent* mesh);
     /**
      *Creates the GL Selection that the selectGLDRaw ComboBoxProperty uses. Only needs to be run once.
      */
@@ -44,12 +44,12 @@ public:
      * Sets the GL type from the Widget to the MeshComponent.
      * @param mesh the Active Entity's MeshComponent.
      */
-    void SetGLTypeInComponent(std::shared_ptr<MeshComponent> mesh);
+    void SetGLTypeInComponent(MeshComponent* mesh);
     /**
      * Sets the GL type from the MeshComponent to the Widget.
      * @param mesh the Active Entity's MeshComponent.
      */
-    void SetGLTypeInWidget(std::shared_ptr<MeshComponent> mesh);
+    void SetGLTypeInWidget(MeshComponent* mesh);
 
     ///ComboBoxProperty containing all meshes loaded into the game.
     ComboBoxProperty* selectMesh_{nullptr};
@@ -57,7 +57,7 @@ void TransformWidget::InitializeWidget()
     this->setLayout(finalLayout);
 }
 
-void TransformWidget::UpdateTransformWidget(std::shared_ptr<TransformComponent> transform)
+void TransformWidget::UpdateTransformWidget(TransformComponent* transform)
 {
     SetSpinBoxValuesFromVector3D(positionSpinBoxes_,transform->position_relative_);
     SetSpinBoxValuesFromVector3D(rotationSpinBoxes_,transform->rotation_relative_);
@@ -66,11 +66,12 @@ void TransformWidget::UpdateTransformWidget(std::shared_ptr<TransformComponent>
     orientRotationBasedOnMovement_->setChecked(transform->orientRotationBasedOnMovement_);
 }
 
-void TransformWidget::UpdateTransformComponent(std::shared_ptr<TransformComponent> transform)
+void TransformWidget::UpdateTransformComponent(TransformComponent* transform)
 {
     transform->position_relative_ = SpinBoxToVector3D(positionSpinBoxes_);
     transform->rotation_relative_ = SpinBoxToVector3D(rotationSpinBoxes_);
     transform->scale_relative_ = SpinBoxToVector3D(scaleSpinBoxes_);
     transform->followLandscape_ = followLandscape_->isChecked();
     transform->orientRotationBasedOnMovement_ = orientRotationBasedOnMovement_->isChecked();
+    transform->hasChanged_ = true;
 }
@@ -29,12 +29,12 @@ public:
      * Updates the values from the TransformComponent to the Widget.
      * @param transform the Active Entity's TransformComponent.
      */
-    void UpdateTransformWidget(std::shared_ptr<TransformComponent> transform);
+    void UpdateTransformWidget(TransformComponent* transform);
     /**
      * Updates the values from the Widget to the TransformComponent.
      * @param transform the Active Entity's TransformComponent.
      */
-    void UpdateTransformComponent(std::shared_ptr<TransformComponent> transform);
+    void UpdateTransformComponent(TransformComponent* transform);
 };
 
 #endif // TRANSFORMWIDGET_H
@@ -0,0 +1,31 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+/**
+ * Runs the work several times and prints the fastest run, slower runs are mostly other processes getting in the way.
+ * @param name Printed in front of the time.
+ * @param operations How many operations one call to work does, the time is printed per operation.
+ * @param work The code to time.
+ * @param runs How many times work is called.
+ * @return Fastest time per operation, in nanoseconds.
+ */
+template<typename Work>
+double TimeBest(const char* name, size_t operations, Work work, int runs = 15)
+{
+    double best = 1e30;
+    for (int run = 0; run < runs; run++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        work();
+        std::chrono::duration<double, std::nano> time = std::chrono::steady_clock::now() - start;
+        best = std::min(best, time.count() / static_cast<double>(operations));
+    }
+    std::printf("%-24s %10.2f ns/op\n", name, best);
+    return best;
+}
+
+#endif // BENCHMARK_H
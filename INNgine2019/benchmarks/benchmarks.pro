@@ -0,0 +1,6 @@
+TEMPLATE    = subdirs
+
+SUBDIRS += \
+    matrix4x4 \
+    obboverlap \
+    objreader \
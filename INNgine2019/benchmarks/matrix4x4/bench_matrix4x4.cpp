@@ -0,0 +1,155 @@
+#include "benchmarks/benchmark.h"
+#include "GSL/gsl_simd.h"
+#include "GSL/matrix4x4.h"
+#include "GSL/vector4d.h"
+
+#include <random>
+#include <vector>
+
+namespace
+{
+/// Number of matrices, small enough that they all stay in the cache.
+constexpr size_t MATRIX_COUNT{4096};
+/// How many times the matrices are gone through per timed run.
+constexpr size_t ROUNDS{100};
+
+/// Written to so the timed loops can't be optimized away.
+volatile float sink{0.f};
+
+bool NearlyEqual(float a, float b)
+{
+    return std::abs(a - b) <= 1e-4f * std::max(1.f, std::max(std::abs(a), std::abs(b)));
+}
+
+/// Compares the operators with the textbook loops, returns false on the first mismatch.
+bool CheckResults(const std::vector<gsl::Matrix4x4>& a, const std::vector<gsl::Matrix4x4>& b, const std::vector<gsl::Vector4D>& v)
+{
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        const GLfloat* left = a[i].constData();
+        const GLfloat* right = b[i].constData();
+
+        gsl::Matrix4x4 product = a[i] * b[i];
+        for (int row = 0; row < 4; row++)
+        {
+            for (int column = 0; column < 4; column++)
+            {
+                float expected{0.f};
+                for (int k = 0; k < 4; k++)
+                    expected += left[row * 4 + k] * right[k * 4 + column];
+                if (!NearlyEqual(product.constData()[row * 4 + column], expected))
+                {
+                    std::printf("matrix*matrix differs at %zu (%d, %d)\n", i, row, column);
+                    return false;
+                }
+            }
+        }
+
+        gsl::Vector4D transformed = a[i] * v[i];
+        const float vector[4]{v[i].getX(), v[i].getY(), v[i].getZ(), v[i].getW()};
+        const float result[4]{transformed.getX(), transformed.getY(), transformed.getZ(), transformed.getW()};
+        for (int row = 0; row < 4; row++)
+        {
+            float expected{0.f};
+            for (int k = 0; k < 4; k++)
+                expected += left[row * 4 + k] * vector[k];
+            if (!NearlyEqual(result[row], expected))
+            {
+                std::printf("matrix*vector differs at %zu (%d)\n", i, row);
+                return false;
+            }
+        }
+
+        gsl::Matrix4x4 inverse = a[i];
+        inverse.inverse();
+        gsl::Matrix4x4 identity = a[i] * inverse;
+        for (int element = 0; element < 16; element++)
+        {
+            float expected = element % 5 == 0 ? 1.f : 0.f;
+            if (!NearlyEqual(identity.constData()[element], expected))
+            {
+                std::printf("inverse is off at %zu (%d)\n", i, element);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+}
+
+/// Times the Matrix4x4 operations used per entity each frame, after checking them against plain loops.
+/// Build once more with CONFIG+=no_simd to get the scalar numbers to compare with.
+int main()
+{
+#ifdef GSL_USE_SSE
+    std::printf("Matrix4x4 with SSE\n");
+#else
+    std::printf("Matrix4x4 scalar\n");
+#endif
+
+    // random values on top of a large diagonal, so every matrix is well conditioned and the inverse check is fair
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> value(-2.f, 2.f);
+    std::vector<gsl::Matrix4x4> a(MATRIX_COUNT), b(MATRIX_COUNT), out(MATRIX_COUNT);
+    std::vector<gsl::Vector4D> v(MATRIX_COUNT), vOut(MATRIX_COUNT);
+    for (size_t i = 0; i < MATRIX_COUNT; i++)
+    {
+        for (int element = 0; element < 16; element++)
+        {
+            float diagonal = element % 5 == 0 ? 8.f : 0.f;
+            a[i].constData()[element] = value(random) + diagonal;
+            b[i].constData()[element] = value(random) + diagonal;
+        }
+        v[i] = gsl::Vector4D(value(random), value(random), value(random), 1.f);
+    }
+
+    if (!CheckResults(a, b, v))
+        return 1;
+
+    const size_t operations = MATRIX_COUNT * ROUNDS;
+    TimeBest("matrix*matrix", operations, [&]
+    {
+        for (size_t round = 0; round < ROUNDS; round++)
+            for (size_t i = 0; i < MATRIX_COUNT; i++)
+                out[i] = a[i] * b[i];
+        sink = sink + out.back().constData()[5];
+    });
+    TimeBest("matrix*vector", operations, [&]
+    {
+        for (size_t round = 0; round < ROUNDS; round++)
+            for (size_t i = 0; i < MATRIX_COUNT; i++)
+                vOut[i] = a[i] * v[i];
+        sink = sink + vOut.back().getX();
+    });
+    TimeBest("inverse", operations, [&]
+    {
+        for (size_t round = 0; round < ROUNDS; round++)
+        {
+            for (size_t i = 0; i < MATRIX_COUNT; i++)
+            {
+                out[i] = a[i];
+                out[i].inverse();
+            }
+        }
+        sink = sink + out.back().constData()[5];
+    });
+    // the model matrix of a transform, like MovementSystem builds it
+    TimeBest("translate*rotate*scale", operations, [&]
+    {
+        for (size_t round = 0; round < ROUNDS; round++)
+        {
+            for (size_t i = 0; i < MATRIX_COUNT; i++)
+            {
+                gsl::Matrix4x4 model(true);
+                model.translate(v[i].getX(), v[i].getY(), v[i].getZ());
+                gsl::Matrix4x4 rotation;
+                rotation.rotQuat(0.1f, 0.2f, 0.3f, 0.927f);
+                model = model * rotation;
+                model.scale(1.f, 2.f, 3.f);
+                out[i] = model;
+            }
+        }
+        sink = sink + out.back().constData()[3];
+    });
+    return 0;
+}
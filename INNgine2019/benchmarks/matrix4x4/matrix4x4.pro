@@ -0,0 +1,13 @@
+include(../../engine.pri)
+
+CONFIG      += console
+CONFIG      -= app_bundle
+
+# qmake CONFIG+=no_simd builds the scalar fallback, to compare against the SSE paths
+no_simd: DEFINES += GSL_NO_SIMD
+
+TEMPLATE    = app
+TARGET      = bench_matrix4x4
+
+HEADERS += ../benchmark.h
+SOURCES += bench_matrix4x4.cpp
@@ -0,0 +1,181 @@
+#include "benchmarks/benchmark.h"
+#include "GSL/gsl_math.h"
+#include "GSL/matrix4x4.h"
+
+#include <array>
+#include <random>
+#include <vector>
+
+namespace
+{
+typedef std::array<gsl::Vector3D, 8> Box;
+
+/// Number of boxes, paired up as 0-1, 2-3 and so on for the checks, and 0-1, 1-2 and so on for the timing.
+constexpr size_t BOX_COUNT{20000};
+
+/// The unit cube's corners in the order of BoundingBox::points_.
+const gsl::Vector3D UNIT_CORNERS[8]{{1, 1, 1}, {1, 1, -1}, {-1, 1, 1}, {-1, 1, -1},
+                                    {1, -1, 1}, {1, -1, -1}, {-1, -1, 1}, {-1, -1, -1}};
+
+/// Written to so the timed loops can't be optimized away.
+volatile int sink{0};
+
+bool Overlaps(std::pair<float, float> a, std::pair<float, float> b)
+{
+    return (a.first <= b.first && b.first <= a.second) || (b.first <= a.first && a.first <= b.second);
+}
+
+/**
+ * The collision test MovementSystem::isColliding used before obbOverlap.
+ * Projects both boxes on the world y axis and on the x and z axis of each box' own edges.
+ * Exact for boxes that are not rotated, an approximation for rotated ones.
+ */
+bool ProjectionOverlap(const Box& a, const Box& b)
+{
+    std::vector<gsl::Vector3D> mainPoints(a.begin(), a.end());
+    float x = mainPoints[1].x - mainPoints[2].x;
+    float z = mainPoints[0].z - mainPoints[1].z;
+    std::pair<float, float> mainMinMaxX = gsl::findMinAndMaxInX(gsl::ProjectPointsOnVector(mainPoints, gsl::Vector3D(x, 0, 0).normalized()));
+    std::pair<float, float> mainMinMaxY = gsl::findMinAndMaxInY(gsl::ProjectPointsOnVector(mainPoints, gsl::Vector3D(0, 1, 0)));
+    std::pair<float, float> mainMinMaxZ = gsl::findMinAndMaxInZ(gsl::ProjectPointsOnVector(mainPoints, gsl::Vector3D(0, 0, z).normalized()));
+
+    std::vector<gsl::Vector3D> otherPoints(b.begin(), b.end());
+    x = otherPoints[1].x - otherPoints[2].x;
+    z = otherPoints[0].z - otherPoints[1].z;
+    std::pair<float, float> otherMinMaxX = gsl::findMinAndMaxInX(gsl::ProjectPointsOnVector(otherPoints, gsl::Vector3D(x, 0, 0).normalized()));
+    std::pair<float, float> otherMinMaxY = gsl::findMinAndMaxInY(gsl::ProjectPointsOnVector(otherPoints, gsl::Vector3D(0, 1, 0)));
+    std::pair<float, float> otherMinMaxZ = gsl::findMinAndMaxInZ(gsl::ProjectPointsOnVector(otherPoints, gsl::Vector3D(0, 0, z).normalized()));
+
+    return Overlaps(mainMinMaxX, otherMinMaxX) && Overlaps(mainMinMaxY, otherMinMaxY) && Overlaps(mainMinMaxZ, otherMinMaxZ);
+}
+
+/// Whether the world space axis aligned boxes around the two boxes overlap, which they must if the boxes do.
+bool AxisAlignedOverlap(const Box& a, const Box& b)
+{
+    for (float gsl::Vector3D::* axis : {&gsl::Vector3D::x, &gsl::Vector3D::y, &gsl::Vector3D::z})
+    {
+        std::pair<float, float> rangeA{a[0].*axis, a[0].*axis};
+        std::pair<float, float> rangeB{b[0].*axis, b[0].*axis};
+        for (size_t corner = 1; corner < 8; corner++)
+        {
+            rangeA = {std::min(rangeA.first, a[corner].*axis), std::max(rangeA.second, a[corner].*axis)};
+            rangeB = {std::min(rangeB.first, b[corner].*axis), std::max(rangeB.second, b[corner].*axis)};
+        }
+        if (!Overlaps(rangeA, rangeB))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Looks for a point inside both boxes on a grid through a's volume.
+ * @param a Corners of the box to sample.
+ * @param toLocalB Takes a world point into b's unit cube.
+ * @return Whether a sample was found well inside b.
+ */
+bool SampleInside(const Box& a, gsl::Matrix4x4& toLocalB)
+{
+    const int steps = 4;
+    gsl::Vector3D edgeX = a[0] - a[2];
+    gsl::Vector3D edgeY = a[0] - a[4];
+    gsl::Vector3D edgeZ = a[0] - a[1];
+    for (int i = 0; i <= steps; i++)
+    {
+        for (int j = 0; j <= steps; j++)
+        {
+            for (int k = 0; k <= steps; k++)
+            {
+                gsl::Vector3D sample = a[7] + edgeX * (static_cast<float>(i) / steps) + edgeY * (static_cast<float>(j) / steps) + edgeZ * (static_cast<float>(k) / steps);
+                gsl::Vector3D local = (toLocalB * gsl::Vector4D(sample, 1.f)).toVector3D();
+                if (std::abs(local.x) < 0.999f && std::abs(local.y) < 0.999f && std::abs(local.z) < 0.999f)
+                    return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * Makes a box from the unit cube.
+ * @param rotate Whether the box is rotated, if not its edges follow the world axes.
+ * @param inverse Set to the matrix taking world points into the box' unit cube.
+ */
+Box MakeBox(std::mt19937& random, bool rotate, gsl::Matrix4x4& inverse)
+{
+    std::uniform_real_distribution<float> position(-3.f, 3.f);
+    std::uniform_real_distribution<float> angle(0.f, 360.f);
+    std::uniform_real_distribution<float> size(0.3f, 2.f);
+
+    gsl::Matrix4x4 model(true);
+    model.translate(position(random), position(random) * 0.2f, position(random));
+    if (rotate)
+    {
+        model.rotateY(angle(random));
+        model.rotateX(angle(random) * 0.1f);
+    }
+    model.scale(size(random), size(random), size(random));
+    inverse = model;
+    inverse.inverse();
+
+    Box box;
+    for (size_t corner = 0; corner < 8; corner++)
+        box[corner] = (model * gsl::Vector4D(UNIT_CORNERS[corner], 1.f)).toVector3D();
+    return box;
+}
+}
+
+/// Checks gsl::obbOverlap on random pairs of boxes, then times it against the projection test it replaced.
+/// Returns 1 if obbOverlap disagrees with the projection test on boxes that are not rotated, or misses an overlap.
+int main()
+{
+    std::mt19937 random(5);
+    std::vector<Box> boxes(BOX_COUNT);
+    std::vector<gsl::Matrix4x4> inverses(BOX_COUNT);
+
+    // boxes that are not rotated, where the old projection test is exact and the two must agree
+    size_t mismatches{0};
+    for (size_t i = 0; i + 1 < BOX_COUNT; i += 2)
+    {
+        boxes[i] = MakeBox(random, false, inverses[i]);
+        boxes[i + 1] = MakeBox(random, false, inverses[i + 1]);
+        if (gsl::obbOverlap(boxes[i], boxes[i + 1]) != ProjectionOverlap(boxes[i], boxes[i + 1]))
+            mismatches++;
+    }
+    std::printf("axis aligned pairs: %zu, differing from the projection test: %zu\n", BOX_COUNT / 2, mismatches);
+
+    // rotated boxes, obbOverlap must never call two boxes apart when a point is inside both,
+    // and never call them overlapping when not even the axis aligned boxes around them do
+    size_t overlaps{0}, projectionOverlaps{0}, missed{0}, outsideAxisAligned{0};
+    for (size_t i = 0; i < BOX_COUNT; i++)
+        boxes[i] = MakeBox(random, true, inverses[i]);
+    for (size_t i = 0; i + 1 < BOX_COUNT; i += 2)
+    {
+        bool overlap = gsl::obbOverlap(boxes[i], boxes[i + 1]);
+        overlaps += overlap;
+        projectionOverlaps += ProjectionOverlap(boxes[i], boxes[i + 1]);
+        if (!overlap && SampleInside(boxes[i], inverses[i + 1]))
+            missed++;
+        if (overlap && !AxisAlignedOverlap(boxes[i], boxes[i + 1]))
+            outsideAxisAligned++;
+    }
+    std::printf("rotated pairs: %zu, overlapping: %zu, overlapping by the projection test: %zu\n", BOX_COUNT / 2, overlaps, projectionOverlaps);
+    std::printf("missed overlaps: %zu, overlaps outside the axis aligned boxes: %zu\n", missed, outsideAxisAligned);
+
+    const size_t pairs = BOX_COUNT - 1;
+    TimeBest("projection test", pairs, [&]
+    {
+        int count{0};
+        for (size_t i = 0; i < pairs; i++)
+            count += ProjectionOverlap(boxes[i], boxes[i + 1]);
+        sink = sink + count;
+    }, 7);
+    TimeBest("gsl::obbOverlap", pairs, [&]
+    {
+        int count{0};
+        for (size_t i = 0; i < pairs; i++)
+            count += gsl::obbOverlap(boxes[i], boxes[i + 1]);
+        sink = sink + count;
+    }, 7);
+
+    return mismatches == 0 && missed == 0 && outsideAxisAligned == 0 ? 0 : 1;
+}
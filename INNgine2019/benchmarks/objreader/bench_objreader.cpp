@@ -0,0 +1,224 @@
+#include "benchmarks/benchmark.h"
+#include "Managers/meshmanager.h"
+
+#include <QDir>
+
+namespace
+{
+/// Written to so the timed loops can't be optimized away.
+volatile size_t sink{0};
+
+/// MeshManager::readOBJFile as it was before the hand written parser, kept as it was to compare with.
+/// Every triangle corner becomes its own vertex, and the numbers are read with std::stof and std::stoi.
+std::pair <std::vector<Vertex>,std::vector<GLuint>> OldReadOBJFile(std::string fileWithPath)
+{
+
+    QString fileName = QString::fromStdString(fileWithPath).section('/', -1);
+    if(!QFile::exists(gsl::meshFilePath + fileName))
+    {
+        qDebug() << "File copying from" << QString::fromStdString(fileWithPath) << "to" << (gsl::meshFilePath + fileName);
+        QFile::copy(QString::fromStdString(fileWithPath), gsl::meshFilePath + fileName);
+
+    }
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+
+    std::ifstream fileIn;
+    fileIn.open (fileWithPath, std::ifstream::in);
+    if(!fileIn)
+        qDebug() << "Could not open file for reading: " << QString::fromStdString(fileWithPath);
+
+    //One line at a time-variable
+    std::string oneLine;
+    //One word at a time-variable
+    std::string oneWord;
+
+    std::vector<gsl::Vector3D> tempVertecies;
+    std::vector<gsl::Vector3D> tempNormals;
+    std::vector<gsl::Vector2D> tempUVs;
+
+    // Varible for constructing the indices vector
+    unsigned int temp_index = 0;
+
+    //Reading one line at a time from file to oneLine
+    while(std::getline(fileIn, oneLine))
+    {
+        //Doing a trick to get one word at a time
+        std::stringstream sStream;
+        //Pushing line into stream
+        sStream << oneLine;
+        //Streaming one word out of line
+        oneWord = ""; //resetting the value or else the last value might survive!
+
+        sStream >> oneWord;
+
+        if (oneWord == "#")
+            continue;
+        if (oneWord == "")
+            continue;
+
+        if (oneWord == "v")
+        {
+            gsl::Vector3D tempVertex;
+            sStream >> oneWord;
+            tempVertex.x = std::stof(oneWord);
+            sStream >> oneWord;
+            tempVertex.y = std::stof(oneWord);
+            sStream >> oneWord;
+            tempVertex.z = std::stof(oneWord);
+
+            //Vertex made - pushing it into vertex-vector
+            tempVertecies.push_back(tempVertex);
+
+            continue;
+        }
+        if (oneWord == "vt")
+        {
+            //            qDebug() << "Line is UV-coordinate "  << QString::fromStdString(oneWord) << " ";
+            gsl::Vector2D tempUV;
+            sStream >> oneWord;
+            tempUV.x = std::stof(oneWord);
+            sStream >> oneWord;
+            tempUV.y = std::stof(oneWord);
+
+            //UV made - pushing it into UV-vector
+            tempUVs.push_back(tempUV);
+
+            continue;
+        }
+        if (oneWord == "vn")
+        {
+            gsl::Vector3D tempNormal;
+            sStream >> oneWord;
+            tempNormal.x = std::stof(oneWord);
+            sStream >> oneWord;
+            tempNormal.y = std::stof(oneWord);
+            sStream >> oneWord;
+            tempNormal.z = std::stof(oneWord);
+
+            //Vertex made - pushing it into vertex-vector
+            tempNormals.push_back(tempNormal);
+            continue;
+        }
+        if (oneWord == "f")
+        {
+            //int slash; //used to get the / from the v/t/n - format
+            int index, normal, uv;
+            for(size_t i = 0; i < 3; i++)
+            {
+                sStream >> oneWord;     //one word read
+                std::stringstream tempWord(oneWord);    //to use getline on this one word
+                std::string segment;    //the numbers in the f-line
+                std::vector<std::string> segmentArray;  //temp array of the numbers
+                while(std::getline(tempWord, segment, '/')) //splitting word in segments
+                {
+                    segmentArray.push_back(segment);
+                }
+                index = std::stoi(segmentArray[0]);     //first is vertex
+                if (segmentArray[1] != "")              //second is uv
+                    uv = std::stoi(segmentArray[1]);
+                else
+                {
+                    //qDebug() << "No uvs in mesh";       //uv not present
+                    uv = 0;                             //this will become -1 in a couple of lines
+                }
+                normal = std::stoi(segmentArray[2]);    //third is normal
+
+                //Fixing the indexes
+                //because obj f-lines starts with 1, not 0
+                --index;
+                --uv;
+                --normal;
+
+                if (uv > -1)    //uv present!
+                {
+                    Vertex tempVert(tempVertecies[static_cast<size_t>(index)], tempNormals[static_cast<size_t>(normal)], tempUVs[static_cast<size_t>(uv)]);
+                    vertices.push_back(tempVert);
+                }
+                else            //no uv in mesh data, use 0, 0 as uv
+                {
+                    Vertex tempVert(tempVertecies[static_cast<size_t>(index)], tempNormals[static_cast<size_t>(normal)], gsl::Vector2D(0.0f, 0.0f));
+                    vertices.push_back(tempVert);
+                }
+                indices.push_back(temp_index++);
+            }
+
+            //            continue;
+        }
+    }
+
+    //beeing a nice boy and closing the file after use
+    fileIn.close();
+    qDebug() << "Obj file read: " << QString::fromStdString(fileWithPath);
+
+    return std::make_pair(vertices, indices);
+
+}
+
+bool SameVertex(const Vertex& a, const Vertex& b)
+{
+    return a.XYZ_.x == b.XYZ_.x && a.XYZ_.y == b.XYZ_.y && a.XYZ_.z == b.XYZ_.z
+            && a.normal_.x == b.normal_.x && a.normal_.y == b.normal_.y && a.normal_.z == b.normal_.z
+            && a.ST_.x == b.ST_.x && a.ST_.y == b.ST_.y;
+}
+
+/**
+ * Compares the triangles of two meshes corner by corner.
+ * The new reader merges equal corners into one vertex, so the indices are followed rather than compared.
+ * @return Index of the first corner that differs, or gsl::INVALID_SIZE if the triangles are identical.
+ */
+size_t FirstDifferentCorner(const std::pair<std::vector<Vertex>, std::vector<GLuint>>& oldMesh,
+                            const std::pair<std::vector<Vertex>, std::vector<GLuint>>& newMesh)
+{
+    size_t corners = std::min(oldMesh.second.size(), newMesh.second.size());
+    for (size_t corner = 0; corner < corners; corner++)
+    {
+        if (!SameVertex(oldMesh.first[oldMesh.second[corner]], newMesh.first[newMesh.second[corner]]))
+            return corner;
+    }
+    return oldMesh.second.size() == newMesh.second.size() ? gsl::INVALID_SIZE : corners;
+}
+}
+
+/// Reads every .obj file in Assets/Meshes with the old and the new reader, and times both.
+/// Returns 1 if any file gives different triangles.
+int main()
+{
+    // the asset paths in constants.h go up a folder and back into the project folder, so they work from there
+    if (!QDir::setCurrent(ENGINE_SOURCE_DIR))
+    {
+        std::printf("Could not move to %s\n", ENGINE_SOURCE_DIR);
+        return 1;
+    }
+
+    QStringList files = QDir(gsl::meshFilePath).entryList({"*.obj"}, QDir::Files, QDir::Name);
+    if (files.isEmpty())
+    {
+        std::printf("No .obj files in %s\n", qPrintable(gsl::meshFilePath));
+        return 1;
+    }
+
+    bool allSame{true};
+    for (const QString& file : files)
+    {
+        std::string filePath = (gsl::meshFilePath + file).toStdString();
+        auto oldMesh = OldReadOBJFile(filePath);
+        auto newMesh = MeshManager::readOBJFile(filePath);
+
+        size_t difference = FirstDifferentCorner(oldMesh, newMesh);
+        if (difference != gsl::INVALID_SIZE)
+        {
+            std::printf("%s: triangle corner %zu differs\n", qPrintable(file), difference);
+            allSame = false;
+            continue;
+        }
+        std::printf("%s: %zu corners, %zu vertices before, %zu after, identical triangles\n", qPrintable(file),
+                    newMesh.second.size(), oldMesh.first.size(), newMesh.first.size());
+
+        // timed per triangle corner, so files of different sizes can be compared
+        const size_t corners = std::max<size_t>(newMesh.second.size(), 1);
+        TimeBest("  old reader", corners, [&]{ sink = sink + OldReadOBJFile(filePath).second.size(); }, 5);
+        TimeBest("  readOBJFile", corners, [&]{ sink = sink + MeshManager::readOBJFile(filePath).second.size(); }, 5);
+    }
+    return allSame ? 0 : 1;
+}
@@ -0,0 +1,10 @@
+include(../../engine.pri)
+
+CONFIG      += console
+CONFIG      -= app_bundle
+
+TEMPLATE    = app
+TARGET      = bench_objreader
+
+HEADERS += ../benchmark.h
+SOURCES += bench_objreader.cpp
@@ -0,0 +1,38 @@
+# Engine sources without the editor UI, shared by the projects in tests/ and benchmarks/.
+# Include it from a project directory: include(../../engine.pri)
+
+QT          += core gui widgets qml
+CONFIG      += c++17
+
+PRECOMPILED_HEADER = $$PWD/Legacy/innpch.h
+
+INCLUDEPATH +=  $$PWD
+INCLUDEPATH +=  $$PWD/GSL
+INCLUDEPATH +=  $$PWD/Legacy
+INCLUDEPATH +=  $$PWD/include
+
+mac {
+    LIBS += -framework OpenAL
+}
+
+win32 {
+    INCLUDEPATH += $(OPENAL_HOME)\\include\\AL
+    LIBS *= $(OPENAL_HOME)\\libs\\Win64\\libOpenAL32.dll.a
+}
+
+HEADERS += \
+    $$files($$PWD/GSL/*.h) \
+    $$files($$PWD/Legacy/*.h) \
+    $$files($$PWD/Managers/*.h) \
+    $$files($$PWD/Systems/*.h) \
+    $$PWD/script.h \
+
+SOURCES += \
+    $$files($$PWD/GSL/*.cpp) \
+    $$files($$PWD/Legacy/*.cpp) \
+    $$files($$PWD/Managers/*.cpp) \
+    $$files($$PWD/Systems/*.cpp) \
+    $$PWD/script.cpp \
+
+# the asset paths in constants.h are relative, tests and benchmarks move to this folder before loading anything
+DEFINES += ENGINE_SOURCE_DIR=\\\"$$PWD\\\"
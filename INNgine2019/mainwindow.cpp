@@ -53,6 +53,12 @@ void MainWindow::Init()
     EntitiesDrawn_ = new QLabel(this);
     EntitiesDrawn_->setAlignment(Qt::AlignCenter);
     EntitiesDrawn_->setSizePolicy(QSizePolicy::MinimumExpanding,QSizePolicy::Minimum);
+    stateChanges_ = new QLabel(this);
+    stateChanges_->setAlignment(Qt::AlignCenter);
+    stateChanges_->setSizePolicy(QSizePolicy::MinimumExpanding,QSizePolicy::Minimum);
+    drawCalls_ = new QLabel(this);
+    drawCalls_->setAlignment(Qt::AlignCenter);
+    drawCalls_->setSizePolicy(QSizePolicy::MinimumExpanding,QSizePolicy::Minimum);
     FPS_ = new QLabel(this);
     FPS_->setAlignment(Qt::AlignCenter);
     FPS_->setSizePolicy(QSizePolicy::MinimumExpanding,QSizePolicy::Minimum);
@@ -61,6 +67,8 @@ void MainWindow::Init()
     statusBar()->addWidget(FPS_);
     statusBar()->addWidget(EntitiesDrawn_);
     statusBar()->addWidget(verticesDrawn_);
+    statusBar()->addWidget(drawCalls_);
+    statusBar()->addWidget(stateChanges_);
 
     CreateToolBar();
     CreateDockWindows();
@@ -80,6 +88,8 @@ void MainWindow::UpdateStatusBar()
     FPS_->setText("FPS (approximated): " + QString::number(static_cast<int>(1000/AssetManager::GetInstance()->deltaTime_)));
     EntitiesDrawn_->setText("Entities Drawn: " + QString::number(static_cast<int>(renderWindow_->renderSystem_.entitiesDrawn_)));
     verticesDrawn_->setText("Vertices Drawn: " + QString::number(static_cast<int>(renderWindow_->renderSystem_.verticesDrawn_)));
+    drawCalls_->setText("Draw Calls: " + QString::number(static_cast<int>(renderWindow_->renderSystem_.drawCalls_)));
+    stateChanges_->setText("State Changes: " + QString::number(static_cast<int>(renderWindow_->renderSystem_.stateChanges_)));
 }
 
 void MainWindow::dragEnterEvent(QDragEnterEvent *event)
@@ -224,6 +234,48 @@ void MainWindow::event_entityTreeWidget_itemClicked(QTreeWidgetItem *item)
     LoadComponentsToList();
 }
 
+void MainWindow::event_entityTreeWidget_itemChanged(QTreeWidgetItem *item, int column)
+{
+    // name or checkbox edited in the tree, the EntityManager keeps the actual values
+    if (column != 0 || !renderWindow_ || !renderWindow_->sceneManager_)
+        return;
+
+    bool isEntityID;
+    size_t ID = item->text(1).toUInt(&isEntityID);
+    if (!isEntityID)
+        return;
+
+    renderWindow_->sceneManager_->entityManager_->SetEntityName(ID, item->text(0));
+    renderWindow_->sceneManager_->entityManager_->SetEntityWidgetItemChecked(ID, item->checkState(0) == Qt::Checked);
+}
+
+void MainWindow::event_entityTreeWidget_rowsInserted(const QModelIndex &parent, int first, int last)
+{
+    // entities dragged to a new parent in the tree, the EntityManager keeps the actual hierarchy
+    if (!renderWindow_ || !renderWindow_->sceneManager_)
+        return;
+
+    size_t parentID = gsl::INVALID_SIZE;
+    if (parent.isValid())
+    {
+        bool isEntityID;
+        parentID = parent.sibling(parent.row(), 1).data().toString().toUInt(&isEntityID);
+        if (!isEntityID)
+            return;
+    }
+
+    for (int row = first; row <= last; row++)
+    {
+        bool isEntityID;
+        size_t childID = entityTree_->model()->index(row, 1, parent).data().toString().toUInt(&isEntityID);
+        if (!isEntityID)
+            continue;
+        renderWindow_->sceneManager_->entityManager_->SetParent(childID, parentID);
+        if (TransformComponent* transform = renderWindow_->sceneManager_->componentManager_->transformComponents_.Get(childID))
+            transform->hasChanged_ = true;
+    }
+}
+
 void MainWindow::event_addEntityButton_clicked()
 {
     renderWindow_->sceneManager_->AddEntity(newEntityName_->text());
@@ -299,6 +351,8 @@ void MainWindow::CreateWorldOutlinerDock()
     headers.push_back("ID");
     entityTree_->setHeaderLabels(headers);
     connect(entityTree_, &QTreeWidget::itemClicked, this, &MainWindow::event_entityTreeWidget_itemClicked);
+    connect(entityTree_, &QTreeWidget::itemChanged, this, &MainWindow::event_entityTreeWidget_itemChanged);
+    connect(entityTree_->model(), &QAbstractItemModel::rowsInserted, this, &MainWindow::event_entityTreeWidget_rowsInserted);
     worldOutlinerLayout->addWidget(entityTree_);
 
     newEntityName_ = new QLineEdit();
@@ -543,8 +597,8 @@ void MainWindow::event_actionLoad_triggered()
     savePathLocation = QFileDialog::getOpenFileName(this,
                                                     tr("Load Scene"), gsl::scriptFilePath,
                                                     tr("JSON(*.json) ;; DAT(*.dat)"));
-    if(!(savePathLocation == ""))
-        renderWindow_->sceneManager_->LoadScene(savePathLocation);
+    if(!(savePathLocation == "") && renderWindow_->sceneManager_->LoadScene(savePathLocation))
+        renderWindow_->movementSystem_.ClearCollisionGrid();
     assetWidget->UpdateValues();
     renderWindow_->UpdateMovementSystem();
 }
@@ -569,22 +623,22 @@ void MainWindow::event_componentListItem_Clicked(QListWidgetItem *item)
     if(item->text() == COMPONENT_TYPE_NAMES[TRANSFORM])
     {
         index = 1;
-        transformWidget_->UpdateTransformWidget(renderWindow_->sceneManager_->componentManager_->transformComponents_[ID()]);
+        transformWidget_->UpdateTransformWidget(renderWindow_->sceneManager_->componentManager_->transformComponents_.Get(ID()));
     }
     else if (item->text() == COMPONENT_TYPE_NAMES[MESH]){
         index = 2;
         meshWidget_->UpdateMeshWidget(
-                    renderWindow_->sceneManager_->componentManager_->meshComponents_[ID()]);
+                    renderWindow_->sceneManager_->componentManager_->meshComponents_.Get(ID()));
     }
     else if (item->text() == COMPONENT_TYPE_NAMES[AUDIO])
     {
         index = 3;
-        audioWidget_->UpdateAudioWidget(renderWindow_->sceneManager_->componentManager_->audioComponents_[ID()]);
+        audioWidget_->UpdateAudioWidget(renderWindow_->sceneManager_->componentManager_->audioComponents_.Get(ID()));
     }
     else if (item->text() == COMPONENT_TYPE_NAMES[LIGHT])
     {
         index = 4;
-        lightWidget_->UpdateLightWidget(renderWindow_->sceneManager_->componentManager_->lightComponents_[ID()]);
+        lightWidget_->UpdateLightWidget(renderWindow_->sceneManager_->componentManager_->lightComponents_.Get(ID()));
     }
     else if (item->text() == COMPONENT_TYPE_NAMES[AI])
     {
@@ -600,30 +654,35 @@ void MainWindow::event_componentListItem_Clicked(QListWidgetItem *item)
 
 void MainWindow::event_transformWidget_anyValueChanged()
 {
-    transformWidget_->UpdateTransformComponent(renderWindow_->sceneManager_->componentManager_->transformComponents_[ID()]);
+    transformWidget_->UpdateTransformComponent(renderWindow_->sceneManager_->componentManager_->transformComponents_.Get(ID()));
     renderWindow_->movementSystem_.UpdateTransform(renderWindow_->sceneManager_->entityManager_,renderWindow_->sceneManager_->componentManager_->transformComponents_,ID());
 }
 
 void MainWindow::event_meshWidget_anyValueChanged()
 {
-    meshWidget_->UpdateMeshComponent(renderWindow_->sceneManager_->componentManager_->meshComponents_[ID()]);
-    if(renderWindow_->sceneManager_->componentManager_->meshComponents_[ID()]->objectType_ == ObjectType::PLAYER)
+    MeshComponent* meshComponent = renderWindow_->sceneManager_->componentManager_->meshComponents_.Get(ID());
+    meshWidget_->UpdateMeshComponent(meshComponent);
+    // a new mesh has a new bounding box, which must be moved in the collision grid
+    if (TransformComponent* transform = renderWindow_->sceneManager_->componentManager_->transformComponents_.Get(ID()))
+        transform->hasChanged_ = true;
+    if(meshComponent && meshComponent->objectType_ == ObjectType::PLAYER)
         renderWindow_->sceneManager_->SetActiveEntityToPlayer();
 }
 
 void MainWindow::event_audioWidget_anyValueChanged()
 {
-    audioWidget_->UpdateAudioComponent(renderWindow_->sceneManager_->componentManager_->audioComponents_[ID()],renderWindow_->audioSystem_);
+    audioWidget_->UpdateAudioComponent(renderWindow_->sceneManager_->componentManager_->audioComponents_.Get(ID()),renderWindow_->audioSystem_);
 }
 
 void MainWindow::event_audioWidget_playSound()
 {
-    renderWindow_->audioSystem_->Play(renderWindow_->sceneManager_->componentManager_->audioComponents_[ID()]);
+    if(AudioComponent* audioComponent = renderWindow_->sceneManager_->componentManager_->audioComponents_.Get(ID()))
+        renderWindow_->audioSystem_->Play(audioComponent);
 }
 
 void MainWindow::event_lightWidget_anyValueChanged()
 {
-    lightWidget_->UpdateLightComponent(renderWindow_->sceneManager_->componentManager_->lightComponents_[ID()]);
+    lightWidget_->UpdateLightComponent(renderWindow_->sceneManager_->componentManager_->lightComponents_.Get(ID()));
     renderWindow_->sceneManager_->componentManager_->UpdateShaderLightNumbers();
 }
 
@@ -708,14 +767,14 @@ void MainWindow::LoadComponentsToList()
 {
     componentList_->clear();
 
-    if(renderWindow_->sceneManager_->componentManager_->transformComponents_[ID()])
+    if(renderWindow_->sceneManager_->componentManager_->transformComponents_.Has(ID()))
         componentList_->addItem(COMPONENT_TYPE_NAMES[TRANSFORM]);
-    if(renderWindow_->sceneManager_->componentManager_->meshComponents_[ID()])
+    if(renderWindow_->sceneManager_->componentManager_->meshComponents_.Has(ID()))
         componentList_->addItem(COMPONENT_TYPE_NAMES[MESH]);
-    if(renderWindow_->sceneManager_->componentManager_->audioComponents_[ID()])
+    if(renderWindow_->sceneManager_->componentManager_->audioComponents_.Has(ID()))
         componentList_->addItem(COMPONENT_TYPE_NAMES[AUDIO]);
-    if(renderWindow_->sceneManager_->componentManager_->lightComponents_[ID()])
+    if(renderWindow_->sceneManager_->componentManager_->lightComponents_.Has(ID()))
         componentList_->addItem(COMPONENT_TYPE_NAMES[LIGHT]);
-    if(renderWindow_->sceneManager_->componentManager_->aiComponents_[ID()])
+    if(renderWindow_->sceneManager_->componentManager_->aiComponents_.Has(ID()))
         componentList_->addItem(COMPONENT_TYPE_NAMES[AI]);
 }
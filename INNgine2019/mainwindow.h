@@ -38,6 +38,8 @@ private slots:
 
     // **** World Outliner ****
     void event_entityTreeWidget_itemClicked(QTreeWidgetItem *item);
+    void event_entityTreeWidget_itemChanged(QTreeWidgetItem *item, int column);
+    void event_entityTreeWidget_rowsInserted(const QModelIndex &parent, int first, int last);
     void event_addEntityButton_clicked();
     void event_removeEntityButton_clicked();
     void event_componentListItem_Clicked(QListWidgetItem* item);
@@ -160,6 +162,8 @@ private:
     QLabel* timePerFrame_{nullptr};
     QLabel* verticesDrawn_{nullptr};
     QLabel* EntitiesDrawn_{nullptr};
+    QLabel* stateChanges_{nullptr};
+    QLabel* drawCalls_{nullptr};
     QLabel* FPS_{nullptr};
 
 
@@ -88,6 +88,7 @@ void RenderWindow::initializeGL()
     const qreal retinaScale = devicePixelRatio();
     glViewport(0, 0, static_cast<GLint>(width() * retinaScale), static_cast<GLint>(height() * retinaScale));
     aspectratio_ = static_cast<float>(width()) / height();
+    renderSystem_.viewportHeight_ = static_cast<float>(height() * retinaScale);
 }
 
 void RenderWindow::paintHUD()
@@ -159,6 +160,11 @@ void RenderWindow::paintGL()
 //        sceneManager_->componentManager_->transformComponents_[0]->rotation_relative_.y += 0.1f;
         UpdateMovementSystem();
     }
+    else // keeps children and bounding boxes following edited entities in the editor, only changed transforms are updated
+    {
+        movementSystem_.UpdateTransforms(sceneManager_->entityManager_, sceneManager_->componentManager_->transformComponents_);
+        movementSystem_.UpdateWorldBounds(sceneManager_->componentManager_->meshComponents_, sceneManager_->componentManager_->transformComponents_);
+    }
 
 
     UpdateCameras();
@@ -204,6 +210,8 @@ void RenderWindow::resizeGL(int w, int h)
 {
     QOpenGLWindow::resizeGL(w, h);
     aspectratio_ = static_cast<float>(w) / h;
+    // w and h are in logical pixels, LOD selection needs the framebuffer's height
+    renderSystem_.viewportHeight_ = static_cast<float>(h * devicePixelRatio());
 }
 
 void RenderWindow::toggleTwofacedCulling(bool TwoFacedCullingOn)
@@ -346,7 +354,7 @@ void RenderWindow::HandleInput()
         if(input_.E)
             cameras_[activeCameraID_]->UpdateHeight(cameraSpeed_);
     }
-    else if (sceneManager_->activeEntityID_ < sceneManager_->componentManager_->meshComponents_.size() && sceneManager_->componentManager_->transformComponents_[sceneManager_->activeEntityID_])
+    else if (TransformComponent* activeTransform = sceneManager_->componentManager_->transformComponents_.Get(sceneManager_->activeEntityID_))
     {
 
         gsl::Vector3D forward = cameras_[activeCameraID_]->forwardXZ_;
@@ -369,21 +377,21 @@ void RenderWindow::HandleInput()
         if(moveright != 0 || moveforward != 0 || moveup != 0)
         {
             if(movementSystem_.update_)
-                movementSystem_.AddMovement(sceneManager_->playerEntityID_, ((right * moveright) +  (forward*moveforward)) * 0.015f * AssetManager::GetInstance()->deltaTime_);
+                movementSystem_.AddMovement(sceneManager_->GetPlayerEntityID(), ((right * moveright) +  (forward*moveforward)) * 0.015f * AssetManager::GetInstance()->deltaTime_);
             else
             {
-                sceneManager_->componentManager_->transformComponents_[sceneManager_->activeEntityID_]->position_relative_ += ((gsl::Vector3D(1,0,0) * moveright) + (gsl::Vector3D(0,0,-1)*moveforward) + (gsl::Vector3D(0,1,0) * moveup)) * 0.015f * AssetManager::GetInstance()->deltaTime_;
-                if(sceneManager_->componentManager_->transformComponents_[sceneManager_->activeEntityID_]->followLandscape_)
-                    sceneManager_->componentManager_->transformComponents_[sceneManager_->activeEntityID_]->position_relative_.y =
-                            movementSystem_.FindLandscapeYOnLocation(AssetManager::GetInstance()->landscape_, sceneManager_->componentManager_->transformComponents_[sceneManager_->activeEntityID_]->position_relative_);
+                activeTransform->position_relative_ += ((gsl::Vector3D(1,0,0) * moveright) + (gsl::Vector3D(0,0,-1)*moveforward) + (gsl::Vector3D(0,1,0) * moveup)) * 0.015f * AssetManager::GetInstance()->deltaTime_;
+                if(activeTransform->followLandscape_)
+                    activeTransform->position_relative_.y =
+                            movementSystem_.FindLandscapeYOnLocation(AssetManager::GetInstance()->landscape_, activeTransform->position_relative_);
                 UpdateActiveEntityTransform();
             }
         }
     }
     if(input_.F)
     {
-        if(sceneManager_->componentManager_->transformComponents_[sceneManager_->activeEntityID_])
-            cameras_[activeCameraID_]->FocusOnLocation(sceneManager_->componentManager_->transformComponents_[sceneManager_->activeEntityID_]->position_world_);
+        if(TransformComponent* activeTransform = sceneManager_->componentManager_->transformComponents_.Get(sceneManager_->activeEntityID_))
+            cameras_[activeCameraID_]->FocusOnLocation(activeTransform->position_world_);
         else
             qDebug() << "ERROR: nothing to focus on!";
     }
@@ -391,25 +399,29 @@ void RenderWindow::HandleInput()
 
 void RenderWindow::HandleEvents()
 {
-    std::vector<unsigned int> events = AssetManager::GetInstance()->events_;
-    AssetManager::GetInstance()->events_.clear();
-    for(unsigned int eventID : events)
+    std::vector<GameEvent> events;
+    events.swap(AssetManager::GetInstance()->events_);
+    for(const GameEvent& event : events)
     {
-        qDebug() << "Event: " << eventID;
-        if (eventID == 0) // death
+        qDebug() << "Event: " << event.type << " EntityID: " << event.entity.index;
+        if (event.type == PLAYER_DEATH)
         {
             sceneManager_->ResetScene();
             sceneManager_->roundsCleared_ = 0;
             gameTimer_.start();
         }
         // if the event is on a trophy, remove trophy and control point from each enemy
-        else if (sceneManager_->componentManager_->meshComponents_[eventID]->objectType_ == TROPHY)
+        else if (event.type == TROPHY_CAUGHT && sceneManager_->entityManager_->IsAlive(event.entity))
         {
-            sceneManager_->componentManager_->meshComponents_[eventID]->objectType_ = TAKEN_TROPHY;
+            MeshComponent* trophyMesh = sceneManager_->componentManager_->meshComponents_.Get(event.entity.index);
+            if (!trophyMesh || trophyMesh->objectType_ != TROPHY)
+                continue;
+
+            trophyMesh->objectType_ = TAKEN_TROPHY;
             sceneManager_->UpdateAIsBasedOnThropies();
-            movementSystem_.caughtTrophies_.push_back(eventID);
-            if(sceneManager_->componentManager_->audioComponents_[eventID])
-                audioSystem_->Play(sceneManager_->componentManager_->audioComponents_[eventID]);
+            movementSystem_.caughtTrophies_.push_back(event.entity);
+            if(AudioComponent* trophyAudio = sceneManager_->componentManager_->audioComponents_.Get(event.entity.index))
+                audioSystem_->Play(trophyAudio);
 
         }
     }
@@ -424,15 +436,16 @@ void RenderWindow::UpdateCameras()
         cameras_[i]->projectionMatrix_ = newprojection;
         if(cameras_[i]->thirdPersonCamera_)
         {
-            if(!sceneManager_->componentManager_->transformComponents_[sceneManager_->playerEntityID_])
+            TransformComponent* playerTransform = sceneManager_->componentManager_->transformComponents_.Get(sceneManager_->GetPlayerEntityID());
+            if(!playerTransform)
                 continue;
-            cameras_[i]->Update(sceneManager_->componentManager_->transformComponents_[sceneManager_->playerEntityID_]);
+            cameras_[i]->Update(playerTransform);
         }
         else
             cameras_[i]->Update();
         if(i == activeCameraID_)
             continue;
-        movementSystem_.UpdateTransformMatrix(cameras_[i]->CameraTransform_);
+        movementSystem_.UpdateTransformMatrix(cameras_[i]->CameraTransform_.get());
     }
 }
 
@@ -610,29 +623,57 @@ void RenderWindow::MousePicking(QMouseEvent* event)
     gsl::Vector3D ray_world = (inverseViewMatrix * ray_eye).toVector3D();
     ray_world.normalize();
 
-    for (size_t i = 0; i < sceneManager_->componentManager_->transformComponents_.size(); i++)
+    gsl::Vector3D rayOrigin = cameras_[activeCameraID_]->position_;
+    size_t closestEntityID = gsl::INVALID_SIZE;
+    float closestDistance = HUGE_VALF;
+
+    // entities with a mesh are hit through their cached world space bounding box
+    ComponentPool<MeshComponent>& meshComponents = sceneManager_->componentManager_->meshComponents_;
+    for (size_t slot = 0; slot < meshComponents.size(); slot++)
     {
+        const MeshComponent& mesh = meshComponents[slot];
+        float distance;
+        if (mesh.hasWorldBounds_ && gsl::rayIntersectsAABB(rayOrigin, ray_world, mesh.worldMin_, mesh.worldMax_, distance)
+                && distance < closestDistance)
+        {
+            closestDistance = distance;
+            closestEntityID = meshComponents.EntityAt(slot);
+        }
+    }
 
-        if(!sceneManager_->componentManager_->transformComponents_[i])
+    // other entities are hit within a radius of their position
+    ComponentPool<TransformComponent>& transformComponents = sceneManager_->componentManager_->transformComponents_;
+    for (size_t slot = 0; slot < transformComponents.size(); slot++)
+    {
+        const MeshComponent* mesh = meshComponents.Get(transformComponents.EntityAt(slot));
+        if (mesh && mesh->hasWorldBounds_)
             continue;
 
+        gsl::Vector3D cameraToEntity = rayOrigin - transformComponents[slot].position_world_;
+
         float radius = 1;
 
         // b = D . (O - C)
-        float b = gsl::Vector3D::dot(ray_world, cameras_[activeCameraID_]->position_ - sceneManager_->componentManager_->transformComponents_[i]->position_world_);
+        float b = gsl::Vector3D::dot(ray_world, cameraToEntity);
         // c = (O - C) . (O - C) - r^2
-        float c = gsl::Vector3D::dot(cameras_[activeCameraID_]->position_ - sceneManager_->componentManager_->transformComponents_[i]->position_world_, cameras_[activeCameraID_]->position_ - sceneManager_->componentManager_->transformComponents_[i]->position_world_) - std::sqrt(radius);
+        float c = gsl::Vector3D::dot(cameraToEntity, cameraToEntity) - radius*radius;
 
-        float test = static_cast<float>(std::pow(b, 2)) - c;
+        float test = b*b - c;
 
-        if(test > 0)
+        if(test > 0 && -b >= 0 && -b < closestDistance)
         {
-            sceneManager_->activeEntityID_ = i;
-            sceneManager_->entityManager_->SelectEntityInTree(sceneManager_->activeEntityID_);
-            mainWindow_->renderWindowContainer_->setFocus();
-            mainWindow_->LoadComponentsToList();
+            closestDistance = -b;
+            closestEntityID = transformComponents.EntityAt(slot);
         }
     }
+
+    if (closestEntityID != gsl::INVALID_SIZE)
+    {
+        sceneManager_->activeEntityID_ = closestEntityID;
+        sceneManager_->entityManager_->SelectEntityInTree(sceneManager_->activeEntityID_);
+        mainWindow_->renderWindowContainer_->setFocus();
+        mainWindow_->LoadComponentsToList();
+    }
 }
 
 void RenderWindow::UpdateMovementSystem()
@@ -643,15 +684,17 @@ void RenderWindow::UpdateMovementSystem()
                            sceneManager_->componentManager_->aiComponents_,
                            AssetManager::GetInstance()->landscape_,
                            sceneManager_->componentManager_->lightComponents_,
-                           sceneManager_->playerEntityID_);
+                           sceneManager_->GetPlayerEntityID());
 }
 
 void RenderWindow::UpdateActiveEntityTransform()
 {
+    if(TransformComponent* activeTransform = sceneManager_->componentManager_->transformComponents_.Get(sceneManager_->activeEntityID_))
+        activeTransform->hasChanged_ = true;
     movementSystem_.UpdateTransform(sceneManager_->entityManager_,
                                     sceneManager_->componentManager_->transformComponents_,
                                     sceneManager_->activeEntityID_);
-    mainWindow_->transformWidget_->UpdateTransformWidget(sceneManager_->componentManager_->transformComponents_[sceneManager_->activeEntityID_]);
+    mainWindow_->transformWidget_->UpdateTransformWidget(sceneManager_->componentManager_->transformComponents_.Get(sceneManager_->activeEntityID_));
 }
 
 void RenderWindow::mousePressEvent(QMouseEvent *event)
@@ -707,22 +750,22 @@ void RenderWindow::mouseMoveEvent(QMouseEvent *event)
         if (mouseYlast_ != 0)
             cameras_[activeCameraID_]->Pitch(cameraRotateSpeed_ * mouseYlast_);
     }
-    if(sceneManager_->componentManager_->transformComponents_[sceneManager_->activeEntityID_])
+    if(TransformComponent* activeTransform = sceneManager_->componentManager_->transformComponents_.Get(sceneManager_->activeEntityID_))
     {
         bool changed = false;
         if(input_.Z)
         {
-            sceneManager_->componentManager_->transformComponents_[sceneManager_->activeEntityID_]->rotation_relative_.z += static_cast<float>(mouseXlast_);
+            activeTransform->rotation_relative_.z += static_cast<float>(mouseXlast_);
             changed = true;
         }
         if(input_.X)
         {
-            sceneManager_->componentManager_->transformComponents_[sceneManager_->activeEntityID_]->rotation_relative_.x += static_cast<float>(mouseXlast_);
+            activeTransform->rotation_relative_.x += static_cast<float>(mouseXlast_);
             changed = true;
         }
         if(input_.C)
         {
-            sceneManager_->componentManager_->transformComponents_[sceneManager_->activeEntityID_]->rotation_relative_.y += static_cast<float>(mouseXlast_);
+            activeTransform->rotation_relative_.y += static_cast<float>(mouseXlast_);
             changed = true;
         }
         if(changed)
@@ -0,0 +1,10 @@
+include(../../engine.pri)
+
+QT          += testlib
+CONFIG      += testcase console
+CONFIG      -= app_bundle
+
+TEMPLATE    = app
+TARGET      = tst_scenemanager
+
+SOURCES += tst_scenemanager.cpp
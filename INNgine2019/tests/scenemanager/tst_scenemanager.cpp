@@ -0,0 +1,100 @@
+#include <QtTest>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include "Managers/scenemanager.h"
+#include "Systems/movementsystem.h"
+
+/// Checks that the scene keeps a usable player after a scene is loaded on top of another.
+class TestSceneManager : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void playerMovesAfterLoad();
+
+private:
+    QOffscreenSurface surface_;
+    QOpenGLContext context_;
+};
+
+namespace
+{
+/**
+ * Makes a scene like the ones saved by SceneManager::write, without assets.
+ * @param playerID Index of the entity with the player mesh.
+ * @param entityCount Number of entities, each with a transform and a mesh.
+ */
+QJsonObject MakeScene(size_t playerID, size_t entityCount)
+{
+    QJsonArray entities;
+    for (size_t entityID = 0; entityID < entityCount; entityID++)
+    {
+        QJsonObject entityInfo;
+        entityInfo["entityID"] = static_cast<int>(entityID);
+        entityInfo["entityName"] = entityID == playerID ? "Player" : "Entity";
+        entityInfo["parentID"] = static_cast<int>(gsl::INVALID_SIZE);
+        entityInfo["visible"] = true;
+
+        QJsonObject transform;
+        transform["position_relative"] = gsl::Vector3D(static_cast<float>(entityID) * 10.f, 0, 0).ToQJsonArray();
+        transform["rotation_relative"] = gsl::Vector3D(0, 0, 0).ToQJsonArray();
+        transform["scale_relative"] = gsl::Vector3D(1, 1, 1).ToQJsonArray();
+
+        QJsonObject mesh;
+        mesh["objectType"] = entityID == playerID ? PLAYER : DEFAULT;
+
+        QJsonObject components;
+        components[COMPONENT_TYPE_NAMES[TRANSFORM]] = transform;
+        components[COMPONENT_TYPE_NAMES[MESH]] = mesh;
+
+        QJsonObject entity;
+        entity["1_ENTITY_INFO"] = entityInfo;
+        entity["2_COMPONENTS"] = components;
+        entities.append(entity);
+    }
+    QJsonObject scene;
+    scene["entites"] = entities;
+    return scene;
+}
+}
+
+void TestSceneManager::initTestCase()
+{
+    // the asset paths in constants.h go up a folder and back into the project folder, so they work from there
+    QVERIFY(QDir::setCurrent(ENGINE_SOURCE_DIR));
+
+    // the asset manager loads meshes and shaders the first time it is used, which needs a current context
+    QSurfaceFormat format;
+    format.setVersion(4, 1);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+    surface_.setFormat(format);
+    surface_.create();
+    context_.setFormat(format);
+    QVERIFY(context_.create());
+    QVERIFY(context_.makeCurrent(&surface_));
+}
+
+void TestSceneManager::playerMovesAfterLoad()
+{
+    SceneManager sceneManager(nullptr);
+    MovementSystem movementSystem;
+
+    // the second read replaces the entities of the first, like loading a scene while one is open
+    sceneManager.read(MakeScene(1, 3));
+    sceneManager.read(MakeScene(2, 3));
+
+    size_t playerID = sceneManager.GetPlayerEntityID();
+    QCOMPARE(playerID, static_cast<size_t>(2));
+
+    std::shared_ptr<ComponentManager> components = sceneManager.componentManager_;
+    float startX = components->transformComponents_.Get(playerID)->position_relative_.x;
+    movementSystem.AddMovement(playerID, gsl::Vector3D(1, 0, 0));
+    movementSystem.UpdateMovement(sceneManager.entityManager_, components->transformComponents_,
+                                  components->meshComponents_, components->aiComponents_, nullptr);
+    QCOMPARE(components->transformComponents_.Get(playerID)->position_relative_.x, startX + 1.f);
+}
+
+QTEST_MAIN(TestSceneManager)
+
+#include "tst_scenemanager.moc"